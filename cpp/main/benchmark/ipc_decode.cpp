@@ -0,0 +1,144 @@
+// IPC 断点变量解码的基准测试
+// 构造 5000 个状态的 LR(1) 快照并编码为 CBOR，比较 DOM 解码、流式解码
+// 与并行流式解码的耗时
+// 快照中的符号与服务端一致，以会话符号表中的编号表示
+// 构建：cmake -DBUILD_BENCHMARKS=ON，运行 ipc_decode [状态数] [轮数]
+#include "ipc/codec.h"
+#include "synthetic.h"
+#include <QCborStreamWriter>
+#include <QCborValue>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+
+static QByteArray makeSnapshot(int states) {
+	QCborMap data;
+	data[QString("base")] = 0;
+	data[QString("seq")] = 1;
+	data[QString("var")] = synthetic::LRVariables(states, true);
+	return QCborValue(data).toCbor();
+}
+
+// 与 DecodeResponse 中的旧路径一致：先构建 QCborValue，再转换为 QJsonObject
+static void decodeDom(const QByteArray &bytes,
+					  ipc::LR1BreakpointVariables *out) {
+	auto object = QCborValue::fromCbor(bytes).toMap().toJsonObject();
+	ipc::DecodeJson(object["var"], out);
+}
+
+static void decodeStream(const QByteArray &bytes,
+						 ipc::LR1BreakpointVariables *out) {
+	QCborStreamReader reader(bytes);
+	reader.enterContainer();
+	while (reader.hasNext()) {
+		if (ipc::streamString(reader) == "var") {
+			ipc::DecodeCbor(reader, out);
+		} else {
+			reader.next();
+		}
+	}
+	reader.leaveContainer();
+}
+
+// 闭包与分析表拆分到线程池中解码
+static void decodeParallel(const QByteArray &bytes,
+						   ipc::LR1BreakpointVariables *out) {
+	ipc::ParallelDecode parallel(bytes);
+	decodeStream(bytes, out);
+}
+
+// 以 codec.h 的编码器重新编码，用于检查编码与解码互逆
+static QByteArray
+encodeSnapshot(const ipc::LR1BreakpointVariables &variables) {
+	QByteArray bytes;
+	QCborStreamWriter writer(&bytes);
+	writer.startMap(1);
+	writer.append(QLatin1String("var"));
+	ipc::EncodeCbor(writer, variables);
+	writer.endMap();
+	return bytes;
+}
+
+static bool sameVariables(const ipc::LR1BreakpointVariables &a,
+						  const ipc::LR1BreakpointVariables &b) {
+	if (a.closureMap.closures.size() != b.closureMap.closures.size() ||
+		a.closureMap.edges.size() != b.closureMap.edges.size() ||
+		a.actionTable != b.actionTable || a.gotoTable != b.gotoTable ||
+		a.productions != b.productions || a.terminals != b.terminals) {
+		return false;
+	}
+	for (int i = 0; i < a.closureMap.closures.size(); i++) {
+		auto &x = a.closureMap.closures[i];
+		auto &y = b.closureMap.closures[i];
+		if (x.size() != y.size()) {
+			return false;
+		}
+		for (int j = 0; j < x.size(); j++) {
+			if (x[j].production != y[j].production ||
+				x[j].progress != y[j].progress ||
+				x[j].lookahead != y[j].lookahead) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// 多轮运行取中位数，单位毫秒
+static double measure(const QByteArray &bytes, int rounds,
+					  void (*decode)(const QByteArray &,
+									 ipc::LR1BreakpointVariables *)) {
+	QList<double> times;
+	for (int i = 0; i < rounds; i++) {
+		ipc::LR1BreakpointVariables variables{};
+		QElapsedTimer timer;
+		timer.start();
+		decode(bytes, &variables);
+		times.append(timer.nsecsElapsed() / 1e6);
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+int main(int argc, char *argv[]) {
+	QCoreApplication app(argc, argv);
+	auto args = app.arguments();
+	int states = args.size() > 1 ? args[1].toInt() : 5000;
+	int rounds = args.size() > 2 ? args[2].toInt() : 20;
+	QTextStream out(stdout);
+
+	auto bytes = makeSnapshot(states);
+	ipc::LR1BreakpointVariables dom{}, stream{}, parallel{};
+	decodeDom(bytes, &dom);
+	decodeStream(bytes, &stream);
+	decodeParallel(bytes, &parallel);
+	if (!sameVariables(dom, stream) || !sameVariables(stream, parallel)) {
+		out << "decoders disagree\n";
+		return 1;
+	}
+	ipc::LR1BreakpointVariables encoded{};
+	decodeStream(encodeSnapshot(stream), &encoded);
+	if (!sameVariables(stream, encoded)) {
+		out << "encoder and decoder disagree\n";
+		return 1;
+	}
+
+	auto domTime = measure(bytes, rounds, decodeDom);
+	auto streamTime = measure(bytes, rounds, decodeStream);
+	auto parallelTime = measure(bytes, rounds, decodeParallel);
+	out << QString("states %1, payload %2 KiB, %3 rounds\n")
+			   .arg(states)
+			   .arg(bytes.size() / 1024)
+			   .arg(rounds);
+	out << QString("dom    %1 ms\n").arg(domTime, 0, 'f', 2);
+	out << QString("stream %1 ms (%2x)\n")
+			   .arg(streamTime, 0, 'f', 2)
+			   .arg(domTime / streamTime, 0, 'f', 2);
+	out << QString("parallel %1 ms (%2x, %3 threads)\n")
+			   .arg(parallelTime, 0, 'f', 2)
+			   .arg(domTime / parallelTime, 0, 'f', 2)
+			   .arg(QThread::idealThreadCount());
+	return 0;
+}
@@ -0,0 +1,518 @@
+// 替身后端：代替 Go 后端启动并服务 main，用于可复现负载下的性能分析与回归测试
+// 与 Go 后端相同，以子进程启动客户端，经客户端的 stdin/stdout 通信
+// 用法：
+//   standin_backend replay <记录文件> [--realtime] [-- 客户端 参数...]
+//     按 action 依次回放 IPC_RECORD 记录的响应，并在对应响应之后推送记录中的
+//     事件；--realtime 时按记录中的往返时间延迟响应
+//   standin_backend synth <状态数> [-- 客户端 参数...]
+//     为 LR 会话合成指定状态数的断点变量，切换运行模式后立即暂停，
+//     其余请求返回空结果；LL 会话没有断点变量
+// 客户端默认为 PATH 中的 main；无显示器时设置 QT_QPA_PLATFORM=offscreen，例如
+//   standin_backend synth 20000 -- main --demo lr1 grammar.txt
+// --duration 毫秒：到时后结束客户端，便于无人值守运行
+// 构建：cmake -DBUILD_BENCHMARKS=ON
+#include "ipc/record.h"
+#include "ipc/types.h"
+#include "synthetic.h"
+#include <QCborValue>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QQueue>
+#include <QTextStream>
+#include <QtEndian>
+#include <memory>
+
+static QTextStream err(stderr);
+
+// 一次请求的回复：响应之后推送 events，delay 毫秒后发送
+struct Reply {
+	int code = 0;
+	QCborValue data = QCborMap();
+	QList<QCborMap> events;
+	qint64 delay = 0;
+};
+
+static QCborMap makeEvent(const QString &event, const QString &id) {
+	QCborMap data;
+	data[QString("id")] = id;
+	QCborMap msg;
+	msg[QString("event")] = event;
+	msg[QString("data")] = data;
+	return msg;
+}
+
+class Backend {
+public:
+	virtual ~Backend() = default;
+	virtual Reply Call(const QString &action, const QCborMap &data) = 0;
+	// 协商完成后立即推送的事件
+	virtual QList<QCborMap> InitialEvents() {
+		return {};
+	}
+};
+
+// 回放记录：每个 action 的响应按记录顺序排队，用完后重复最后一个
+// 会话 id 等均为记录中的值，客户端原样带回即可匹配
+class ReplayBackend : public Backend {
+public:
+	ReplayBackend(bool realtime) : realtime(realtime) {
+	}
+
+	bool Load(const QString &path) {
+		QFile file(path);
+		if (!file.open(QIODevice::ReadOnly)) {
+			err << "standin: cannot open " << path << "\n";
+			return false;
+		}
+		auto header = QJsonDocument::fromJson(file.readLine()).object();
+		if (header["version"].toInt() != ipc::RecordingVersion) {
+			err << "standin: unsupported recording " << path << "\n";
+			return false;
+		}
+		QHash<qint64, QString> actions;
+		QHash<qint64, qint64> sent;
+		// 事件附在之前最近的响应之后，该响应总是所在队列的最后一个
+		QString last;
+		while (!file.atEnd()) {
+			auto line = file.readLine().trimmed();
+			if (line.isEmpty()) {
+				continue;
+			}
+			auto record = QJsonDocument::fromJson(line).object();
+			auto kind = record["kind"].toString();
+			auto msg = record["msg"].toObject();
+			auto t = record["t"].toInteger();
+			auto id = msg["id"].toInteger();
+			if (kind == "request") {
+				actions[id] = msg["action"].toString();
+				sent[id] = t;
+			} else if (kind == "response" && actions.contains(id)) {
+				Reply reply;
+				reply.code = msg["code"].toInt();
+				reply.data = QCborValue::fromJsonValue(msg["data"]);
+				reply.delay = (t - sent[id]) / 1000000;
+				last = actions[id];
+				replies[last].append(reply);
+			} else if (kind == "event") {
+				auto event = QCborValue::fromJsonValue(msg).toMap();
+				if (!last.isEmpty()) {
+					replies[last].last().events.append(event);
+				} else {
+					initialEvents.append(event);
+				}
+			}
+		}
+		return true;
+	}
+
+	Reply Call(const QString &action, const QCborMap &) override {
+		auto &queue = replies[action];
+		if (queue.isEmpty()) {
+			Reply reply;
+			reply.code = 500;
+			err << "standin: no recorded response for " << action << "\n";
+			return reply;
+		}
+		Reply reply;
+		if (queue.size() > 1) {
+			reply = queue.takeFirst();
+		} else {
+			// 重复最后一个响应时不再推送其后的事件
+			reply = queue.first();
+			queue.first().events.clear();
+		}
+		if (!realtime) {
+			reply.delay = 0;
+		}
+		return reply;
+	}
+
+	QList<QCborMap> InitialEvents() override {
+		return initialEvents;
+	}
+
+private:
+	bool realtime;
+	QHash<QString, QList<Reply>> replies;
+	QList<QCborMap> initialEvents;
+};
+
+// 合成负载：LR 断点变量为指定状态数的完整快照，只构造一次
+class SyntheticBackend : public Backend {
+public:
+	SyntheticBackend(int states) : states(states) {
+	}
+
+	Reply Call(const QString &action, const QCborMap &data) override {
+		Reply reply;
+		auto id = data[QString("id")].toString();
+		auto prefix = action.section('_', 0, 0);
+		auto name = action.section('_', 1);
+		if (action == "batch") {
+			return batch(data);
+		} else if (action == "production_parse_start") {
+			auto parseId = QString("parse-%1").arg(++sessions);
+			reply.data = idData(parseId);
+			reply.events << makeEvent("production_parse_finished", parseId);
+		} else if (action == "production_parse_query") {
+			reply.data = productionResult();
+		} else if (name == "process_request") {
+			reply.data = idData(QString("%1-%2").arg(prefix).arg(++sessions));
+		} else if (name == "process_switchmode") {
+			auto mode = data[QString("mode")].toInteger();
+			reply.events << makeEvent(mode == ipc::ProcessModeExit
+										  ? "process_exited"
+										  : "process_paused",
+									  id);
+		} else if (name == "process_variables" && prefix != "ll") {
+			reply.data = variables(prefix == "lr1", data);
+		} else if (name == "process_variables" || name == "process_exit") {
+			// 没有可用的断点变量或会话尚未结束
+			reply.code = name == "process_exit" ? 1004 : 1003;
+		} else if (name != "process_release" &&
+				   name != "process_setbreakpoints" &&
+				   action != "production_parse_cancel") {
+			reply.code = 500;
+			err << "standin: unsupported action " << action << "\n";
+		}
+		return reply;
+	}
+
+private:
+	static QCborMap idData(const QString &id) {
+		QCborMap data;
+		data[QString("id")] = id;
+		return data;
+	}
+
+	// 与服务端相同：依次执行子请求，id_from 引用之前子请求返回的 id
+	Reply batch(const QCborMap &data) {
+		Reply reply;
+		QList<Reply> subs;
+		QCborArray results;
+		for (auto value : data[QString("requests")].toArray()) {
+			auto request = value.toMap();
+			auto subData = request[QString("data")].toMap();
+			auto from = request[QString("id_from")];
+			if (from.isInteger()) {
+				auto source = subs.value(from.toInteger()).data.toMap();
+				subData[QString("id")] = source[QString("id")];
+			}
+			auto sub = Call(request[QString("action")].toString(), subData);
+			QCborMap result;
+			result[QString("code")] = sub.code;
+			result[QString("data")] = sub.data;
+			results.append(result);
+			reply.events << sub.events;
+			subs << sub;
+		}
+		QCborMap res;
+		res[QString("results")] = results;
+		reply.data = res;
+		return reply;
+	}
+
+	QCborMap productionResult() {
+		auto symbols = synthetic::Symbols();
+		QCborArray terminals, nonterminals;
+		for (int i = 0; i < symbols.size(); i++) {
+			(i < synthetic::Terminals ? terminals : nonterminals)
+				.append(symbols.at(i));
+		}
+		auto lr = synthetic::LRVariables(1, false);
+		QCborMap errors;
+		errors[QString("fatal")] = QCborArray();
+		errors[QString("error")] = QCborArray();
+		errors[QString("warning")] = QCborArray();
+		QCborMap data;
+		data[QString("terminal")] = terminals;
+		data[QString("nonterminal")] = nonterminals;
+		data[QString("productions")] = lr[QString("productions")];
+		data[QString("errors")] = errors;
+		return data;
+	}
+
+	// 总是发送完整快照（base 为 0），客户端据此替换缓存
+	// 与服务端一致按键名顺序写入，客户端流式解码时先读到 base
+	QCborMap variables(bool lookahead, const QCborMap &request) {
+		auto &cached = lookahead ? lr1Variables : lr0Variables;
+		if (cached.isEmpty()) {
+			cached = synthetic::LRVariables(states, lookahead);
+		}
+		QCborMap point;
+		point[QString("name")] = QString("synthetic");
+		point[QString("line")] = 0;
+		QCborMap data;
+		data[QString("base")] = 0;
+		data[QString("point")] = point;
+		data[QString("seq")] = ++seq;
+		auto known = request[QString("symbols")];
+		if (known.isInteger()) {
+			auto symbols = synthetic::Symbols();
+			QCborArray since;
+			for (auto i = known.toInteger(); i < symbols.size(); i++) {
+				since.append(symbols.at(i));
+			}
+			data[QString("symbols")] = since;
+		}
+		data[QString("var")] = cached;
+		return data;
+	}
+
+	int states;
+	int sessions = 0;
+	qint64 seq = 0;
+	QCborMap lr0Variables, lr1Variables;
+};
+
+// 与客户端的连接：先以按行 JSON 协商，之后为 4 字节大端序长度前缀的帧
+class Connection {
+public:
+	Connection(QProcess *client, Backend *backend)
+		: client(client), backend(backend) {
+		clock.start();
+	}
+
+	// 读取并处理可用的消息，返回 false 表示客户端已退出
+	bool Poll(int timeout) {
+		flush();
+		if (!pending.isEmpty()) {
+			timeout = qBound<qint64>(0, pending.head().due - clock.elapsed(),
+									 timeout);
+		}
+		if (client->state() == QProcess::NotRunning) {
+			return false;
+		}
+		client->waitForReadyRead(timeout);
+		buffer.append(client->readAllStandardOutput());
+		QByteArray msg;
+		while (takeMessage(&msg)) {
+			handle(msg);
+		}
+		flush();
+		return true;
+	}
+
+	qint64 Requests() const {
+		return requests;
+	}
+	qint64 BytesSent() const {
+		return bytesSent;
+	}
+
+private:
+	// 与 Go 后端相同：超过阈值的帧压缩，头部最高位为压缩标记
+	static constexpr int compressThreshold = 8 << 10;
+	static constexpr quint32 compressedFlag = 1u << 31;
+
+	struct Outgoing {
+		qint64 due;
+		QByteArray bytes;
+	};
+
+	bool takeMessage(QByteArray *msg) {
+		if (!framed) {
+			auto end = buffer.indexOf('\n');
+			if (end < 0) {
+				return false;
+			}
+			*msg = buffer.left(end).trimmed();
+			buffer.remove(0, end + 1);
+			return true;
+		}
+		if (buffer.size() < 4) {
+			return false;
+		}
+		auto length = qFromBigEndian<quint32>(buffer.constData());
+		if (buffer.size() < 4 + qint64(length)) {
+			return false;
+		}
+		*msg = buffer.mid(4, length);
+		buffer.remove(0, 4 + length);
+		return true;
+	}
+
+	void handle(const QByteArray &msg) {
+		if (msg.isEmpty()) {
+			return;
+		}
+		QCborMap req;
+		if (cbor) {
+			req = QCborValue::fromCbor(msg).toMap();
+		} else {
+			auto object = QJsonDocument::fromJson(msg).object();
+			req = QCborMap::fromJsonObject(object);
+		}
+		auto action = req[QString("action")].toString();
+		if (!negotiated) {
+			negotiated = true;
+			if (action == "ipc_negotiate") {
+				negotiate(req[QString("data")].toMap());
+				return;
+			}
+		}
+		// 替身后端没有排队中的请求，取消消息无需处理
+		if (action == "ipc_cancel") {
+			return;
+		}
+		requests++;
+		auto reply = backend->Call(action, req[QString("data")].toMap());
+		QCborMap resp;
+		if (req.contains(QString("id"))) {
+			resp[QString("id")] = req[QString("id")];
+		}
+		resp[QString("code")] = reply.code;
+		resp[QString("data")] = reply.data;
+		auto due = clock.elapsed() + reply.delay;
+		send(resp, due);
+		for (auto &event : reply.events) {
+			send(event, due);
+		}
+	}
+
+	// 只支持帧传输，不映射客户端的共享内存；客户端支持时与 Go 后端一样压缩
+	void negotiate(const QCborMap &request) {
+		auto offered = request[QString("compression")].toArray();
+		compress = offered.contains(QString("zlib"));
+		QJsonObject data;
+		data["framed"] = true;
+		data["encoding"] = "cbor";
+		data["shm"] = false;
+		data["compression"] = compress ? "zlib" : "";
+		QJsonObject resp;
+		resp["code"] = 0;
+		resp["data"] = data;
+		write(QJsonDocument(resp).toJson(QJsonDocument::Compact) + "\n");
+		framed = true;
+		cbor = true;
+		for (auto &event : backend->InitialEvents()) {
+			send(event, 0);
+		}
+	}
+
+	// 按到期时间插入，同时到期的消息保持发送顺序
+	void send(const QCborMap &msg, qint64 due) {
+		QByteArray bytes;
+		if (cbor) {
+			bytes = msg.toCborValue().toCbor();
+		} else {
+			bytes = QJsonDocument(msg.toJsonObject()).toJson(
+				QJsonDocument::Compact);
+		}
+		if (framed) {
+			quint32 length = bytes.size();
+			if (compress && bytes.size() >= compressThreshold) {
+				auto packed = qCompress(bytes, 1);
+				if (packed.size() < bytes.size()) {
+					bytes = packed;
+					length = bytes.size() | compressedFlag;
+				}
+			}
+			char header[4];
+			qToBigEndian<quint32>(length, header);
+			bytes.prepend(header, 4);
+		} else {
+			bytes.append('\n');
+		}
+		auto it = pending.begin();
+		while (it != pending.end() && it->due <= due) {
+			++it;
+		}
+		pending.insert(it, {due, bytes});
+	}
+
+	void flush() {
+		while (!pending.isEmpty() && pending.head().due <= clock.elapsed()) {
+			write(pending.dequeue().bytes);
+		}
+	}
+
+	void write(const QByteArray &bytes) {
+		client->write(bytes);
+		client->waitForBytesWritten(-1);
+		bytesSent += bytes.size();
+	}
+
+	QProcess *client;
+	Backend *backend;
+	QElapsedTimer clock;
+	QByteArray buffer;
+	QQueue<Outgoing> pending;
+	bool negotiated = false;
+	bool framed = false;
+	bool cbor = false;
+	bool compress = false;
+	qint64 requests = 0;
+	qint64 bytesSent = 0;
+};
+
+int main(int argc, char *argv[]) {
+	QCoreApplication app(argc, argv);
+	QCommandLineParser parser;
+	parser.setApplicationDescription("IPC stand-in backend");
+	parser.addHelpOption();
+	QCommandLineOption realtime("realtime", "按记录的往返时间延迟响应");
+	QCommandLineOption duration("duration", "到时后结束客户端（毫秒）",
+								"ms");
+	parser.addOption(realtime);
+	parser.addOption(duration);
+	parser.addPositionalArgument("mode", "replay <记录文件> | synth <状态数>");
+	parser.addPositionalArgument("client", "客户端及其参数，默认为 main",
+								 "[-- client args...]");
+	parser.process(app);
+	auto args = parser.positionalArguments();
+	if (args.size() < 2) {
+		parser.showHelp(1);
+	}
+
+	std::unique_ptr<Backend> backend;
+	if (args[0] == "replay") {
+		auto replay = new ReplayBackend(parser.isSet(realtime));
+		backend.reset(replay);
+		if (!replay->Load(args[1])) {
+			return 1;
+		}
+	} else if (args[0] == "synth") {
+		backend.reset(new SyntheticBackend(args[1].toInt()));
+	} else {
+		parser.showHelp(1);
+	}
+
+	auto program = args.size() > 2 ? args[2] : QString("main");
+	QProcess client;
+	client.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	client.start(program, args.mid(3));
+	if (!client.waitForStarted()) {
+		err << "standin: cannot start " << program << ": "
+			<< client.errorString() << "\n";
+		return 1;
+	}
+
+	Connection connection(&client, backend.get());
+	QDeadlineTimer deadline(QDeadlineTimer::Forever);
+	if (parser.isSet(duration)) {
+		deadline.setRemainingTime(parser.value(duration).toLongLong());
+	}
+	while (connection.Poll(100)) {
+		if (deadline.hasExpired()) {
+			client.terminate();
+			if (!client.waitForFinished(3000)) {
+				client.kill();
+			}
+			break;
+		}
+	}
+	client.waitForFinished(-1);
+	err << QString("standin: %1 requests, %2 KiB sent\n")
+			   .arg(connection.Requests())
+			   .arg(connection.BytesSent() / 1024);
+	return client.exitStatus() == QProcess::NormalExit ? client.exitCode()
+													  : 1;
+}
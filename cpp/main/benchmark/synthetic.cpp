@@ -0,0 +1,82 @@
+#include "synthetic.h"
+#include <QString>
+
+static QString symbol(const char *prefix, int i) {
+	return QString("%1%2").arg(prefix).arg(i);
+}
+
+QCborArray synthetic::Symbols() {
+	QCborArray symbols;
+	for (int i = 0; i < Terminals; i++) {
+		symbols.append(symbol("t", i));
+	}
+	for (int i = 0; i < Nonterminals; i++) {
+		symbols.append(symbol("N", i));
+	}
+	return symbols;
+}
+
+QCborMap synthetic::LRVariables(int states, bool lookahead) {
+	QCborArray terminalList;
+	for (int i = 0; i < Terminals; i++) {
+		terminalList.append(symbol("t", i));
+	}
+	QCborArray productionList;
+	for (int i = 0; i < Productions; i++) {
+		QCborArray production;
+		production.append(symbol("N", i % Nonterminals));
+		for (int j = 0; j < 3; j++) {
+			production.append(symbol("t", (i + j) % Terminals));
+		}
+		productionList.append(production);
+	}
+
+	QCborArray closures, edges, actionTable, gotoTable;
+	for (int i = 0; i < states; i++) {
+		QCborArray closure;
+		for (int j = 0; j < 6; j++) {
+			QCborMap item;
+			item[QString("prod")] = (i + j) % Productions;
+			item[QString("progress")] = j % 4;
+			if (lookahead) {
+				item[QString("lookahead")] = (i * 7 + j) % Terminals;
+			}
+			closure.append(item);
+		}
+		closures.append(closure);
+		for (int j = 1; j <= 2; j++) {
+			QCborMap edge;
+			edge[QString("from")] = i;
+			edge[QString("to")] = (i + j) % states;
+			edge[QString("symbol")] = (i + j) % Terminals;
+			edges.append(edge);
+		}
+		QCborMap action;
+		for (int j = 0; j < 12; j++) {
+			action[QString::number((i + j) % Terminals)] =
+				symbol("s", (i + j) % states);
+		}
+		actionTable.append(action);
+		QCborMap jump;
+		for (int j = 0; j < 6; j++) {
+			jump[QString::number(Terminals + (i + j) % Nonterminals)] =
+				(i + j) % states;
+		}
+		gotoTable.append(jump);
+	}
+
+	QCborMap closureMap;
+	closureMap[QString("closures")] = closures;
+	closureMap[QString("edges")] = edges;
+	QCborMap variables;
+	variables[QString("terminals")] = terminalList;
+	variables[QString("productions")] = productionList;
+	variables[QString("loop_variable_i")] = states;
+	variables[QString("closure_map")] = closureMap;
+	variables[QString("current_closure")] = closures.last();
+	variables[QString("action_table")] = actionTable;
+	variables[QString("goto_table")] = gotoTable;
+	variables[QString("code_path")] =
+		QString(lookahead ? "lr1.go" : "lr0.go");
+	return variables;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QCborArray>
+#include <QCborMap>
+
+// 合成指定状态数的 LR 断点变量，供基准测试与替身后端使用
+// 符号与服务端一致，以会话符号表中的编号表示：
+// 前 Terminals 个为终结符 t0..，之后为非终结符 N0..
+namespace synthetic {
+	constexpr int Terminals = 40;
+	constexpr int Nonterminals = 30;
+	constexpr int Productions = 60;
+
+	// 会话符号表，即响应中的 symbols
+	QCborArray Symbols();
+	// lookahead 为 false 时为 LR(0) 项目，没有向前看符号
+	QCborMap LRVariables(int states, bool lookahead);
+} // namespace synthetic
@@ -0,0 +1,205 @@
+#include "BatchGenerator.h"
+#include "ipc/ipc.h"
+#include "ipc/notifier.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+static const QStringList algorithmNames = {"ll", "ll-notranslate", "lr0",
+										   "slr", "lr1", "lalr"};
+
+static QString describeCode(const QString &algorithm, int code) {
+	switch (code) {
+		case -1:
+			return "无法启动";
+		case 0:
+			return "成功";
+		case 1:
+			return "产生式代码解析错误";
+		case 2:
+			return algorithm.startsWith("ll") ? "Select 集冲突" : "没有开始符号";
+		case 3:
+			return "项目集闭包冲突";
+	}
+	return QString("错误 %1").arg(code);
+}
+
+BatchGenerator::BatchGenerator(const QStringList &grammars,
+							   const QStringList &algorithms,
+							   const QString &outputDir, int jobs,
+							   QObject *parent)
+	: QObject(parent), maxRunning(qMax(jobs, 1)) {
+	for (auto &grammar : grammars) {
+		QFileInfo info(grammar);
+		auto dir = outputDir.isEmpty() ? info.absoluteDir() : QDir(outputDir);
+		for (auto &algorithm : algorithms) {
+			Job job;
+			job.grammar = grammar;
+			job.algorithm = algorithm;
+			job.savePath = dir.filePath(info.completeBaseName() + "_" +
+										QString(algorithm).replace('-', '_'));
+			this->jobs.append(job);
+		}
+	}
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processExited, this,
+			&BatchGenerator::processExited);
+}
+
+bool BatchGenerator::IsAlgorithm(const QString &algorithm) {
+	return algorithmNames.contains(algorithm);
+}
+
+void BatchGenerator::Start() {
+	total.start();
+	ipc::SendLogMessage(QString("generate: %1 jobs, %2 at a time")
+							.arg(jobs.size())
+							.arg(maxRunning));
+	startNext();
+}
+
+void BatchGenerator::startNext() {
+	while (runningIds.size() + starting < maxRunning &&
+		   nextJob < jobs.size()) {
+		int index = nextJob++;
+		if (!startJob(index)) {
+			finishJob(index, -1);
+			continue;
+		}
+		starting++;
+	}
+	if (finishedJobs == jobs.size()) {
+		printSummary();
+	}
+}
+
+// 与 MainWindow 的导出代码相同：新建会话并在同一批量中开始运行
+// 会话新建后开始查询退出结果；无法读取文法时返回 false
+bool BatchGenerator::startJob(int index) {
+	auto job = &jobs[index];
+	QFile file(job->grammar);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		ipc::SendLogMessage("generate: cannot read " + job->grammar);
+		return false;
+	}
+	auto code = QString::fromUtf8(file.readAll());
+	job->timer.start();
+	ipc::Batch batch;
+	auto &algorithm = job->algorithm;
+	if (algorithm == "ll" || algorithm == "ll-notranslate") {
+		batch.LLProcessRequest(code, algorithm == "ll", job->savePath);
+		batch.LLProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	} else if (algorithm == "lr0" || algorithm == "slr") {
+		batch.LR0ProcessRequest(code, algorithm == "slr", job->savePath);
+		batch.LR0ProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	} else {
+		batch.LR1ProcessRequest(code, algorithm == "lalr", job->savePath);
+		batch.LR1ProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	}
+	batch.SendAsync(this, [this, index](const QString &id) {
+		starting--;
+		jobs[index].id = id;
+		if (id.isEmpty()) {
+			finishJob(index, -1);
+			startNext();
+			return;
+		}
+		runningIds.insert(id, index);
+		checkJob(index);
+	});
+	return true;
+}
+
+void BatchGenerator::processExited(QString id) {
+	auto it = runningIds.constFind(id);
+	if (it != runningIds.constEnd()) {
+		checkJob(it.value());
+	}
+}
+
+// 查询退出结果；查询期间收到退出事件时，结果返回后再查询一次
+void BatchGenerator::checkJob(int index) {
+	auto &job = jobs[index];
+	if (job.checking) {
+		job.recheck = true;
+		return;
+	}
+	job.checking = true;
+	auto done = [this, index](bool exit, int code) {
+		auto &job = jobs[index];
+		job.checking = false;
+		if (exit) {
+			finishJob(index, code);
+			startNext();
+		} else if (job.recheck) {
+			job.recheck = false;
+			checkJob(index);
+		}
+	};
+	auto &algorithm = job.algorithm;
+	if (algorithm == "ll" || algorithm == "ll-notranslate") {
+		ipc::LLProcessExitAsync(
+			job.id, this, [done](bool exit, const ipc::LLExitResult &result) {
+				done(exit, result.code);
+			});
+	} else if (algorithm == "lr0" || algorithm == "slr") {
+		ipc::LR0ProcessExitAsync(
+			job.id, this, [done](bool exit, const ipc::LR0ExitResult &result) {
+				done(exit, result.code);
+			});
+	} else {
+		ipc::LR1ProcessExitAsync(
+			job.id, this, [done](bool exit, const ipc::LR1ExitResult &result) {
+				done(exit, result.code);
+			});
+	}
+}
+
+void BatchGenerator::finishJob(int index, int code) {
+	auto &job = jobs[index];
+	job.code = code;
+	finishedJobs++;
+	if (job.id.isEmpty()) {
+		return;
+	}
+	job.elapsed = job.timer.elapsed();
+	runningIds.remove(job.id);
+	if (job.algorithm.startsWith("ll")) {
+		ipc::LLProcessRelease(job.id);
+	} else if (job.algorithm == "lr0" || job.algorithm == "slr") {
+		ipc::LR0ProcessRelease(job.id);
+	} else {
+		ipc::LR1ProcessRelease(job.id);
+	}
+	ipc::SendLogMessage(QString("generate: [%1/%2] %3 %4: %5 (%6 ms)")
+							.arg(finishedJobs)
+							.arg(jobs.size())
+							.arg(job.algorithm, job.grammar,
+								 describeCode(job.algorithm, code))
+							.arg(job.elapsed));
+}
+
+void BatchGenerator::printSummary() {
+	int failed = 0;
+	qint64 sum = 0;
+	ipc::SendLogMessage("generate: summary");
+	for (auto &job : jobs) {
+		if (job.code != 0) {
+			failed++;
+		}
+		sum += job.elapsed;
+		auto result = job.code == 0 ? job.savePath
+									: describeCode(job.algorithm, job.code);
+		ipc::SendLogMessage(QString("  %1 %2 %3 ms  %4")
+								.arg(job.algorithm, -14)
+								.arg(job.grammar, -40)
+								.arg(job.elapsed, 8)
+								.arg(result));
+	}
+	ipc::SendLogMessage(
+		QString("generate: %1 succeeded, %2 failed, %3 ms total, %4 ms wall")
+			.arg(jobs.size() - failed)
+			.arg(failed)
+			.arg(sum)
+			.arg(total.elapsed()));
+	emit finished(failed);
+}
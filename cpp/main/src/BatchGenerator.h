@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+// 无界面批量生成代码：每个文法文件按各算法生成一份代码，
+// 同时至多运行 jobs 个任务，服务端的各任务在各自的 goroutine 中并行计算
+// 结束后经日志输出每个任务的耗时，以 finished 报告失败的任务数
+class BatchGenerator : public QObject {
+	Q_OBJECT
+
+public:
+	// algorithms 为 ll、ll-notranslate、lr0、slr、lr1、lalr
+	// outputDir 为空时输出到文法文件所在目录，文件名为 <文法>_<算法>.h/.cpp
+	BatchGenerator(const QStringList &grammars, const QStringList &algorithms,
+				   const QString &outputDir, int jobs,
+				   QObject *parent = nullptr);
+
+	static bool IsAlgorithm(const QString &algorithm);
+	void Start();
+
+signals:
+	void finished(int failed);
+
+private slots:
+	void processExited(QString id);
+
+private:
+	struct Job {
+		QString grammar;
+		QString algorithm;
+		QString savePath;
+		QString id;
+		QElapsedTimer timer;
+		qint64 elapsed = 0;
+		// 服务端的退出码，-1 表示无法启动
+		int code = -1;
+		bool checking = false;
+		bool recheck = false;
+	};
+
+	void startNext();
+	bool startJob(int index);
+	void checkJob(int index);
+	void finishJob(int index, int code);
+	void printSummary();
+
+	QList<Job> jobs;
+	QHash<QString, int> runningIds;
+	// 已发出、尚未收到新建结果的任务数
+	int starting = 0;
+	int maxRunning;
+	int nextJob = 0;
+	int finishedJobs = 0;
+	QElapsedTimer total;
+};
@@ -0,0 +1,242 @@
+#include "CompareDialog.h"
+#include "ipc/ipc.h"
+#include "ipc/notifier.h"
+
+// 参与比较的算法，与演示菜单的名称一致
+static const QStringList algorithms = {"LL", "LR(0)", "SLR", "LALR", "LR(1)"};
+
+// 冲突的动作以“移入-归约冲突”或“归约-归约冲突”开头
+static const QString conflictMark = "冲突";
+
+static QTableWidgetItem *numberItem(const QVariant &value) {
+	auto item = new QTableWidgetItem();
+	item->setData(Qt::DisplayRole, value);
+	item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+	return item;
+}
+
+static QString describeCode(const QString &algorithm, int code) {
+	switch (code) {
+		case 0:
+			return "无冲突";
+		case 1:
+			return "产生式代码解析错误";
+		case 2:
+			return algorithm == "LL" ? "Select 集冲突" : "没有开始符号";
+		case 3:
+			return "项目集闭包冲突";
+	}
+	return QString("错误 %1").arg(code);
+}
+
+CompareDialog::CompareDialog(QWidget *parent) : QDialog(parent) {
+	ui.setupUi(this);
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processExited, this,
+			[this](QString id) {
+				auto it = runningIds.constFind(id);
+				if (it != runningIds.constEnd()) {
+					checkRun(it.value());
+				}
+			});
+}
+
+CompareDialog::~CompareDialog() {
+	releaseAll();
+}
+
+// 预测分析表：-1 为空，-2 为冲突
+CompareDialog::TableStats
+CompareDialog::llStats(const ipc::LLBreakpointVariables &variables) {
+	TableStats stats;
+	stats.states = variables.automation.size();
+	stats.cells = stats.states * (variables.terminals.size() + 1);
+	for (auto &row : variables.automation) {
+		for (auto production : row) {
+			if (production != -1) {
+				stats.entries++;
+			}
+			if (production == -2) {
+				stats.conflicts++;
+			}
+		}
+	}
+	return stats;
+}
+
+// Action 表的列为终结符与 $，Goto 表的列为非终结符
+template <typename T>
+CompareDialog::TableStats CompareDialog::lrStats(const T &variables) {
+	TableStats stats;
+	stats.states = variables.actionTable.size();
+	stats.cells = stats.states * (variables.terminals.size() + 1 +
+								  variables.nonterminalOrders.size());
+	for (auto &row : variables.actionTable) {
+		for (auto &action : row) {
+			if (action.isEmpty()) {
+				continue;
+			}
+			stats.entries++;
+			if (action.contains(conflictMark)) {
+				stats.conflicts++;
+			}
+		}
+	}
+	for (auto &row : variables.gotoTable) {
+		for (auto jump : row) {
+			if (jump != -1) {
+				stats.entries++;
+			}
+		}
+	}
+	return stats;
+}
+
+void CompareDialog::compare(const QString &code) {
+	releaseAll();
+	runs.clear();
+	generation++;
+	ui.tableWidget->setSortingEnabled(false);
+	ui.tableWidget->clearContents();
+	ui.tableWidget->setRowCount(algorithms.size());
+	total.start();
+	// 各会话在服务端各自的 goroutine 中运行，先全部启动再等待结果
+	starting = algorithms.size();
+	for (int row = 0; row < algorithms.size(); row++) {
+		Run run;
+		run.algorithm = algorithms[row];
+		run.timer.start();
+		runs.append(run);
+		ui.tableWidget->setItem(row, 0, new QTableWidgetItem(run.algorithm));
+		ui.tableWidget->setItem(row, 1, new QTableWidgetItem("启动中..."));
+		ipc::Batch batch;
+		if (run.algorithm == "LL") {
+			batch.LLProcessRequest(code, true);
+			batch.LLProcessSwitchMode(QString(), ipc::ProcessModeRun);
+		} else if (run.algorithm == "LR(0)" || run.algorithm == "SLR") {
+			batch.LR0ProcessRequest(code, run.algorithm == "SLR");
+			batch.LR0ProcessSwitchMode(QString(), ipc::ProcessModeRun);
+		} else {
+			batch.LR1ProcessRequest(code, run.algorithm == "LALR");
+			batch.LR1ProcessSwitchMode(QString(), ipc::ProcessModeRun);
+		}
+		auto current = generation;
+		batch.SendAsync(this, [this, row, current](const QString &id) {
+			startRun(row, current, id);
+		});
+	}
+	updateStatus();
+}
+
+// 会话已新建；此后又开始了新的比较时释放该会话
+void CompareDialog::startRun(int row, int current, const QString &id) {
+	if (current != generation) {
+		if (!id.isEmpty()) {
+			Run stale;
+			stale.algorithm = algorithms[row];
+			stale.id = id;
+			releaseRun(stale);
+		}
+		return;
+	}
+	starting--;
+	auto &run = runs[row];
+	run.id = id;
+	ui.tableWidget->setItem(
+		row, 1, new QTableWidgetItem(id.isEmpty() ? "无法启动" : "运行中..."));
+	if (!id.isEmpty()) {
+		runningIds.insert(id, row);
+		checkRun(row);
+	}
+	updateStatus();
+}
+
+// 查询退出结果；查询期间收到退出事件时，结果返回后再查询一次
+void CompareDialog::checkRun(int row) {
+	auto &run = runs[row];
+	if (run.checking) {
+		run.recheck = true;
+		return;
+	}
+	run.checking = true;
+	auto id = run.id;
+	auto done = [this, row, id](bool exit, int code, const TableStats &stats) {
+		if (!runningIds.contains(id)) {
+			return;
+		}
+		auto &run = runs[row];
+		run.checking = false;
+		if (exit) {
+			finishRun(row, code, code == 1 ? nullptr : &stats);
+		} else if (run.recheck) {
+			run.recheck = false;
+			checkRun(row);
+		}
+	};
+	if (run.algorithm == "LL") {
+		ipc::LLProcessExitAsync(
+			id, this, [done](bool exit, const ipc::LLExitResult &result) {
+				done(exit, result.code, llStats(result.variable));
+			});
+	} else if (run.algorithm == "LR(0)" || run.algorithm == "SLR") {
+		ipc::LR0ProcessExitAsync(
+			id, this, [done](bool exit, const ipc::LR0ExitResult &result) {
+				done(exit, result.code, lrStats(result.variable));
+			});
+	} else {
+		ipc::LR1ProcessExitAsync(
+			id, this, [done](bool exit, const ipc::LR1ExitResult &result) {
+				done(exit, result.code, lrStats(result.variable));
+			});
+	}
+}
+
+void CompareDialog::finishRun(int row, int code, const TableStats *stats) {
+	auto &run = runs[row];
+	auto elapsed = run.timer.elapsed();
+	runningIds.remove(run.id);
+	releaseRun(run);
+	ui.tableWidget->setItem(
+		row, 1, new QTableWidgetItem(describeCode(run.algorithm, code)));
+	if (stats != nullptr) {
+		ui.tableWidget->setItem(row, 2, numberItem(stats->states));
+		ui.tableWidget->setItem(row, 3, numberItem(stats->conflicts));
+		ui.tableWidget->setItem(row, 4, numberItem(stats->entries));
+		// 百分比保留一位小数
+		double density = 0;
+		if (stats->cells > 0) {
+			density = qRound(stats->entries * 1000.0 / stats->cells) / 10.0;
+		}
+		ui.tableWidget->setItem(row, 5, numberItem(density));
+	}
+	ui.tableWidget->setItem(row, 6, numberItem(elapsed));
+	updateStatus();
+}
+
+void CompareDialog::releaseRun(const Run &run) {
+	if (run.algorithm == "LL") {
+		ipc::LLProcessRelease(run.id);
+	} else if (run.algorithm == "LR(0)" || run.algorithm == "SLR") {
+		ipc::LR0ProcessRelease(run.id);
+	} else {
+		ipc::LR1ProcessRelease(run.id);
+	}
+}
+
+void CompareDialog::releaseAll() {
+	for (auto row : runningIds) {
+		releaseRun(runs[row]);
+	}
+	runningIds.clear();
+}
+
+void CompareDialog::updateStatus() {
+	if (!runningIds.isEmpty() || starting > 0) {
+		ui.statusLabel->setText(QString("%1 个算法运行中...")
+									.arg(runningIds.size() + starting));
+		return;
+	}
+	ui.statusLabel->setText(
+		QString("全部完成，用时 %1 ms，表密度为百分比").arg(total.elapsed()));
+	ui.tableWidget->setSortingEnabled(true);
+	ui.tableWidget->resizeColumnsToContents();
+}
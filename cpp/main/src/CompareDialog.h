@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ipc/types.h"
+#include "ui_compare_dialog.h"
+#include <QDialog>
+#include <QElapsedTimer>
+#include <QHash>
+
+// 以同一文法并行运行各算法，比较状态数、冲突数、表密度与耗时
+class CompareDialog : public QDialog {
+
+public:
+	explicit CompareDialog(QWidget *parent = nullptr);
+	virtual ~CompareDialog();
+
+	// 放弃尚未结束的比较，为 code 启动各算法的会话
+	void compare(const QString &code);
+
+private:
+	// 分析表的统计：LL 的状态为非终结符，LR 的状态为项目集闭包
+	struct TableStats {
+		int states = 0;
+		int conflicts = 0;
+		int entries = 0;
+		int cells = 0;
+	};
+	struct Run {
+		QString algorithm;
+		QString id;
+		QElapsedTimer timer;
+		bool checking = false;
+		bool recheck = false;
+	};
+
+	static TableStats llStats(const ipc::LLBreakpointVariables &variables);
+	template <typename T> static TableStats lrStats(const T &variables);
+
+	void startRun(int row, int current, const QString &id);
+	void checkRun(int row);
+	void finishRun(int row, int code, const TableStats *stats);
+	void releaseRun(const Run &run);
+	void releaseAll();
+	void updateStatus();
+
+	Ui::CompareDialog ui;
+	QList<Run> runs;
+	QHash<QString, int> runningIds;
+	// 尚未收到新建结果的会话数；每次比较递增 generation，丢弃上次比较的结果
+	int starting = 0;
+	int generation = 0;
+	QElapsedTimer total;
+};
@@ -0,0 +1,77 @@
+#include "DiagnosticsDialog.h"
+#include "ipc/stats.h"
+#include <QFileDialog>
+#include <QMessageBox>
+
+// 数值列以数值存储，排序按大小而不是字典序
+static QTableWidgetItem *numberItem(const QVariant &value) {
+	auto item = new QTableWidgetItem();
+	item->setData(Qt::DisplayRole, value);
+	item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+	return item;
+}
+
+// 纳秒转换为毫秒，保留三位小数
+static QTableWidgetItem *millisecondItem(double ns) {
+	return numberItem(qRound64(ns / 1e3) / 1e3);
+}
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent) : QDialog(parent) {
+	ui.setupUi(this);
+	connect(ui.refreshButton, &QPushButton::clicked, this,
+			&DiagnosticsDialog::updateInformation);
+	connect(ui.resetButton, &QPushButton::clicked, this, [this]() {
+		ipc::ResetStatistics();
+		updateInformation();
+	});
+	connect(ui.dumpButton, &QPushButton::clicked, this,
+			[this]() { dumpStatistics(this); });
+}
+
+DiagnosticsDialog::~DiagnosticsDialog() {
+}
+
+void DiagnosticsDialog::updateInformation() {
+	auto statistics = ipc::Statistics();
+	ui.tableWidget->setSortingEnabled(false);
+	ui.tableWidget->setRowCount(statistics.size());
+	int row = 0;
+	for (auto it = statistics.constBegin(); it != statistics.constEnd();
+		 ++it, row++) {
+		auto &stats = it.value();
+		auto count = qMax<qint64>(stats.count, 1);
+		ui.tableWidget->setItem(row, 0, new QTableWidgetItem(it.key()));
+		ui.tableWidget->setItem(row, 1, numberItem(stats.count));
+		ui.tableWidget->setItem(row, 2, numberItem(stats.failures));
+		ui.tableWidget->setItem(row, 3, numberItem(stats.requestBytes));
+		ui.tableWidget->setItem(row, 4, numberItem(stats.responseBytes));
+		ui.tableWidget->setItem(row, 5,
+								millisecondItem(double(stats.queueNs) / count));
+		ui.tableWidget->setItem(
+			row, 6, millisecondItem(double(stats.roundTripNs) / count));
+		ui.tableWidget->setItem(
+			row, 7, millisecondItem(ipc::LatencyPercentile(stats, 0.5) * 1e6));
+		ui.tableWidget->setItem(
+			row, 8, millisecondItem(ipc::LatencyPercentile(stats, 0.9) * 1e6));
+		ui.tableWidget->setItem(
+			row, 9, millisecondItem(ipc::LatencyPercentile(stats, 0.99) * 1e6));
+		ui.tableWidget->setItem(row, 10, millisecondItem(stats.maxRoundTripNs));
+		ui.tableWidget->setItem(row, 11, millisecondItem(stats.decodeNs));
+		ui.tableWidget->setItem(
+			row, 12,
+			numberItem(qRound(ipc::CompressionRatio(stats) * 100) / 100.0));
+	}
+	ui.tableWidget->setSortingEnabled(true);
+	ui.tableWidget->resizeColumnsToContents();
+}
+
+void DiagnosticsDialog::dumpStatistics(QWidget *parent) {
+	QString fileName = QFileDialog::getSaveFileName(
+		parent, "导出通信统计", "rpc-statistics.json", "JSON (*.json)");
+	if (fileName.isEmpty()) {
+		return;
+	}
+	if (!ipc::DumpStatistics(fileName)) {
+		QMessageBox::warning(parent, "导出通信统计", "无法写入 " + fileName);
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ui_diagnostics_dialog.h"
+#include <QDialog>
+
+// 按 action 显示 RPC 统计，可导出为 JSON 文件
+class DiagnosticsDialog : public QDialog {
+
+public:
+	explicit DiagnosticsDialog(QWidget *parent = nullptr);
+	virtual ~DiagnosticsDialog();
+
+	void updateInformation();
+	// 选择位置并导出统计，parent 为文件对话框的父窗口
+	static void dumpStatistics(QWidget *parent);
+
+private:
+	Ui::DiagnosticsDialog ui;
+};
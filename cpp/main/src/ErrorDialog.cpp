@@ -39,7 +39,7 @@ void ErrorDialog::initView() {
 	ui.tableWidget->resizeColumnsToContents();
 }
 
-void ErrorDialog::updateInformation(ipc::ProductionResult *result) {
+void ErrorDialog::updateInformation(const ipc::ProductionResult *result) {
 	cacheErrors.clear();
 	cacheErrors.append(result->fatals);
 	cacheErrors.append(result->errors);
@@ -10,7 +10,7 @@ public:
 	explicit ErrorDialog(QWidget *parent = nullptr);
 	virtual ~ErrorDialog();
 
-	void updateInformation(ipc::ProductionResult *result);
+	void updateInformation(const ipc::ProductionResult *result);
 	void initView();
 
 private:
@@ -1,6 +1,7 @@
 #include "demo_ll_alogrithm.h"
 #include "ipc/base.h"
 #include "ipc/ipc.h"
+#include "ipc/notifier.h"
 #include <QAction>
 #include <QCloseEvent>
 #include <QListWidgetItem>
@@ -18,7 +19,7 @@ static QString modeStrings[] = {"产生式列表",		"First 集",	 "Follow 集",
 								"First、Follow 集", "Select 集", "自动机"};
 
 DemoLLAlogrithmWindow::DemoLLAlogrithmWindow(QString code, bool withTranslate)
-	: QMainWindow(), ui(new Ui::DemoLLWindow) {
+	: QMainWindow(), ui(new Ui::DemoLLWindow), checking(false), recheck(false) {
 	ui->setupUi(this);
 	statusLabel = new QLabel(ui->statusbar);
 	ui->statusbar->addWidget(statusLabel);
@@ -39,18 +40,24 @@ DemoLLAlogrithmWindow::DemoLLAlogrithmWindow(QString code, bool withTranslate)
 		demoWidgets << widget;
 	}
 
-	processId = ipc::LLProcessRequest(code, withTranslate);
-	setProcessBreakpoint();
-	ipc::LLProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	batch.LLProcessRequest(code, withTranslate);
+	setProcessBreakpoint(&batch);
+	batch.LLProcessSwitchMode(QString(), ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
-
-	codeAnalyseTimer.start(100);
-	connect(&codeAnalyseTimer, &QTimer::timeout, this,
-			&DemoLLAlogrithmWindow::processCheck);
+	batch.SendAsync(this, [this](const QString &id) {
+		processId = id;
+		processCheck();
+	});
+
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processPaused, this,
+			&DemoLLAlogrithmWindow::processEvent);
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processExited, this,
+			&DemoLLAlogrithmWindow::processEvent);
 }
 
 DemoLLAlogrithmWindow::~DemoLLAlogrithmWindow() {
+	checkOptions.token.Cancel();
 	delete ui;
 	for (auto widget : demoWidgets) {
 		widget->close();
@@ -88,7 +95,8 @@ void DemoLLAlogrithmWindow::contextMenu() {
 	menu.exec(QCursor::pos());
 }
 
-void DemoLLAlogrithmWindow::setProcessBreakpoint(bool withSelectLine) {
+void DemoLLAlogrithmWindow::setProcessBreakpoint(ipc::Batch *batch,
+												 bool withSelectLine) {
 	QList<ipc::Breakpoint> breakpoints;
 	const char *names[] = {"RemoveLeftRecusion", "ExtractCommonPrefix",
 						   "ComputeFirstSet",	 "ComputeFollowSet",
@@ -104,55 +112,101 @@ void DemoLLAlogrithmWindow::setProcessBreakpoint(bool withSelectLine) {
 			appendBreakpoint(&breakpoints, i);
 		}
 	}
-	ipc::LLProcessSetBreakpoints(processId, breakpoints);
+	batch->LLProcessSetBreakpoints(processId, breakpoints);
 }
 
-void DemoLLAlogrithmWindow::processCheck() {
+void DemoLLAlogrithmWindow::processCheck(ipc::Batch *batch) {
 	if (status != Run || processId.isEmpty()) {
 		return;
 	}
-	ipc::LLBreakpointVariables vars;
-	ipc::Breakpoint point;
-	auto paused = ipc::LLProcessGetVariables(processId, &vars, &point);
-	if (paused) {
-		status = Pause;
-		ui->keyWidget->setVariableAndPoint(vars, point);
-		for (auto widget : demoWidgets) {
-			widget->setVariableAndPoint(vars, point);
-		}
-		setupPoint(point);
+	if (checking) {
+		recheck = true;
 		return;
 	}
-	ipc::LLExitResult result;
-	auto exit = ipc::LLProcessExit(processId, &result);
-	if (exit) {
-		status = Exit;
-		ipc::LLProcessRelease(processId);
-		processId = "";
-		switch (result.code) {
-			case 0:
-				statusLabel->setText("算法演示完成");
-				QMessageBox::information(this, "演示完成", "算法已演示完成");
-				break;
-			case 1:
-				statusLabel->setText("产生式代码解析错误");
-				QMessageBox::information(this, "演示错误",
-										 "产生式代码解析错误");
-				close();
-				break;
-			case 2:
-				statusLabel->setText("Select 集合冲突，无法生成自动机");
-				point.line = -1;
-				point.name = "GenerateAutomaton";
-				ui->keyWidget->setVariableAndPoint(result.variable, point);
-				for (auto widget : demoWidgets) {
-					widget->setVariableAndPoint(result.variable, point);
-				}
-				setupPoint(point);
-				QMessageBox::information(this, "演示错误",
-										 "Select 集合冲突，无法生成自动机");
-				break;
+	checking = true;
+	auto id = processId;
+	auto callback = [this, id](bool paused,
+							   const ipc::LLBreakpointVariables &vars,
+							   const ipc::Breakpoint &point) {
+		if (!paused && id == processId && status == Run) {
+			processExitCheck();
+			return;
 		}
+		if (paused && id == processId && status == Run) {
+			processPaused(vars, point);
+		}
+		finishCheck();
+	};
+	if (batch != nullptr) {
+		batch->LLProcessGetVariables(id, callback);
+	} else {
+		ipc::LLProcessGetVariablesAsync(id, this, callback, checkOptions);
+	}
+}
+
+void DemoLLAlogrithmWindow::processExitCheck() {
+	auto id = processId;
+	ipc::LLProcessExitAsync(
+		id, this, [this, id](bool exit, const ipc::LLExitResult &result) {
+			if (exit && id == processId) {
+				processExit(result);
+			}
+			finishCheck();
+		});
+}
+
+void DemoLLAlogrithmWindow::finishCheck() {
+	checking = false;
+	if (recheck) {
+		recheck = false;
+		processCheck();
+	}
+}
+
+void DemoLLAlogrithmWindow::processEvent(QString id) {
+	if (id == processId) {
+		processCheck();
+	}
+}
+
+void DemoLLAlogrithmWindow::processPaused(
+	const ipc::LLBreakpointVariables &vars, const ipc::Breakpoint &point) {
+	status = Pause;
+	ui->keyWidget->setVariableAndPoint(vars, point);
+	for (auto widget : demoWidgets) {
+		widget->setVariableAndPoint(vars, point);
+	}
+	setupPoint(point);
+}
+
+void DemoLLAlogrithmWindow::processExit(const ipc::LLExitResult &result) {
+	ipc::Breakpoint point;
+	status = Exit;
+	ipc::LLProcessRelease(processId);
+	processId = "";
+	switch (result.code) {
+		case 0:
+			statusLabel->setText("算法演示完成");
+			QMessageBox::information(this, "演示完成", "算法已演示完成");
+			break;
+		case 1:
+			statusLabel->setText("产生式代码解析错误");
+			QMessageBox::information(this, "演示错误",
+									 "产生式代码解析错误");
+			close();
+			break;
+		case 2:
+			statusLabel->setText("Select 集合冲突，无法生成自动机");
+			point.line = -1;
+			point.name = "GenerateAutomaton";
+			ui->keyWidget->setVariableAndPoint(result.variable, point);
+			for (auto widget : demoWidgets) {
+				widget->setVariableAndPoint(result.variable, point);
+			}
+			setupPoint(point);
+			QMessageBox::information(this, "演示错误",
+									 "Select 集合冲突，无法生成自动机");
+			break;
 	}
 }
 
@@ -160,29 +214,35 @@ void DemoLLAlogrithmWindow::runButtonTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	setProcessBreakpoint();
-	ipc::LLProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	setProcessBreakpoint(&batch);
+	batch.LLProcessSwitchMode(processId, ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
 
 void DemoLLAlogrithmWindow::stepButtonTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	ipc::LLProcessSwitchMode(processId, ipc::ProcessModePause);
+	ipc::Batch batch;
+	batch.LLProcessSwitchMode(processId, ipc::ProcessModePause);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
 
 void DemoLLAlogrithmWindow::runToCursorTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	setProcessBreakpoint(true);
-	ipc::LLProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	setProcessBreakpoint(&batch, true);
+	batch.LLProcessSwitchMode(processId, ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
 
 void DemoLLAlogrithmWindow::setupPoint(const ipc::Breakpoint &point) {
@@ -1,6 +1,7 @@
 #include "demo_lr0_alogrithm.h"
 #include "ipc/base.h"
 #include "ipc/ipc.h"
+#include "ipc/notifier.h"
 #include <QAction>
 #include <QCloseEvent>
 #include <QListWidgetItem>
@@ -21,7 +22,8 @@ static QString modeStrings[] = {"产生式列表",		"First 集",	  "Follow 集",
 								"First、Follow 集", "项目集闭包", "自动机"};
 
 DemoLR0AlogrithmWindow::DemoLR0AlogrithmWindow(QString code, bool slr)
-	: QMainWindow(), ui(new Ui::DemoLR0Window) {
+	: QMainWindow(), ui(new Ui::DemoLR0Window), checking(false),
+	  recheck(false) {
 	ui->setupUi(this);
 	statusLabel = new QLabel(ui->statusbar);
 	ui->statusbar->addWidget(statusLabel);
@@ -42,18 +44,24 @@ DemoLR0AlogrithmWindow::DemoLR0AlogrithmWindow(QString code, bool slr)
 		demoWidgets << widget;
 	}
 
-	processId = ipc::LR0ProcessRequest(code, slr);
-	setProcessBreakpoint();
-	ipc::LR0ProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	batch.LR0ProcessRequest(code, slr);
+	setProcessBreakpoint(&batch);
+	batch.LR0ProcessSwitchMode(QString(), ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
+	batch.SendAsync(this, [this](const QString &id) {
+		processId = id;
+		processCheck();
+	});
 
-	codeAnalyseTimer.start(100);
-	connect(&codeAnalyseTimer, &QTimer::timeout, this,
-			&DemoLR0AlogrithmWindow::processCheck);
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processPaused, this,
+			&DemoLR0AlogrithmWindow::processEvent);
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processExited, this,
+			&DemoLR0AlogrithmWindow::processEvent);
 }
 
 DemoLR0AlogrithmWindow::~DemoLR0AlogrithmWindow() {
+	checkOptions.token.Cancel();
 	delete ui;
 	for (auto widget : demoWidgets) {
 		widget->close();
@@ -91,53 +99,99 @@ void DemoLR0AlogrithmWindow::contextMenu() {
 	menu.exec(QCursor::pos());
 }
 
-void DemoLR0AlogrithmWindow::processCheck() {
+void DemoLR0AlogrithmWindow::processCheck(ipc::Batch *batch) {
 	if (status != Run || processId.isEmpty()) {
 		return;
 	}
-	ipc::LR0BreakpointVariables vars;
-	ipc::Breakpoint point;
-	auto paused = ipc::LR0ProcessGetVariables(processId, &vars, &point);
-	if (paused) {
-		status = Pause;
-		ui->keyWidget->setVariableAndPoint(vars, point);
-		for (auto widget : demoWidgets) {
-			widget->setVariableAndPoint(vars, point);
-		}
-		setupPoint(point);
+	if (checking) {
+		recheck = true;
 		return;
 	}
-	ipc::LR0ExitResult result;
-	auto exit = ipc::LR0ProcessExit(processId, &result);
-	if (exit) {
-		status = Exit;
-		ipc::LR0ProcessRelease(processId);
-		processId = "";
-		switch (result.code) {
-			case 0:
-				statusLabel->setText("算法演示完成");
-				QMessageBox::information(this, "演示完成", "算法已演示完成");
-				break;
-			case 1:
-				statusLabel->setText("产生式代码解析错误");
-				QMessageBox::information(this, "演示错误",
-										 "产生式代码解析错误");
-				close();
-				break;
-			case 2:
-				statusLabel->setText("没有开始符号");
-				QMessageBox::information(this, "演示错误", "没有开始符号");
-				break;
-			case 3:
-				statusLabel->setText("项目集闭包冲突");
-				QMessageBox::information(this, "演示错误",
-										 "项目集闭包冲突，无法生成自动机");
-				break;
+	checking = true;
+	auto id = processId;
+	auto callback = [this, id](bool paused,
+							   const ipc::LR0BreakpointVariables &vars,
+							   const ipc::Breakpoint &point) {
+		if (!paused && id == processId && status == Run) {
+			processExitCheck();
+			return;
 		}
+		if (paused && id == processId && status == Run) {
+			processPaused(vars, point);
+		}
+		finishCheck();
+	};
+	if (batch != nullptr) {
+		batch->LR0ProcessGetVariables(id, callback);
+	} else {
+		ipc::LR0ProcessGetVariablesAsync(id, this, callback, checkOptions);
+	}
+}
+
+void DemoLR0AlogrithmWindow::processExitCheck() {
+	auto id = processId;
+	ipc::LR0ProcessExitAsync(
+		id, this, [this, id](bool exit, const ipc::LR0ExitResult &result) {
+			if (exit && id == processId) {
+				processExit(result);
+			}
+			finishCheck();
+		});
+}
+
+void DemoLR0AlogrithmWindow::finishCheck() {
+	checking = false;
+	if (recheck) {
+		recheck = false;
+		processCheck();
+	}
+}
+
+void DemoLR0AlogrithmWindow::processEvent(QString id) {
+	if (id == processId) {
+		processCheck();
+	}
+}
+
+void DemoLR0AlogrithmWindow::processPaused(
+	const ipc::LR0BreakpointVariables &vars, const ipc::Breakpoint &point) {
+	status = Pause;
+	ui->keyWidget->setVariableAndPoint(vars, point);
+	for (auto widget : demoWidgets) {
+		widget->setVariableAndPoint(vars, point);
+	}
+	setupPoint(point);
+}
+
+void DemoLR0AlogrithmWindow::processExit(const ipc::LR0ExitResult &result) {
+	status = Exit;
+	ipc::LR0ProcessRelease(processId);
+	processId = "";
+	switch (result.code) {
+		case 0:
+			statusLabel->setText("算法演示完成");
+			QMessageBox::information(this, "演示完成", "算法已演示完成");
+			break;
+		case 1:
+			statusLabel->setText("产生式代码解析错误");
+			QMessageBox::information(this, "演示错误",
+									 "产生式代码解析错误");
+			close();
+			break;
+		case 2:
+			statusLabel->setText("没有开始符号");
+			QMessageBox::information(this, "演示错误", "没有开始符号");
+			break;
+		case 3:
+			statusLabel->setText("项目集闭包冲突");
+			QMessageBox::information(this, "演示错误",
+									 "项目集闭包冲突，无法生成自动机");
+			break;
 	}
 }
 
-void DemoLR0AlogrithmWindow::setProcessBreakpoint(bool withSelectLine) {
+void DemoLR0AlogrithmWindow::setProcessBreakpoint(ipc::Batch *batch,
+												  bool withSelectLine) {
 	QList<ipc::Breakpoint> breakpoints;
 	const char *names[] = {
 		"Translate",		  "ComputeFirstSet",	  "ComputeFollowSet",
@@ -153,7 +207,7 @@ void DemoLR0AlogrithmWindow::setProcessBreakpoint(bool withSelectLine) {
 			appendBreakpoint(&breakpoints, i);
 		}
 	}
-	ipc::LR0ProcessSetBreakpoints(processId, breakpoints);
+	batch->LR0ProcessSetBreakpoints(processId, breakpoints);
 }
 
 void DemoLR0AlogrithmWindow::setupPoint(const ipc::Breakpoint &point) {
@@ -485,27 +539,33 @@ void DemoLR0AlogrithmWindow::runButtonTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	setProcessBreakpoint();
-	ipc::LR0ProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	setProcessBreakpoint(&batch);
+	batch.LR0ProcessSwitchMode(processId, ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
 
 void DemoLR0AlogrithmWindow::stepButtonTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	ipc::LR0ProcessSwitchMode(processId, ipc::ProcessModePause);
+	ipc::Batch batch;
+	batch.LR0ProcessSwitchMode(processId, ipc::ProcessModePause);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
 
 void DemoLR0AlogrithmWindow::runToCursorTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	setProcessBreakpoint(true);
-	ipc::LR0ProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	setProcessBreakpoint(&batch, true);
+	batch.LR0ProcessSwitchMode(processId, ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
\ No newline at end of file
@@ -1,11 +1,11 @@
 #pragma once
 
 #include "ui_demo_lr0_window.h"
+#include "ipc/ipc.h"
 #include "widget/DemoWidget.h"
 #include <QLabel>
 #include <QMainWindow>
 #include <QProgressBar>
-#include <QTimer>
 
 class DemoLR0AlogrithmWindow : public QMainWindow {
 	Q_OBJECT
@@ -18,7 +18,9 @@ protected:
 	virtual void closeEvent(QCloseEvent *) override;
 
 private slots:
-	void processCheck();
+	// batch 非空时查询随批量请求发送
+	void processCheck(ipc::Batch *batch = nullptr);
+	void processEvent(QString id);
 
 	void runButtonTrigger();
 	void stepButtonTrigger();
@@ -31,14 +33,24 @@ private:
 private:
 	Ui::DemoLR0Window *ui;
 	QLabel *statusLabel;
-	QTimer codeAnalyseTimer;
 	QString processId;
 	ProcessStatus status;
+	bool checking;
+	// 查询期间收到事件，查询结束后需要重新查询
+	bool recheck;
+	// 状态查询共用的令牌，窗口关闭时取消仍在等待的查询
+	ipc::CallOptions checkOptions{ipc::NoTimeout, ipc::CancelToken::Create()};
 	QString currentFunction;
 	QList<DemoWidget *> demoWidgets;
 
 private:
-	void setProcessBreakpoint(bool withSelectLine = false);
+	void processExitCheck();
+	void finishCheck();
+	void processPaused(const ipc::LR0BreakpointVariables &vars,
+					   const ipc::Breakpoint &point);
+	void processExit(const ipc::LR0ExitResult &result);
+	void setProcessBreakpoint(ipc::Batch *batch,
+							  bool withSelectLine = false);
 	void clearListItemBackground();
 	void setAlogContent(QStringList content);
 	void highlightListItem(int line);
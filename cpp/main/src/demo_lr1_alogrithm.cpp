@@ -1,6 +1,7 @@
 #include "demo_lr1_alogrithm.h"
 #include "ipc/base.h"
 #include "ipc/ipc.h"
+#include "ipc/notifier.h"
 #include <QAction>
 #include <QCloseEvent>
 #include <QListWidgetItem>
@@ -19,7 +20,8 @@ static QString modeStrings[] = {"产生式列表", "First 集", "项目集闭包
 								"自动机"};
 
 DemoLR1AlogrithmWindow::DemoLR1AlogrithmWindow(QString code, bool lalr)
-	: QMainWindow(), ui(new Ui::DemoLR1Window) {
+	: QMainWindow(), ui(new Ui::DemoLR1Window), checking(false),
+	  recheck(false) {
 	ui->setupUi(this);
 	statusLabel = new QLabel(ui->statusbar);
 	ui->statusbar->addWidget(statusLabel);
@@ -40,18 +42,24 @@ DemoLR1AlogrithmWindow::DemoLR1AlogrithmWindow(QString code, bool lalr)
 		demoWidgets << widget;
 	}
 
-	processId = ipc::LR1ProcessRequest(code, lalr);
-	setProcessBreakpoint();
-	ipc::LR1ProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	batch.LR1ProcessRequest(code, lalr);
+	setProcessBreakpoint(&batch);
+	batch.LR1ProcessSwitchMode(QString(), ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
+	batch.SendAsync(this, [this](const QString &id) {
+		processId = id;
+		processCheck();
+	});
 
-	codeAnalyseTimer.start(100);
-	connect(&codeAnalyseTimer, &QTimer::timeout, this,
-			&DemoLR1AlogrithmWindow::processCheck);
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processPaused, this,
+			&DemoLR1AlogrithmWindow::processEvent);
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processExited, this,
+			&DemoLR1AlogrithmWindow::processEvent);
 }
 
 DemoLR1AlogrithmWindow::~DemoLR1AlogrithmWindow() {
+	checkOptions.token.Cancel();
 	delete ui;
 	for (auto widget : demoWidgets) {
 		widget->close();
@@ -89,53 +97,99 @@ void DemoLR1AlogrithmWindow::closeEvent(QCloseEvent *event) {
 	deleteLater();
 }
 
-void DemoLR1AlogrithmWindow::processCheck() {
+void DemoLR1AlogrithmWindow::processCheck(ipc::Batch *batch) {
 	if (status != Run || processId.isEmpty()) {
 		return;
 	}
-	ipc::LR1BreakpointVariables vars;
-	ipc::Breakpoint point;
-	auto paused = ipc::LR1ProcessGetVariables(processId, &vars, &point);
-	if (paused) {
-		status = Pause;
-		ui->keyWidget->setVariableAndPoint(vars, point);
-		for (auto widget : demoWidgets) {
-			widget->setVariableAndPoint(vars, point);
-		}
-		setupPoint(point);
+	if (checking) {
+		recheck = true;
 		return;
 	}
-	ipc::LR1ExitResult result;
-	auto exit = ipc::LR1ProcessExit(processId, &result);
-	if (exit) {
-		status = Exit;
-		ipc::LR1ProcessRelease(processId);
-		processId = "";
-		switch (result.code) {
-			case 0:
-				statusLabel->setText("算法演示完成");
-				QMessageBox::information(this, "演示完成", "算法已演示完成");
-				break;
-			case 1:
-				statusLabel->setText("产生式代码解析错误");
-				QMessageBox::information(this, "演示错误",
-										 "产生式代码解析错误");
-				close();
-				break;
-			case 2:
-				statusLabel->setText("没有开始符号");
-				QMessageBox::information(this, "演示错误", "没有开始符号");
-				break;
-			case 3:
-				statusLabel->setText("项目集闭包冲突");
-				QMessageBox::information(this, "演示错误",
-										 "项目集闭包冲突，无法生成自动机");
-				break;
+	checking = true;
+	auto id = processId;
+	auto callback = [this, id](bool paused,
+							   const ipc::LR1BreakpointVariables &vars,
+							   const ipc::Breakpoint &point) {
+		if (!paused && id == processId && status == Run) {
+			processExitCheck();
+			return;
 		}
+		if (paused && id == processId && status == Run) {
+			processPaused(vars, point);
+		}
+		finishCheck();
+	};
+	if (batch != nullptr) {
+		batch->LR1ProcessGetVariables(id, callback);
+	} else {
+		ipc::LR1ProcessGetVariablesAsync(id, this, callback, checkOptions);
+	}
+}
+
+void DemoLR1AlogrithmWindow::processExitCheck() {
+	auto id = processId;
+	ipc::LR1ProcessExitAsync(
+		id, this, [this, id](bool exit, const ipc::LR1ExitResult &result) {
+			if (exit && id == processId) {
+				processExit(result);
+			}
+			finishCheck();
+		});
+}
+
+void DemoLR1AlogrithmWindow::finishCheck() {
+	checking = false;
+	if (recheck) {
+		recheck = false;
+		processCheck();
+	}
+}
+
+void DemoLR1AlogrithmWindow::processEvent(QString id) {
+	if (id == processId) {
+		processCheck();
+	}
+}
+
+void DemoLR1AlogrithmWindow::processPaused(
+	const ipc::LR1BreakpointVariables &vars, const ipc::Breakpoint &point) {
+	status = Pause;
+	ui->keyWidget->setVariableAndPoint(vars, point);
+	for (auto widget : demoWidgets) {
+		widget->setVariableAndPoint(vars, point);
+	}
+	setupPoint(point);
+}
+
+void DemoLR1AlogrithmWindow::processExit(const ipc::LR1ExitResult &result) {
+	status = Exit;
+	ipc::LR1ProcessRelease(processId);
+	processId = "";
+	switch (result.code) {
+		case 0:
+			statusLabel->setText("算法演示完成");
+			QMessageBox::information(this, "演示完成", "算法已演示完成");
+			break;
+		case 1:
+			statusLabel->setText("产生式代码解析错误");
+			QMessageBox::information(this, "演示错误",
+									 "产生式代码解析错误");
+			close();
+			break;
+		case 2:
+			statusLabel->setText("没有开始符号");
+			QMessageBox::information(this, "演示错误", "没有开始符号");
+			break;
+		case 3:
+			statusLabel->setText("项目集闭包冲突");
+			QMessageBox::information(this, "演示错误",
+									 "项目集闭包冲突，无法生成自动机");
+			break;
 	}
 }
 
-void DemoLR1AlogrithmWindow::setProcessBreakpoint(bool withSelectLine) {
+void DemoLR1AlogrithmWindow::setProcessBreakpoint(ipc::Batch *batch,
+												  bool withSelectLine) {
 	QList<ipc::Breakpoint> breakpoints;
 	const char *names[] = {"Translate", "ComputeFirstSet", "ComputeFollowSet",
 						   "ComputeItemClosure", "GenerateAutomaton"};
@@ -150,7 +204,7 @@ void DemoLR1AlogrithmWindow::setProcessBreakpoint(bool withSelectLine) {
 			appendBreakpoint(&breakpoints, i);
 		}
 	}
-	ipc::LR1ProcessSetBreakpoints(processId, breakpoints);
+	batch->LR1ProcessSetBreakpoints(processId, breakpoints);
 }
 
 void DemoLR1AlogrithmWindow::setupPoint(const ipc::Breakpoint &point) {
@@ -373,27 +427,33 @@ void DemoLR1AlogrithmWindow::runButtonTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	setProcessBreakpoint();
-	ipc::LR1ProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	setProcessBreakpoint(&batch);
+	batch.LR1ProcessSwitchMode(processId, ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
 
 void DemoLR1AlogrithmWindow::stepButtonTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	ipc::LR1ProcessSwitchMode(processId, ipc::ProcessModePause);
+	ipc::Batch batch;
+	batch.LR1ProcessSwitchMode(processId, ipc::ProcessModePause);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
 
 void DemoLR1AlogrithmWindow::runToCursorTrigger() {
 	if (status != Pause || processId.isEmpty()) {
 		return;
 	}
-	setProcessBreakpoint(true);
-	ipc::LR1ProcessSwitchMode(processId, ipc::ProcessModeRun);
+	ipc::Batch batch;
+	setProcessBreakpoint(&batch, true);
+	batch.LR1ProcessSwitchMode(processId, ipc::ProcessModeRun);
 	status = Run;
-	processCheck();
+	processCheck(&batch);
+	batch.SendAsync(this, checkOptions);
 }
\ No newline at end of file
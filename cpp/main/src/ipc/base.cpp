@@ -1,55 +1,874 @@
 #include "base.h"
+#include "notifier.h"
+#include "record.h"
+#include "stats.h"
+#include "stream.h"
+#include <QCborMap>
+#include <QCborValue>
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
 #include <QJsonDocument>
+#include <QMap>
 #include <QMutex>
+#include <QPointer>
+#include <QQueue>
+#include <QSet>
+#include <QTemporaryFile>
 #include <QTextStream>
+#include <QThread>
+#include <QWaitCondition>
+#include <QtEndian>
+#include <cstdio>
+#include <memory>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 namespace ipc {
-	QTextStream *stdinStream, *stdoutStream, *stderrStream;
+	QTextStream *stderrStream;
+	QMutex *logMutex;
+	// 保护请求 id 与等待队列；不在等待响应期间持有
 	QMutex *mutex;
+	// 管道 I/O 线程：接收线程独占 stdin，写入线程独占 stdout
+	// GUI 线程只入队请求，不因后端繁忙或管道写满而阻塞
+	QThread *receiver;
+	QThread *writer = nullptr;
+	// 截止线程：等待最早的截止时间，使超时不依赖于收到任何消息
+	QThread *watchdog;
+	QWaitCondition *deadlineChanged;
+	QMutex *sendMutex;
+	QWaitCondition *sendReady;
+	QQueue<QByteArray> sendQueue;
+
+	// 等待响应的请求，按请求 id 索引
+	// 由接收线程以 decode 解码后交付
+	struct PendingRequest {
+		Decoder decode;
+		QPointer<QObject> context;
+		qint64 id = 0;
+		QDeadlineTimer deadline{QDeadlineTimer::Forever};
+		CancelToken token;
+		// 需要流式解码：响应的 data 保留为原始编码
+		bool streaming = false;
+		// 统计用：请求的 action 与发出后经过的时间
+		QString action;
+		QElapsedTimer timer;
+	};
+	QHash<qint64, PendingRequest> pendingRequests;
+	qint64 nextRequestId = 1;
+	// 接收线程退出的原因，kind 不为 None 时新的请求直接失败
+	RpcError receiverError;
+
+	// 协商结果：是否使用长度前缀帧，以及负载编码
+	bool framed = false;
+	Encoding encoding = Encoding::Json;
+	// 服务端是否压缩较大的响应帧
+	bool compressed = false;
+
+	// 帧头部：4 字节大端序的负载长度
+	constexpr int frameHeaderSize = 4;
+	// 长度的最高位表示负载经 zlib 压缩，格式与 qCompress 相同
+	constexpr quint32 frameCompressedFlag = 1u << 31;
+
+	// 共享内存文件：客户端创建并映射，服务端将较大响应的 data 写入其中
+	// 头部 [8,16) 为小端序的已读取位置，读取完成后更新，服务端据此复用空间
+	QTemporaryFile *sharedFile = nullptr;
+	uchar *sharedMemory = nullptr;
+	constexpr qint64 sharedMemorySize = 64 << 20;
+	constexpr int sharedReadPosOffset = 8;
+	// 短于该长度的 data 直接解码，共享内存的引用总是很短
+	constexpr int smallDataSize = 256;
+	// 仍在使用的共享内存数据块，按结束位置排列，值为是否已用完
+	// 数据块可能乱序用完，已读取位置只推进到连续用完的部分
+	QMutex *sharedMutex;
+	QMap<quint64, bool> sharedBlobs;
+
+	[[noreturn]] void throwError(RpcErrorKind kind, const QString &message);
+	void negotiate();
+	bool openSharedMemory();
+	void closeSharedMemory();
+	QJsonObject decodeObject(const QByteArray &);
+	ipc::Response decodeResponse(const QByteArray &, bool (*)(qint64),
+								 qint64 *sharedBytes);
+	bool isStreamingRequest(qint64 id);
+	ipc::Response streamBatchResult(const QByteArray &, QCborStreamReader &,
+									bool streaming);
+	QByteArray sharedMemoryBlob(const QJsonObject &);
+	void holdSharedMemory(quint64 end);
+	void releaseSharedMemory(quint64 end);
+	QByteArray readLine();
+	QByteArray receiveMessage(qint64 *wireBytes);
+	void readFully(char *data, qint64 size);
+	void writeFully(const char *data, qint64 size);
+	void writeMessage(const QByteArray &);
+	void receiveLoop();
+	void writeLoop();
+	void deadlineLoop();
+	void sendRequest(const QJsonObject &, PendingRequest,
+					 const CallOptions &);
+	void completeRequest(const PendingRequest &, const Response &);
+	void failRequest(const PendingRequest &, const RpcError &);
+	void abandonRequests(const QList<qint64> &ids, RpcErrorKind kind);
+	void dispatchEvent(const Response &);
+	void recordResponse(const Response &);
 } // namespace ipc
 
 void ipc::Init() {
-	stdinStream = new QTextStream(stdin);
-	stdoutStream = new QTextStream(stdout);
-	stderrStream = new QTextStream(stderr);
+#ifdef Q_OS_WIN
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
 
-	stdinStream->setEncoding(QStringConverter::Encoding::Utf8);
-	stdoutStream->setEncoding(QStringConverter::Encoding::Utf8);
+	stderrStream = new QTextStream(stderr);
 	stderrStream->setEncoding(QStringConverter::Encoding::Utf8);
 
+	logMutex = new QMutex();
 	mutex = new QMutex();
+	sendMutex = new QMutex();
+	sendReady = new QWaitCondition();
+	deadlineChanged = new QWaitCondition();
+	sharedMutex = new QMutex();
+	// 在 GUI 线程创建，使事件与异步结果经队列连接送达
+	Notifier::Instance();
+
+	negotiate();
+
+	auto record = qEnvironmentVariable("IPC_RECORD");
+	if (!record.isEmpty()) {
+		if (StartRecording(record)) {
+			qAddPostRoutine(StopRecording);
+		} else {
+			SendLogMessage("ipc: cannot record to " + record);
+		}
+	}
+
+	receiver = QThread::create(receiveLoop);
+	receiver->start();
+	writer = QThread::create(writeLoop);
+	writer->start();
+	watchdog = QThread::create(deadlineLoop);
+	watchdog->start();
+}
+
+// 以按行 JSON 发送协商请求，服务端回复后切换到帧传输
+// 服务端以 -ipc=line 启动时继续使用按行 JSON，便于调试
+// 回复的 data.shm 只表示是否启用共享内存，按普通 JSON 解码，不经共享内存
+void ipc::negotiate() {
+	QJsonObject data;
+	data["encodings"] = QJsonArray{"cbor", "json"};
+	data["compression"] = QJsonArray{"zlib"};
+	if (openSharedMemory()) {
+		QJsonObject shm;
+		shm["path"] = QDir::toNativeSeparators(sharedFile->fileName());
+		shm["size"] = sharedMemorySize;
+		data["shm"] = shm;
+	}
+	QJsonObject wrap;
+	wrap["action"] = "ipc_negotiate";
+	wrap["data"] = data;
+	SendRpcMessage(QJsonDocument(wrap).toJson(QJsonDocument::Compact));
+	auto reply = decodeObject(ReceiveRpcMessage())["data"].toObject();
+	framed = reply["framed"].toBool();
+	if (framed && reply["encoding"].toString() == "cbor") {
+		encoding = Encoding::Cbor;
+	}
+	compressed = framed && reply["compression"].toString() == "zlib";
+	if (sharedMemory != nullptr && !reply["shm"].toBool()) {
+		closeSharedMemory();
+	}
+}
+
+bool ipc::openSharedMemory() {
+	sharedFile = new QTemporaryFile(QDir::tempPath() +
+									"/graduation-ipc-XXXXXX.shm");
+	if (sharedFile->open() && sharedFile->resize(sharedMemorySize)) {
+		sharedMemory = sharedFile->map(0, sharedMemorySize);
+	}
+	if (sharedMemory == nullptr) {
+		SendLogMessage("ipc: shared memory unavailable: " +
+					   sharedFile->errorString());
+		closeSharedMemory();
+		return false;
+	}
+	qAddPostRoutine(closeSharedMemory);
+	return true;
+}
+
+void ipc::closeSharedMemory() {
+	QMutexLocker locker(sharedMutex);
+	if (sharedMemory != nullptr) {
+		sharedFile->unmap(sharedMemory);
+		sharedMemory = nullptr;
+	}
+	delete sharedFile;
+	sharedFile = nullptr;
+}
+
+void ipc::throwError(RpcErrorKind kind, const QString &message) {
+	throw RpcError{kind, QString(), message};
+}
+
+void ipc::readFully(char *data, qint64 size) {
+	while (size > 0) {
+		auto n = std::fread(data, 1, size, stdin);
+		if (n == 0) {
+			throwError(RpcErrorKind::Disconnected, "ipc: stdin closed");
+		}
+		data += n;
+		size -= n;
+	}
+}
+
+void ipc::writeFully(const char *data, qint64 size) {
+	if (std::fwrite(data, 1, size, stdout) != size_t(size)) {
+		throwError(RpcErrorKind::Disconnected, "ipc: stdout closed");
+	}
+}
+
+QByteArray ipc::readLine() {
+	QByteArray line;
+	while (line.isEmpty()) {
+		int c;
+		while ((c = std::fgetc(stdin)) != '\n') {
+			if (c == EOF) {
+				throwError(RpcErrorKind::Disconnected, "ipc: stdin closed");
+			}
+			line.append(char(c));
+		}
+		if (line.endsWith('\r')) {
+			line.chop(1);
+		}
+	}
+	return line;
+}
+
+QByteArray ipc::ReceiveRpcMessage() {
+	return receiveMessage(nullptr);
 }
 
-QString ipc::ReceiveRpcMessage() {
-	QString msg;
-	do {
-		msg = stdinStream->readLine();
-	} while (msg.isEmpty());
-	return msg;
+// wireBytes 非空时写入管道上读取的字节数，压缩的帧解压后返回
+QByteArray ipc::receiveMessage(qint64 *wireBytes) {
+	if (!framed) {
+		auto line = readLine();
+		if (wireBytes != nullptr) {
+			*wireBytes = line.size();
+		}
+		return line;
+	}
+	char header[frameHeaderSize];
+	readFully(header, frameHeaderSize);
+	auto length = qFromBigEndian<quint32>(header);
+	bool packed = (length & frameCompressedFlag) != 0;
+	length &= ~frameCompressedFlag;
+	QByteArray msg(length, Qt::Uninitialized);
+	readFully(msg.data(), length);
+	if (wireBytes != nullptr) {
+		*wireBytes = length;
+	}
+	if (!packed) {
+		return msg;
+	}
+	if (!compressed) {
+		throwError(RpcErrorKind::Protocol, "ipc: unexpected compressed frame");
+	}
+	auto unpacked = qUncompress(msg);
+	if (unpacked.isEmpty()) {
+		throwError(RpcErrorKind::Protocol, "ipc: malformed compressed frame");
+	}
+	return unpacked;
+}
+
+// 写入线程启动后只入队，由写入线程按入队顺序写出
+void ipc::SendRpcMessage(const QByteArray &msg) {
+	if (writer == nullptr) {
+		writeMessage(msg);
+		return;
+	}
+	QMutexLocker locker(sendMutex);
+	sendQueue.enqueue(msg);
+	sendReady->wakeOne();
 }
 
-void ipc::SendRpcMessage(QString msg) {
-	*stdoutStream << msg << "\n";
-	stdoutStream->flush();
+void ipc::writeMessage(const QByteArray &msg) {
+	if (framed) {
+		char header[frameHeaderSize];
+		qToBigEndian<quint32>(msg.size(), header);
+		writeFully(header, frameHeaderSize);
+		writeFully(msg.constData(), msg.size());
+	} else {
+		writeFully(msg.constData(), msg.size());
+		writeFully("\n", 1);
+	}
+	std::fflush(stdout);
 }
 
 void ipc::SendLogMessage(QString msg) {
+	QMutexLocker locker(logMutex);
 	*stderrStream << msg << "\n";
 	stderrStream->flush();
 }
 
-ipc::Response ipc::RpcRequest(QString req) {
-	QMutexLocker locker(mutex);
-	SendRpcMessage(req);
-	QString resp = ReceiveRpcMessage();
-	locker.unlock();
-	QJsonParseError err;
-	auto doc = QJsonDocument::fromJson(resp.toUtf8(), &err);
-	if (err.error != QJsonParseError::NoError) {
-		throw err.errorString();
+QByteArray ipc::EncodeMessage(const QJsonObject &msg) {
+	if (encoding == Encoding::Cbor) {
+		return QCborValue::fromJsonValue(msg).toCbor();
 	}
+	return QJsonDocument(msg).toJson(QJsonDocument::Compact);
+}
+
+ipc::Response ipc::DecodeResponse(const QByteArray &msg) {
+	return decodeResponse(msg, nullptr, nullptr);
+}
+
+// 解码响应；streaming(id) 为真时 data 不构建 DOM，保留在 Payload 中
+// CBOR 传输下流式读取信封，data 只记录位置，避免整条消息解码两次
+// data 经共享内存传输时信封中没有 data，而以 shm_ref 给出其位置
+// sharedBytes 非空时写入经共享内存传输的字节数
+ipc::Response ipc::decodeResponse(const QByteArray &msg,
+								  bool (*streaming)(qint64),
+								  qint64 *sharedBytes) {
 	Response response;
-	response.ResponseCode = doc.object()["code"].toInt();
-	response.Data = doc.object()["data"].toObject();
+	response.RequestId = 0;
+	response.ResponseCode = 0;
+	QByteArray data;
+	QJsonObject ref;
+	if (encoding == Encoding::Cbor) {
+		QCborStreamReader reader(msg);
+		if (reader.isMap()) {
+			reader.enterContainer();
+			while (reader.lastError() == QCborError::NoError &&
+				   reader.hasNext()) {
+				auto key = streamString(reader);
+				if (key == "id") {
+					response.RequestId = streamInteger(reader);
+				} else if (key == "code") {
+					response.ResponseCode = streamInteger(reader);
+				} else if (key == "event") {
+					response.Event = streamString(reader);
+				} else if (key == "data") {
+					auto begin = reader.currentOffset();
+					reader.next();
+					data = QByteArray::fromRawData(msg.constData() + begin,
+												   reader.currentOffset() -
+													   begin);
+				} else if (key == "shm_ref") {
+					auto begin = reader.currentOffset();
+					reader.next();
+					ref = decodeObject(msg.mid(begin,
+											   reader.currentOffset() - begin));
+				} else {
+					reader.next();
+				}
+			}
+			reader.leaveContainer();
+		}
+		if (reader.lastError() != QCborError::NoError) {
+			throwError(RpcErrorKind::Protocol, reader.lastError().toString());
+		}
+	} else {
+		auto object = decodeObject(msg);
+		response.RequestId = object["id"].toInteger();
+		response.ResponseCode = object["code"].toInt();
+		response.Data = object["data"].toObject();
+		response.Event = object["event"].toString();
+		ref = object["shm_ref"].toObject();
+	}
+
+	bool raw = encoding == Encoding::Cbor && streaming != nullptr &&
+			   streaming(response.RequestId);
+	if (raw && data.size() >= smallDataSize) {
+		response.Payload = QByteArray(data.constData(), data.size());
+		return response;
+	}
+	if (!data.isEmpty()) {
+		response.Data = decodeObject(data);
+	}
+	if (ref.isEmpty()) {
+		return response;
+	}
+	if (sharedMemory == nullptr) {
+		throwError(RpcErrorKind::Protocol,
+				   "ipc: unexpected shared memory reference");
+	}
+	// 直接在映射区域上解码，完成后标记已读取，服务端即可复用这段空间
+	// 流式解码的 Payload 同样引用映射区域，由调用方解码完成、响应销毁后释放
+	auto blob = sharedMemoryBlob(ref);
+	auto end = quint64(ref["end"].toInteger());
+	if (sharedBytes != nullptr) {
+		*sharedBytes = blob.size();
+	}
+	holdSharedMemory(end);
+	if (raw) {
+		response.Data = QJsonObject();
+		response.Payload = blob;
+		response.SharedRegion = std::shared_ptr<void>(
+			nullptr, [end](void *) { releaseSharedMemory(end); });
+		return response;
+	}
+	try {
+		response.Data = decodeObject(blob);
+	} catch (...) {
+		releaseSharedMemory(end);
+		throw;
+	}
+	releaseSharedMemory(end);
 	return response;
-}
\ No newline at end of file
+}
+
+QJsonObject ipc::decodeObject(const QByteArray &msg) {
+	if (encoding == Encoding::Cbor) {
+		QCborParserError err;
+		auto value = QCborValue::fromCbor(msg, &err);
+		if (err.error != QCborError::NoError) {
+			throwError(RpcErrorKind::Protocol, err.errorString());
+		}
+		return value.toMap().toJsonObject();
+	}
+	QJsonParseError err;
+	auto doc = QJsonDocument::fromJson(msg, &err);
+	if (err.error != QJsonParseError::NoError) {
+		throwError(RpcErrorKind::Protocol, err.errorString());
+	}
+	return doc.object();
+}
+
+QList<ipc::Response> ipc::SplitBatchResponse(const Response &resp,
+											 const QList<bool> &streaming) {
+	QList<Response> results;
+	if (resp.Payload.isEmpty()) {
+		for (auto value : resp.Data["results"].toArray()) {
+			Response sub;
+			sub.RequestId = resp.RequestId;
+			sub.ResponseCode = value.toObject()["code"].toInt();
+			sub.Data = value.toObject()["data"].toObject();
+			results << sub;
+		}
+		return results;
+	}
+	QCborStreamReader reader(resp.Payload);
+	try {
+		if (reader.isMap()) {
+			reader.enterContainer();
+			while (reader.lastError() == QCborError::NoError &&
+				   reader.hasNext()) {
+				if (streamString(reader) != "results" || !reader.isArray()) {
+					reader.next();
+					continue;
+				}
+				reader.enterContainer();
+				while (reader.lastError() == QCborError::NoError &&
+					   reader.hasNext()) {
+					auto sub = streamBatchResult(
+						resp.Payload, reader, streaming.value(results.size()));
+					sub.RequestId = resp.RequestId;
+					results << sub;
+				}
+				reader.leaveContainer();
+			}
+			reader.leaveContainer();
+		}
+	} catch (const RpcError &err) {
+		SendLogMessage("ipc: malformed batch result: " + err.message);
+		return results;
+	}
+	if (reader.lastError() != QCborError::NoError) {
+		SendLogMessage("ipc: malformed batch response: " +
+					   reader.lastError().toString());
+	}
+	return results;
+}
+
+// 与 decodeResponse 相同，data 只记录位置，较大时不构建 DOM
+ipc::Response ipc::streamBatchResult(const QByteArray &payload,
+									 QCborStreamReader &reader,
+									 bool streaming) {
+	Response sub;
+	sub.RequestId = 0;
+	sub.ResponseCode = 0;
+	if (!reader.isMap()) {
+		sub.ResponseCode = -1;
+		reader.next();
+		return sub;
+	}
+	reader.enterContainer();
+	while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+		auto key = streamString(reader);
+		if (key == "code") {
+			sub.ResponseCode = streamInteger(reader);
+		} else if (key == "data") {
+			auto begin = reader.currentOffset();
+			reader.next();
+			auto data = QByteArray::fromRawData(
+				payload.constData() + begin, reader.currentOffset() - begin);
+			if (streaming && data.size() >= smallDataSize) {
+				sub.Payload = QByteArray(data.constData(), data.size());
+			} else {
+				sub.Data = decodeObject(data);
+			}
+		} else {
+			reader.next();
+		}
+	}
+	reader.leaveContainer();
+	return sub;
+}
+
+bool ipc::isStreamingRequest(qint64 id) {
+	QMutexLocker locker(mutex);
+	return pendingRequests.value(id).streaming;
+}
+
+// 返回的字节数组直接引用映射区域，不复制
+QByteArray ipc::sharedMemoryBlob(const QJsonObject &ref) {
+	auto offset = ref["offset"].toInteger();
+	auto length = ref["length"].toInteger();
+	if (offset < 0 || length < 0 || offset + length > sharedMemorySize) {
+		throwError(RpcErrorKind::Protocol,
+				   "ipc: invalid shared memory reference");
+	}
+	return QByteArray::fromRawData(
+		reinterpret_cast<const char *>(sharedMemory + offset), length);
+}
+
+void ipc::holdSharedMemory(quint64 end) {
+	QMutexLocker locker(sharedMutex);
+	sharedBlobs[end] = false;
+}
+
+void ipc::releaseSharedMemory(quint64 end) {
+	QMutexLocker locker(sharedMutex);
+	sharedBlobs[end] = true;
+	quint64 readPos = 0;
+	while (!sharedBlobs.isEmpty() && sharedBlobs.first()) {
+		readPos = sharedBlobs.firstKey();
+		sharedBlobs.erase(sharedBlobs.begin());
+	}
+	// 程序退出时映射可能已解除
+	if (readPos != 0 && sharedMemory != nullptr) {
+		qToLittleEndian<quint64>(readPos, sharedMemory + sharedReadPosOffset);
+	}
+}
+
+// 接收线程：读取响应并按请求 id 完成对应的请求，响应可以乱序到达
+void ipc::receiveLoop() {
+	try {
+		for (;;) {
+			qint64 wireBytes = 0;
+			auto msg = receiveMessage(&wireBytes);
+			Response resp;
+			qint64 sharedBytes = 0;
+			QElapsedTimer decode;
+			decode.start();
+			try {
+				resp = decodeResponse(msg, isStreamingRequest, &sharedBytes);
+			} catch (const RpcError &err) {
+				SendLogMessage("ipc: drop malformed response: " + err.message);
+				continue;
+			}
+			auto decodeNs = decode.nsecsElapsed();
+			if (IsRecording()) {
+				recordResponse(resp);
+			}
+			if (!resp.Event.isEmpty()) {
+				dispatchEvent(resp);
+				continue;
+			}
+			PendingRequest pending;
+			{
+				QMutexLocker locker(mutex);
+				pending = pendingRequests.take(resp.RequestId);
+			}
+			if (!pending.decode) {
+				SendLogMessage(
+					QString("ipc: drop response %1").arg(resp.RequestId));
+				continue;
+			}
+			RecordResponse(pending.action, wireBytes + sharedBytes,
+						   pending.timer.nsecsElapsed() - decodeNs);
+			// 只有压缩后变小的帧才会压缩发送
+			if (wireBytes != msg.size()) {
+				RecordCompression(pending.action, wireBytes, msg.size());
+			}
+			RecordDecode(pending.action, decodeNs);
+			resp.Action = pending.action;
+			pending.token.detach(pending.id);
+			completeRequest(pending, resp);
+		}
+	} catch (const RpcError &err) {
+		// 管道关闭或帧无法解析，之后的消息无法分帧，等待中的请求以该原因失败
+		QList<PendingRequest> failed;
+		{
+			QMutexLocker locker(mutex);
+			receiverError = err;
+			failed = pendingRequests.values();
+			pendingRequests.clear();
+		}
+		for (auto &pending : failed) {
+			RecordFailure(pending.action);
+			pending.token.detach(pending.id);
+			failRequest(pending, {err.kind, pending.action, err.message});
+		}
+	}
+}
+
+// 写入线程：按入队顺序写出请求；stdout 关闭时退出，等待中的请求由接收线程
+// 在 stdin 关闭时失败
+void ipc::writeLoop() {
+	try {
+		for (;;) {
+			QByteArray msg;
+			{
+				QMutexLocker locker(sendMutex);
+				while (sendQueue.isEmpty()) {
+					sendReady->wait(sendMutex);
+				}
+				msg = sendQueue.dequeue();
+			}
+			writeMessage(msg);
+		}
+	} catch (const RpcError &err) {
+		SendLogMessage(err.message);
+	}
+}
+
+// 在当前线程解码，只把交付函数送回 GUI 线程
+void ipc::completeRequest(const PendingRequest &pending,
+						  const Response &resp) {
+	auto deliver = pending.decode(resp);
+	if (!deliver) {
+		return;
+	}
+	auto context = pending.context;
+	QMetaObject::invokeMethod(
+		Notifier::Instance(),
+		[context, deliver] {
+			if (context && deliver) {
+				deliver();
+			}
+		},
+		Qt::QueuedConnection);
+}
+
+void ipc::failRequest(const PendingRequest &pending, const RpcError &error) {
+	if (error.kind != RpcErrorKind::Cancelled) {
+		SendLogMessage(error.message);
+	}
+	Response resp;
+	resp.RequestId = pending.id;
+	resp.ResponseCode = -1;
+	resp.Action = pending.action;
+	resp.Error = error.kind;
+	completeRequest(pending, resp);
+}
+
+// 放弃等待中的请求：以 kind 失败，并通知服务端不再处理
+// 服务端对 ipc_cancel 不作响应，之后到达的响应按未知 id 丢弃
+void ipc::abandonRequests(const QList<qint64> &ids, RpcErrorKind kind) {
+	QList<PendingRequest> abandoned;
+	QJsonArray cancel;
+	{
+		QMutexLocker locker(mutex);
+		for (auto id : ids) {
+			auto it = pendingRequests.find(id);
+			if (it == pendingRequests.end()) {
+				continue;
+			}
+			abandoned << it.value();
+			pendingRequests.erase(it);
+			cancel.append(id);
+		}
+		if (!cancel.isEmpty() && receiverError.kind == RpcErrorKind::None) {
+			QJsonObject data;
+			data["ids"] = cancel;
+			QJsonObject wrap;
+			wrap["action"] = "ipc_cancel";
+			wrap["data"] = data;
+			SendRpcMessage(EncodeMessage(wrap));
+			if (IsRecording()) {
+				RecordMessage("request", wrap);
+			}
+		}
+	}
+	auto reason = kind == RpcErrorKind::Timeout ? "timed out" : "cancelled";
+	for (auto &pending : abandoned) {
+		RecordFailure(pending.action);
+		pending.token.detach(pending.id);
+		failRequest(pending, {kind, pending.action,
+							  QString("ipc: %1 %2 %3")
+								  .arg(pending.action)
+								  .arg(pending.id)
+								  .arg(reason)});
+	}
+}
+
+void ipc::deadlineLoop() {
+	QMutexLocker locker(mutex);
+	for (;;) {
+		QDeadlineTimer next(QDeadlineTimer::Forever);
+		QList<qint64> expired;
+		for (auto it = pendingRequests.constBegin();
+			 it != pendingRequests.constEnd(); ++it) {
+			if (it->deadline.hasExpired()) {
+				expired << it.key();
+			} else if (it->deadline < next) {
+				next = it->deadline;
+			}
+		}
+		if (expired.isEmpty()) {
+			deadlineChanged->wait(mutex, next);
+			continue;
+		}
+		locker.unlock();
+		abandonRequests(expired, RpcErrorKind::Timeout);
+		locker.relock();
+	}
+}
+
+struct ipc::CancelToken::State {
+	QMutex mutex;
+	bool cancelled = false;
+	// 使用该令牌、尚未完成的请求
+	QSet<qint64> ids;
+};
+
+ipc::CancelToken ipc::CancelToken::Create() {
+	CancelToken token;
+	token.state = std::make_shared<State>();
+	return token;
+}
+
+void ipc::CancelToken::Cancel() {
+	if (!state) {
+		return;
+	}
+	QList<qint64> ids;
+	{
+		QMutexLocker locker(&state->mutex);
+		if (state->cancelled) {
+			return;
+		}
+		state->cancelled = true;
+		ids = state->ids.values();
+		state->ids.clear();
+	}
+	abandonRequests(ids, RpcErrorKind::Cancelled);
+}
+
+bool ipc::CancelToken::IsCancelled() const {
+	if (!state) {
+		return false;
+	}
+	QMutexLocker locker(&state->mutex);
+	return state->cancelled;
+}
+
+bool ipc::CancelToken::attach(qint64 id) {
+	if (!state) {
+		return true;
+	}
+	QMutexLocker locker(&state->mutex);
+	if (state->cancelled) {
+		return false;
+	}
+	state->ids.insert(id);
+	return true;
+}
+
+void ipc::CancelToken::detach(qint64 id) {
+	if (!state) {
+		return;
+	}
+	QMutexLocker locker(&state->mutex);
+	state->ids.remove(id);
+}
+
+// 流式解码请求的 data 保留为原始编码，记录时另行解码
+void ipc::recordResponse(const Response &resp) {
+	QJsonObject msg;
+	if (resp.Event.isEmpty()) {
+		msg["id"] = resp.RequestId;
+		msg["code"] = resp.ResponseCode;
+	} else {
+		msg["event"] = resp.Event;
+	}
+	try {
+		msg["data"] =
+			resp.Payload.isEmpty() ? resp.Data : decodeObject(resp.Payload);
+	} catch (const RpcError &err) {
+		SendLogMessage("ipc: cannot record response: " + err.message);
+		return;
+	}
+	RecordMessage(resp.Event.isEmpty() ? "response" : "event", msg);
+}
+
+void ipc::dispatchEvent(const Response &event) {
+	auto notifier = Notifier::Instance();
+	auto id = event.Data["id"].toString();
+	if (event.Event == "production_parse_finished") {
+		emit notifier->productionParseFinished(id);
+	} else if (event.Event == "process_paused") {
+		emit notifier->processPaused(id);
+	} else if (event.Event == "process_exited") {
+		emit notifier->processExited(id);
+	} else {
+		SendLogMessage("ipc: unknown event " + event.Event);
+	}
+}
+
+// 分配请求 id 并交给写入线程；接收线程已退出或令牌已取消时请求直接失败
+void ipc::sendRequest(const QJsonObject &req, PendingRequest request,
+					  const CallOptions &options) {
+	request.action = req["action"].toString();
+	request.token = options.token;
+	if (options.timeout >= 0) {
+		request.deadline.setRemainingTime(options.timeout);
+	}
+	QElapsedTimer queue;
+	queue.start();
+	QMutexLocker locker(mutex);
+	auto queueNs = queue.nsecsElapsed();
+	if (receiverError.kind != RpcErrorKind::None) {
+		auto error = receiverError;
+		error.action = request.action;
+		locker.unlock();
+		failRequest(request, error);
+		return;
+	}
+	auto id = nextRequestId++;
+	if (!request.token.attach(id)) {
+		locker.unlock();
+		failRequest(request, {RpcErrorKind::Cancelled, request.action,
+							  "ipc: " + request.action + " cancelled"});
+		return;
+	}
+	auto wrap = req;
+	wrap["id"] = id;
+	auto msg = EncodeMessage(wrap);
+	if (IsRecording()) {
+		RecordMessage("request", wrap);
+	}
+	auto &pending = pendingRequests[id];
+	pending = request;
+	pending.id = id;
+	pending.timer.start();
+	SendRpcMessage(msg);
+	RecordRequest(pending.action, msg.size(), queueNs);
+	if (!pending.deadline.isForever()) {
+		deadlineChanged->wakeOne();
+	}
+}
+
+void ipc::RpcRequestAsync(const QJsonObject &req, QObject *context,
+						  Decoder decode, bool streaming,
+						  const CallOptions &options) {
+	PendingRequest request;
+	request.decode = decode;
+	request.context = context;
+	request.streaming = streaming;
+	sendRequest(req, request, options);
+}
@@ -1,14 +1,68 @@
 #pragma once
 
 #include "types.h"
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
 #include <QString>
+#include <functional>
+#include <memory>
 
 namespace ipc {
 
+	enum class Encoding { Json, Cbor };
+
+	// 不限时：会话的新建、运行与释放可能耗时很长，默认不设超时
+	// 需要超时的调用方在 CallOptions 中显式指定（毫秒）
+	constexpr int NoTimeout = -1;
+
+	// 取消令牌：可由多个请求共享，复制后指向同一状态
+	// Cancel 后等待中的请求以 Cancelled 失败，并通知服务端放弃未完成的处理；
+	// 之后使用该令牌的请求直接失败
+	// 默认构造的令牌为空，不分配状态，Cancel 无效果；可取消的令牌由 Create 创建
+	class CancelToken {
+	public:
+		static CancelToken Create();
+		void Cancel();
+		bool IsCancelled() const;
+
+		// 由 base.cpp 登记与注销使用该令牌的请求；已取消时 attach 返回 false
+		bool attach(qint64 id);
+		void detach(qint64 id);
+
+	private:
+		struct State;
+		std::shared_ptr<State> state;
+	};
+
+	// 单次请求的选项；timeout 为负数时不限时
+	struct CallOptions {
+		int timeout = NoTimeout;
+		CancelToken token;
+	};
+
 	void Init();
-	QString ReceiveRpcMessage();
-	void SendRpcMessage(QString);
+	QByteArray ReceiveRpcMessage();
+	void SendRpcMessage(const QByteArray &);
 	void SendLogMessage(QString);
 
-	ipc::Response RpcRequest(QString);
-} // namespace ipc
\ No newline at end of file
+	QByteArray EncodeMessage(const QJsonObject &);
+	ipc::Response DecodeResponse(const QByteArray &);
+
+	// 请求都是异步的，GUI 线程不等待响应
+	// 解码函数在接收线程把响应解码为结构体，返回交付函数；
+	// 交付函数经队列连接在 GUI 线程执行，context 已销毁时丢弃，为空时不交付
+	// 请求失败时以 ResponseCode = -1 的响应调用，Error 为失败原因
+	// streaming 为 true 时，CBOR 传输下较大的 data 不解码为 Data，
+	// 而是以原始编码保存在 Payload 中，由解码函数流式解码
+	using Decoder = std::function<std::function<void()>(const Response &)>;
+	void RpcRequestAsync(const QJsonObject &, QObject *context,
+						 Decoder decode, bool streaming = false,
+						 const CallOptions &options = CallOptions());
+
+	// 拆分 batch 响应中各子请求的结果；streaming[i] 为真的子请求在 CBOR
+	// 传输下保留较大的 data 为 Payload
+	QList<ipc::Response> SplitBatchResponse(const Response &,
+											const QList<bool> &streaming);
+} // namespace ipc
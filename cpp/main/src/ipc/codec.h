@@ -0,0 +1,471 @@
+#pragma once
+
+#include "schema.h"
+#include "stream.h"
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QLatin1String>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <type_traits>
+#include <utility>
+
+// 由 schema.h 生成的编码与解码，按类型在编译期展开，不经过中间 DOM：
+// CBOR 以 QCborStreamReader/QCborStreamWriter 单次遍历字节流，
+// 长度已知的数组与映射预先分配容器；JSON 直接读写 QJsonValue
+// 解码时缺少的字段保持原值，出现的字段整体替换；结构体字段就地解码，
+// 符号表追加新符号，Patch 字段还可以是列表增量
+// 在 ParallelDecode 作用域内，较大的结构体列表在线程池中并行解码
+namespace ipc {
+	namespace codec {
+		// 出错后 QCborStreamReader 不再前进，据此结束循环
+		inline bool hasNext(QCborStreamReader &reader) {
+			return reader.lastError() == QCborError::NoError &&
+				   reader.hasNext();
+		}
+
+		template <typename T, typename = void> struct Codec;
+
+		// 读取器所读的字节数组，并行解码时据此按偏移量重新读取元素
+		// 工作线程中为空，嵌套的列表在所在的块内顺序解码
+		inline thread_local const QByteArray *parallelSource = nullptr;
+
+		// 元素数与字节数均达到阈值的列表才拆分，小文法仍走顺序解码
+		constexpr qint64 ParallelMinItems = 256;
+		constexpr qint64 ParallelMinBytes = 64 << 10;
+		constexpr qint64 ParallelChunkBytes = 16 << 10;
+
+		// 第一遍只跳过元素并记下起始位置，再按字节数分块，
+		// 各块以独立的读取器解码，直接写入预先分配的元素；返回 false 时未读取
+		template <typename T>
+		bool readCborParallel(QCborStreamReader &reader, QList<T> *out) {
+			auto source = parallelSource;
+			if (source == nullptr || !reader.isLengthKnown() ||
+				reader.length() < ParallelMinItems) {
+				return false;
+			}
+			QList<qint64> offsets;
+			offsets.reserve(reader.length() + 1);
+			reader.enterContainer();
+			while (hasNext(reader)) {
+				offsets.append(reader.currentOffset());
+				reader.next();
+			}
+			offsets.append(reader.currentOffset());
+			reader.leaveContainer();
+			if (reader.lastError() != QCborError::NoError) {
+				return true;
+			}
+
+			auto count = offsets.size() - 1;
+			auto bytes = offsets.last() - offsets.first();
+			out->resize(count);
+			auto items = out->data();
+			auto decode = [&](const std::pair<qsizetype, qsizetype> &range) {
+				auto saved = std::exchange(parallelSource, nullptr);
+				auto begin = offsets[range.first];
+				QCborStreamReader chunk(QByteArray::fromRawData(
+					source->constData() + begin, offsets[range.second] - begin));
+				for (auto i = range.first; i < range.second; i++) {
+					Codec<T>::readCbor(chunk, &items[i]);
+				}
+				parallelSource = saved;
+			};
+			if (bytes < ParallelMinBytes) {
+				decode({0, count});
+				return true;
+			}
+			auto chunks = qBound<qint64>(1, bytes / ParallelChunkBytes,
+										 QThread::idealThreadCount() * 4);
+			QList<std::pair<qsizetype, qsizetype>> ranges;
+			qsizetype first = 0;
+			for (qsizetype i = 1; i <= count; i++) {
+				auto filled = offsets[i] - offsets[first];
+				if (i == count || filled * chunks >= bytes) {
+					ranges.append({first, i});
+					first = i;
+				}
+			}
+			QtConcurrent::blockingMap(ranges, decode);
+			return true;
+		}
+
+		template <> struct Codec<int> {
+			static void readJson(const QJsonValue &value, int *out) {
+				*out = value.toInt();
+			}
+			static void readCbor(QCborStreamReader &reader, int *out) {
+				*out = int(streamInteger(reader));
+			}
+			static QJsonValue writeJson(int value) {
+				return value;
+			}
+			static void writeCbor(QCborStreamWriter &writer, int value) {
+				writer.append(qint64(value));
+			}
+		};
+
+		template <> struct Codec<bool> {
+			static void readJson(const QJsonValue &value, bool *out) {
+				*out = value.toBool();
+			}
+			static void readCbor(QCborStreamReader &reader, bool *out) {
+				*out = streamBool(reader);
+			}
+			static QJsonValue writeJson(bool value) {
+				return value;
+			}
+			static void writeCbor(QCborStreamWriter &writer, bool value) {
+				writer.append(value);
+			}
+		};
+
+		template <> struct Codec<QString> {
+			static void readJson(const QJsonValue &value, QString *out) {
+				*out = value.toString();
+			}
+			static void readCbor(QCborStreamReader &reader, QString *out) {
+				*out = streamString(reader);
+			}
+			static QJsonValue writeJson(const QString &value) {
+				return value;
+			}
+			static void writeCbor(QCborStreamWriter &writer,
+								  const QString &value) {
+				writer.append(value);
+			}
+		};
+
+		// 映射的键：服务端以十进制字符串作为符号编号的键
+		template <typename K> struct Key;
+		template <> struct Key<QString> {
+			static QString decode(const QString &key) {
+				return key;
+			}
+			static QString encode(const QString &key) {
+				return key;
+			}
+		};
+		template <> struct Key<Symbol> {
+			static Symbol decode(const QString &key) {
+				return key.toInt();
+			}
+			static QString encode(Symbol key) {
+				return QString::number(key);
+			}
+		};
+
+		template <typename T> struct Codec<QList<T>> {
+			static void readJson(const QJsonValue &value, QList<T> *out) {
+				out->clear();
+				auto array = value.toArray();
+				out->reserve(array.size());
+				for (auto item : array) {
+					Codec<T>::readJson(item, &out->emplaceBack());
+				}
+			}
+			static void readCbor(QCborStreamReader &reader, QList<T> *out) {
+				out->clear();
+				if (!reader.isArray()) {
+					reader.next();
+					return;
+				}
+				if constexpr (!std::is_arithmetic_v<T>) {
+					if (readCborParallel(reader, out)) {
+						return;
+					}
+				}
+				if (reader.isLengthKnown()) {
+					out->reserve(reader.length());
+				}
+				reader.enterContainer();
+				while (hasNext(reader)) {
+					Codec<T>::readCbor(reader, &out->emplaceBack());
+				}
+				reader.leaveContainer();
+			}
+			static QJsonValue writeJson(const QList<T> &value) {
+				QJsonArray array;
+				for (auto &item : value) {
+					array.append(Codec<T>::writeJson(item));
+				}
+				return array;
+			}
+			static void writeCbor(QCborStreamWriter &writer,
+								  const QList<T> &value) {
+				writer.startArray(value.size());
+				for (auto &item : value) {
+					Codec<T>::writeCbor(writer, item);
+				}
+				writer.endArray();
+			}
+
+			// 增量：调整到新长度后替换 index 处的元素
+			static void patchJson(const QJsonObject &patch, QList<T> *out) {
+				auto length = patch["length"].toInt();
+				auto index = patch["index"].toArray();
+				auto items = patch["items"].toArray();
+				out->resize(length);
+				for (int i = 0; i < index.size() && i < items.size(); i++) {
+					auto at = index[i].toInt();
+					if (at >= 0 && at < length) {
+						(*out)[at] = T();
+						Codec<T>::readJson(items[i], &(*out)[at]);
+					}
+				}
+			}
+			static void patchCbor(QCborStreamReader &reader, QList<T> *out) {
+				qint64 length = out->size();
+				QList<int> index;
+				QList<T> items;
+				reader.enterContainer();
+				while (hasNext(reader)) {
+					auto key = streamString(reader);
+					if (key == QLatin1String("length")) {
+						length = streamInteger(reader);
+					} else if (key == QLatin1String("index")) {
+						Codec<QList<int>>::readCbor(reader, &index);
+					} else if (key == QLatin1String("items")) {
+						readCbor(reader, &items);
+					} else {
+						reader.next();
+					}
+				}
+				reader.leaveContainer();
+				out->resize(length);
+				for (int i = 0; i < index.size() && i < items.size(); i++) {
+					if (index[i] >= 0 && index[i] < length) {
+						(*out)[index[i]] = std::move(items[i]);
+					}
+				}
+			}
+		};
+
+		template <typename K, typename T> struct Codec<QHash<K, T>> {
+			static void readJson(const QJsonValue &value, QHash<K, T> *out) {
+				out->clear();
+				auto object = value.toObject();
+				out->reserve(object.size());
+				for (auto it = object.constBegin(); it != object.constEnd();
+					 ++it) {
+					Codec<T>::readJson(it.value(),
+									   &(*out)[Key<K>::decode(it.key())]);
+				}
+			}
+			static void readCbor(QCborStreamReader &reader,
+								 QHash<K, T> *out) {
+				out->clear();
+				if (!reader.isMap()) {
+					reader.next();
+					return;
+				}
+				if (reader.isLengthKnown()) {
+					out->reserve(reader.length());
+				}
+				reader.enterContainer();
+				while (hasNext(reader)) {
+					auto key = Key<K>::decode(streamString(reader));
+					Codec<T>::readCbor(reader, &(*out)[key]);
+				}
+				reader.leaveContainer();
+			}
+			static QJsonValue writeJson(const QHash<K, T> &value) {
+				QJsonObject object;
+				for (auto it = value.constBegin(); it != value.constEnd();
+					 ++it) {
+					object.insert(Key<K>::encode(it.key()),
+								  Codec<T>::writeJson(it.value()));
+				}
+				return object;
+			}
+			static void writeCbor(QCborStreamWriter &writer,
+								  const QHash<K, T> &value) {
+				writer.startMap(value.size());
+				for (auto it = value.constBegin(); it != value.constEnd();
+					 ++it) {
+					writer.append(Key<K>::encode(it.key()));
+					Codec<T>::writeCbor(writer, it.value());
+				}
+				writer.endMap();
+			}
+		};
+
+		// 符号表只发送新增的符号，解码时追加在已有符号之后
+		template <> struct Codec<SymbolTable> {
+			static void readJson(const QJsonValue &value, SymbolTable *out) {
+				for (auto item : value.toArray()) {
+					out->append(item.toString());
+				}
+			}
+			static void readCbor(QCborStreamReader &reader,
+								 SymbolTable *out) {
+				if (!reader.isArray()) {
+					reader.next();
+					return;
+				}
+				reader.enterContainer();
+				while (hasNext(reader)) {
+					out->append(streamString(reader));
+				}
+				reader.leaveContainer();
+			}
+			static QJsonValue writeJson(const SymbolTable &value) {
+				return Codec<QStringList>::writeJson(value.names);
+			}
+			static void writeCbor(QCborStreamWriter &writer,
+								  const SymbolTable &value) {
+				Codec<QStringList>::writeCbor(writer, value.names);
+			}
+		};
+
+		template <typename M> struct IsList : std::false_type {};
+		template <typename T> struct IsList<QList<T>> : std::true_type {};
+
+		template <typename M>
+		void readField(const QJsonValue &value, FieldKind kind, M *out) {
+			if constexpr (IsList<M>::value) {
+				if (kind == FieldKind::Patch && value.isObject()) {
+					Codec<M>::patchJson(value.toObject(), out);
+					return;
+				}
+			}
+			Codec<M>::readJson(value, out);
+		}
+
+		template <typename M>
+		void readField(QCborStreamReader &reader, FieldKind kind, M *out) {
+			if constexpr (IsList<M>::value) {
+				if (kind == FieldKind::Patch && reader.isMap()) {
+					Codec<M>::patchCbor(reader, out);
+					return;
+				}
+			}
+			Codec<M>::readCbor(reader, out);
+		}
+
+		// 登记在 schema.h 中的结构体：逐个字段展开
+		template <typename T>
+		struct Codec<T, std::enable_if_t<Schema<T>::defined>> {
+			static void readJson(const QJsonValue &value, T *out) {
+				auto object = value.toObject();
+				std::apply(
+					[&](const auto &...fields) {
+						(readJsonField(object, fields, out), ...);
+					},
+					Schema<T>::fields);
+			}
+			static void readCbor(QCborStreamReader &reader, T *out) {
+				if (!reader.isMap()) {
+					reader.next();
+					return;
+				}
+				reader.enterContainer();
+				while (hasNext(reader)) {
+					auto key = streamString(reader);
+					bool known = std::apply(
+						[&](const auto &...fields) {
+							return (readCborField(reader, key, fields, out) ||
+									...);
+						},
+						Schema<T>::fields);
+					if (!known) {
+						reader.next();
+					}
+				}
+				reader.leaveContainer();
+			}
+			static QJsonValue writeJson(const T &value) {
+				QJsonObject object;
+				std::apply(
+					[&](const auto &...fields) {
+						(object.insert(QLatin1String(fields.key),
+									   writeJsonField(value, fields)),
+						 ...);
+					},
+					Schema<T>::fields);
+				return object;
+			}
+			static void writeCbor(QCborStreamWriter &writer, const T &value) {
+				writer.startMap(std::tuple_size_v<decltype(Schema<T>::fields)>);
+				std::apply(
+					[&](const auto &...fields) {
+						(writeCborField(writer, value, fields), ...);
+					},
+					Schema<T>::fields);
+				writer.endMap();
+			}
+
+		private:
+			template <typename F>
+			static void readJsonField(const QJsonObject &object,
+									  const F &field, T *out) {
+				auto it = object.constFind(QLatin1String(field.key));
+				if (it != object.constEnd()) {
+					readField(it.value(), field.kind, &field.get(*out));
+				}
+			}
+			template <typename F>
+			static bool readCborField(QCborStreamReader &reader,
+									  const QString &key, const F &field,
+									  T *out) {
+				if (key != QLatin1String(field.key)) {
+					return false;
+				}
+				readField(reader, field.kind, &field.get(*out));
+				return true;
+			}
+			template <typename F>
+			static QJsonValue writeJsonField(const T &value, const F &field) {
+				using M = std::decay_t<decltype(field.get(value))>;
+				return Codec<M>::writeJson(field.get(value));
+			}
+			template <typename F>
+			static void writeCborField(QCborStreamWriter &writer,
+									   const T &value, const F &field) {
+				using M = std::decay_t<decltype(field.get(value))>;
+				writer.append(QLatin1String(field.key));
+				Codec<M>::writeCbor(writer, field.get(value));
+			}
+		};
+	} // namespace codec
+
+	// 以下为对外接口，T 为 types.h 中的结构体或其容器
+	template <typename T> void DecodeJson(const QJsonValue &value, T *out) {
+		codec::Codec<T>::readJson(value, out);
+	}
+
+	template <typename T> void DecodeCbor(QCborStreamReader &reader, T *out) {
+		codec::Codec<T>::readCbor(reader, out);
+	}
+
+	// 作用域内以 DecodeCbor 读取 payload 时，较大的列表并行解码
+	// 读取器须读取同一个 payload，且 payload 在作用域内不变
+	class ParallelDecode {
+	public:
+		explicit ParallelDecode(const QByteArray &payload)
+			: saved(std::exchange(codec::parallelSource, &payload)) {
+		}
+		~ParallelDecode() {
+			codec::parallelSource = saved;
+		}
+		ParallelDecode(const ParallelDecode &) = delete;
+		ParallelDecode &operator=(const ParallelDecode &) = delete;
+
+	private:
+		const QByteArray *saved;
+	};
+
+	template <typename T> QJsonValue EncodeJson(const T &value) {
+		return codec::Codec<T>::writeJson(value);
+	}
+
+	template <typename T>
+	void EncodeCbor(QCborStreamWriter &writer, const T &value) {
+		codec::Codec<T>::writeCbor(writer, value);
+	}
+} // namespace ipc
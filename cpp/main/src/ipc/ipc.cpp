@@ -1,313 +1,613 @@
 #include "ipc.h"
 #include "base.h"
-#include "util.h"
-#include <QJsonDocument>
+#include "codec.h"
+#include "notifier.h"
+#include "stats.h"
+#include <QHash>
+#include <QJsonArray>
 #include <QJsonObject>
+#include <QMutex>
+#include <QPointer>
 
-QString ipc::ProductionParseStart(QString code) {
-	QJsonObject data;
-	data["code"] = code;
-	QJsonObject wrap;
-	wrap["action"] = "production_parse_start";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	return resp.Data["id"].toString();
+// 只发送、不等待响应的请求；请求失败时由 base.cpp 记录日志
+static void postRequest(const QJsonObject &req) {
+	ipc::RpcRequestAsync(req, nullptr,
+						 [](const ipc::Response &) -> std::function<void()> {
+							 return nullptr;
+						 });
 }
 
-bool ipc::ProductionParseQuery(QString id, ProductionResult *result) {
-	QJsonObject data;
-	data["id"] = id;
-	QJsonObject wrap;
-	wrap["action"] = "production_parse_query";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+static bool decodeProductionResult(const ipc::Response &resp,
+								   ipc::ProductionResult *result) {
 	if (resp.ResponseCode != 0) {
 		return false;
 	}
-	ipc::parseArrayString(resp.Data["terminal"].toArray(), &result->terminals);
-	ipc::parseArrayString(resp.Data["nonterminal"].toArray(),
-						  &result->nonterminals);
-	ipc::parseArrayArrayString(resp.Data["productions"].toArray(),
-							   &result->productions);
-	ipc::parseErrors(resp.Data["errors"].toObject()["fatal"].toArray(),
-					 &result->fatals);
-	ipc::parseErrors(resp.Data["errors"].toObject()["error"].toArray(),
-					 &result->errors);
-	ipc::parseErrors(resp.Data["errors"].toObject()["warning"].toArray(),
-					 &result->warnings);
+	ipc::DecodeTimer timer(resp.Action);
+	auto errors = resp.Data["errors"].toObject();
+	ipc::DecodeJson(resp.Data["terminal"], &result->terminals);
+	ipc::DecodeJson(resp.Data["nonterminal"], &result->nonterminals);
+	ipc::DecodeJson(resp.Data["productions"], &result->productions);
+	ipc::DecodeJson(errors["fatal"], &result->fatals);
+	ipc::DecodeJson(errors["error"], &result->errors);
+	ipc::DecodeJson(errors["warning"], &result->warnings);
+	result->revision = resp.Data["revision"].toInt();
 	return true;
 }
 
-void ipc::ProductionParseCancel(QString id) {
-	QJsonObject data;
-	data["id"] = id;
-	QJsonObject wrap;
-	wrap["action"] = "production_parse_cancel";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+// *_process_variables 的响应：未暂停时返回 false
+template <typename T>
+static bool decodeVariables(const ipc::Response &resp, T *variables,
+							ipc::Breakpoint *point) {
+	if (resp.ResponseCode != 0) {
+		return false;
+	}
+	ipc::DecodeTimer timer(resp.Action);
+	ipc::DecodeJson(resp.Data["var"], variables);
+	ipc::DecodeJson(resp.Data["point"], point);
+	return true;
 }
 
-QString ipc::LLProcessRequest(QString code, bool withTranslate,
-							  QString savePath) {
-	QJsonObject data;
-	data["code"] = code;
-	data["with_translate"] = withTranslate;
-	data["save_path"] = savePath;
-	QJsonObject wrap;
-	wrap["action"] = "ll_process_request";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	return resp.Data["id"].toString();
+// *_process_exit 的响应：未退出时返回 false
+// 流式请求的响应带有 Payload 时流式解码
+template <typename T>
+static bool decodeExitResult(const ipc::Response &resp, T *exitResult) {
+	if (resp.ResponseCode != 0) {
+		return false;
+	}
+	if (exitResult == nullptr) {
+		return true;
+	}
+	ipc::DecodeTimer timer(resp.Action);
+	if (resp.Payload.isEmpty()) {
+		ipc::DecodeJson(resp.Data, exitResult);
+		return true;
+	}
+	ipc::ParallelDecode parallel(resp.Payload);
+	QCborStreamReader reader(resp.Payload);
+	ipc::DecodeCbor(reader, exitResult);
+	if (reader.lastError() != QCborError::NoError) {
+		ipc::SendLogMessage("ipc: malformed exit result: " +
+							reader.lastError().toString());
+		return false;
+	}
+	return true;
 }
 
-void ipc::LLProcessSwitchMode(QString id, int mode) {
+static QJsonObject makeIdRequest(const char *action, QString id) {
 	QJsonObject data;
 	data["id"] = id;
-	data["mode"] = mode;
 	QJsonObject wrap;
-	wrap["action"] = "ll_process_switchmode";
+	wrap["action"] = action;
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+	return wrap;
 }
 
-void ipc::LLProcessRelease(QString id) {
-	QJsonObject data;
-	data["id"] = id;
-	QJsonObject wrap;
-	wrap["action"] = "ll_process_release";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+// 客户端持有的断点变量快照；请求时带上序号，服务端只发送变化的部分
+// version 为快照所在的埋点版本，服务端版本未变时只回复 unchanged
+template <typename T> struct VariablesCache {
+	qint64 seq = 0;
+	qint64 version = 0;
+	T variables;
+	ipc::Breakpoint point;
+};
+template <typename T>
+using VariablesCacheMap = QHash<QString, VariablesCache<T>>;
+
+static VariablesCacheMap<ipc::LR0BreakpointVariables> lr0Variables;
+static VariablesCacheMap<ipc::LR1BreakpointVariables> lr1Variables;
+// 异步响应在接收线程应用增量，与 GUI 线程的请求、释放互斥
+static QMutex variablesMutex;
+
+// 符号表随会话累积，不因完整快照而重置
+template <typename T> static void resetVariables(T *variables) {
+	auto symbols = variables->symbols;
+	*variables = T();
+	variables->symbols = symbols;
 }
 
-void ipc::LLProcessSetBreakpoints(QString id, QList<Breakpoint> breakpoints) {
-	QJsonArray array;
-	for (auto &breakpoint : breakpoints) {
-		QJsonObject o;
-		o["name"] = breakpoint.name;
-		o["line"] = breakpoint.line;
-		array.append(o);
-	}
-	QJsonObject data;
-	data["id"] = id;
-	data["breakpoints"] = array;
-	QJsonObject wrap;
-	wrap["action"] = "ll_process_setbreakpoints";
+// LR 的退出结果以符号编号发送，符号表完整附带
+static QJsonObject makeExitRequest(const char *action, QString id) {
+	auto wrap = makeIdRequest(action, id);
+	auto data = wrap["data"].toObject();
+	data["symbols"] = 0;
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+	return wrap;
 }
 
-bool ipc::LLProcessGetVariables(QString id, LLBreakpointVariables *variables,
-								Breakpoint *point) {
+template <typename T>
+static QJsonObject makeVariablesRequest(const char *action, QString id,
+										VariablesCacheMap<T> *cache) {
+	QMutexLocker locker(&variablesMutex);
 	QJsonObject data;
 	data["id"] = id;
+	data["delta"] = true;
+	data["base"] = (*cache)[id].seq;
+	data["if_newer_than"] = (*cache)[id].version;
+	data["symbols"] = (*cache)[id].variables.symbols.names.size();
 	QJsonObject wrap;
-	wrap["action"] = "ll_process_variables";
+	wrap["action"] = action;
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	if (resp.ResponseCode == 1003) {
+	return wrap;
+}
+
+// 流式应用增量，失败时返回 false
+// 服务端按键名排序输出 base、point、seq、var，应用 var 前已确认基准；
+// unchanged 响应只有 unchanged 与 version，缓存原样保留
+template <typename T>
+static bool streamVariablesDelta(const QByteArray &payload,
+								 VariablesCache<T> *entry) {
+	ipc::ParallelDecode parallel(payload);
+	QCborStreamReader reader(payload);
+	if (!reader.isMap()) {
+		return false;
+	}
+	bool based = false;
+	reader.enterContainer();
+	while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+		auto key = ipc::streamString(reader);
+		if (key == "base") {
+			auto base = ipc::streamInteger(reader);
+			if (base == 0) {
+				resetVariables(&entry->variables);
+			} else if (base != entry->seq) {
+				ipc::SendLogMessage(
+					QString("ipc: drop variables delta %1, have %2")
+						.arg(base)
+						.arg(entry->seq));
+				return false;
+			}
+			based = true;
+		} else if (key == "seq") {
+			entry->seq = ipc::streamInteger(reader);
+		} else if (key == "version") {
+			entry->version = ipc::streamInteger(reader);
+		} else if (key == "point") {
+			ipc::DecodeCbor(reader, &entry->point);
+		} else if (key == "symbols") {
+			ipc::DecodeCbor(reader, &entry->variables.symbols);
+		} else if (key == "var") {
+			if (!based) {
+				ipc::SendLogMessage("ipc: variables delta without base");
+				return false;
+			}
+			ipc::DecodeCbor(reader, &entry->variables);
+		} else {
+			reader.next();
+		}
+	}
+	reader.leaveContainer();
+	if (reader.lastError() != QCborError::NoError) {
+		ipc::SendLogMessage("ipc: malformed variables delta: " +
+							reader.lastError().toString());
 		return false;
 	}
-	ipc::parseLLVariables(resp.Data["var"].toObject(), variables);
-	point->name = resp.Data["point"].toObject()["name"].toString();
-	point->line = resp.Data["point"].toObject()["line"].toInt();
 	return true;
 }
 
-bool ipc::LLProcessExit(QString id, LLExitResult *exitResult) {
-	QJsonObject data;
-	data["id"] = id;
-	QJsonObject wrap;
-	wrap["action"] = "ll_process_exit";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	if (resp.ResponseCode == 1004) {
+// 增量的 *_process_variables 响应：在缓存上原地应用后复制给调用方
+// 会话已释放或基准不符时丢弃缓存并返回 false，下次请求完整快照
+template <typename T>
+static bool decodeVariablesDelta(const ipc::Response &resp, QString id,
+								 VariablesCacheMap<T> *cache, T *variables,
+								 ipc::Breakpoint *point) {
+	QMutexLocker locker(&variablesMutex);
+	if (resp.ResponseCode != 0 || !cache->contains(id)) {
 		return false;
 	}
-	if (exitResult != nullptr) {
-		parseLLExitResult(resp.Data, exitResult);
+	auto &entry = (*cache)[id];
+	if (!resp.Payload.isEmpty()) {
+		ipc::DecodeTimer timer(resp.Action);
+		if (!streamVariablesDelta(resp.Payload, &entry)) {
+			cache->remove(id);
+			return false;
+		}
+		*variables = entry.variables;
+		*point = entry.point;
+		return true;
 	}
+	if (resp.Data["unchanged"].toBool()) {
+		*variables = entry.variables;
+		*point = entry.point;
+		return true;
+	}
+	auto base = resp.Data["base"].toInteger();
+	if (base == 0) {
+		resetVariables(&entry.variables);
+	} else if (base != entry.seq) {
+		ipc::SendLogMessage(QString("ipc: drop variables delta %1, have %2")
+								.arg(base)
+								.arg(entry.seq));
+		cache->remove(id);
+		return false;
+	}
+	entry.seq = resp.Data["seq"].toInteger();
+	entry.version = resp.Data["version"].toInteger();
+	ipc::DecodeJson(resp.Data["symbols"], &entry.variables.symbols);
+	decodeVariables(resp, &entry.variables, &entry.point);
+	*variables = entry.variables;
+	*point = entry.point;
 	return true;
 }
 
-QString ipc::LR0ProcessRequest(QString code, bool slr, QString savePath) {
-	QJsonObject data;
-	data["code"] = code;
-	data["slr"] = slr;
-	data["save_path"] = savePath;
-	QJsonObject wrap;
-	wrap["action"] = "lr0_process_request";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+// 文档解析的响应，带有提交的文本版本
+static QString parseStarted(const ipc::Response &resp, int *revision) {
+	if (resp.ResponseCode != 0) {
+		return QString();
+	}
+	if (revision != nullptr) {
+		*revision = resp.Data["revision"].toInt();
+	}
 	return resp.Data["id"].toString();
 }
 
-void ipc::LR0ProcessSwitchMode(QString id, int mode) {
-	QJsonObject data;
-	data["id"] = id;
-	data["mode"] = mode;
-	QJsonObject wrap;
-	wrap["action"] = "lr0_process_switchmode";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+static void startParse(const QJsonObject &req, QObject *context,
+					   ipc::ParseCallback callback) {
+	auto decode = [callback](const ipc::Response &resp)
+		-> std::function<void()> {
+		int revision = 0;
+		auto id = parseStarted(resp, &revision);
+		return [callback, id, revision] { callback(id, revision); };
+	};
+	ipc::RpcRequestAsync(req, context, decode);
 }
 
-void ipc::LR0ProcessRelease(QString id) {
+void ipc::ProductionParseStart(QString code, QString document,
+							   QObject *context, ParseCallback callback) {
 	QJsonObject data;
-	data["id"] = id;
+	data["code"] = code;
+	if (!document.isEmpty()) {
+		data["document"] = document;
+	}
 	QJsonObject wrap;
-	wrap["action"] = "lr0_process_release";
+	wrap["action"] = "production_parse_start";
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+	startParse(wrap, context, callback);
 }
 
-void ipc::LR0ProcessSetBreakpoints(QString id, QList<Breakpoint> breakpoints) {
-	QJsonArray array;
-	for (auto &breakpoint : breakpoints) {
-		QJsonObject o;
-		o["name"] = breakpoint.name;
-		o["line"] = breakpoint.line;
-		array.append(o);
-	}
+void ipc::ProductionParseEdit(QString document, const QList<TextEdit> &edits,
+							  int length, QObject *context,
+							  ParseCallback callback) {
 	QJsonObject data;
-	data["id"] = id;
-	data["breakpoints"] = array;
+	data["document"] = document;
+	data["edits"] = EncodeJson(edits);
+	data["length"] = length;
 	QJsonObject wrap;
-	wrap["action"] = "lr0_process_setbreakpoints";
+	wrap["action"] = "production_parse_start";
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+	startParse(wrap, context, callback);
 }
 
-bool ipc::LR0ProcessGetVariables(QString id, LR0BreakpointVariables *variables,
-								 Breakpoint *point) {
+void ipc::ProductionDocumentClose(QString document) {
 	QJsonObject data;
-	data["id"] = id;
+	data["document"] = document;
 	QJsonObject wrap;
-	wrap["action"] = "lr0_process_variables";
+	wrap["action"] = "production_document_close";
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	if (resp.ResponseCode == 1003) {
-		return false;
-	}
-	ipc::parseLR0Variables(resp.Data["var"].toObject(), variables);
-	point->name = resp.Data["point"].toObject()["name"].toString();
-	point->line = resp.Data["point"].toObject()["line"].toInt();
-	return true;
+	postRequest(wrap);
 }
 
-bool ipc::LR0ProcessExit(QString id, LR0ExitResult *exitResult) {
+void ipc::ProductionParseQueryAsync(QString id, QObject *context,
+									ResultCallback<ProductionResult> callback,
+									const CallOptions &options) {
+	auto decode = [callback](const Response &resp) -> std::function<void()> {
+		ProductionResult result;
+		bool ok = decodeProductionResult(resp, &result);
+		return [callback, ok, result] { callback(ok, result); };
+	};
+	RpcRequestAsync(makeIdRequest("production_parse_query", id), context,
+					decode, false, options);
+}
+
+void ipc::ProductionParseCancel(QString id) {
 	QJsonObject data;
 	data["id"] = id;
 	QJsonObject wrap;
-	wrap["action"] = "lr0_process_exit";
+	wrap["action"] = "production_parse_cancel";
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	if (resp.ResponseCode == 1004) {
-		return false;
-	}
-	if (exitResult != nullptr) {
-		parseLR0ExitResult(resp.Data, exitResult);
-	}
-	return true;
+	postRequest(wrap);
 }
 
-QString ipc::LR1ProcessRequest(QString code, bool lalr, QString savePath) {
+static QJsonObject makeProcessRequest(const char *action, QString code,
+									  const char *flag, bool value,
+									  QString savePath) {
 	QJsonObject data;
 	data["code"] = code;
-	data["lalr"] = lalr;
+	data[flag] = value;
 	data["save_path"] = savePath;
 	QJsonObject wrap;
-	wrap["action"] = "lr1_process_request";
+	wrap["action"] = action;
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	return resp.Data["id"].toString();
+	return wrap;
 }
 
-void ipc::LR1ProcessSwitchMode(QString id, int mode) {
-	QJsonObject data;
-	data["id"] = id;
+static QJsonObject makeSwitchModeRequest(const char *action, QString id,
+										 int mode) {
+	auto wrap = makeIdRequest(action, id);
+	auto data = wrap["data"].toObject();
 	data["mode"] = mode;
-	QJsonObject wrap;
-	wrap["action"] = "lr1_process_switchmode";
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+	return wrap;
 }
 
-void ipc::LR1ProcessRelease(QString id) {
-	QJsonObject data;
-	data["id"] = id;
-	QJsonObject wrap;
-	wrap["action"] = "lr1_process_release";
+static QJsonObject
+makeBreakpointsRequest(const char *action, QString id,
+					   const QList<ipc::Breakpoint> &breakpoints) {
+	auto wrap = makeIdRequest(action, id);
+	auto data = wrap["data"].toObject();
+	data["breakpoints"] = ipc::EncodeJson(breakpoints);
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+	return wrap;
+}
+
+// 异步与批量请求共用的解码函数，在接收线程解码，回调随交付函数执行
+static ipc::Decoder llVariablesDecoder(
+	ipc::VariablesCallback<ipc::LLBreakpointVariables> callback) {
+	return [callback](const ipc::Response &resp) -> std::function<void()> {
+		ipc::LLBreakpointVariables variables;
+		ipc::Breakpoint point;
+		bool paused = decodeVariables(resp, &variables, &point);
+		return [callback, paused, variables, point] {
+			callback(paused, variables, point);
+		};
+	};
+}
+
+template <typename T>
+static ipc::Decoder
+variablesDeltaDecoder(QString id, VariablesCacheMap<T> *cache,
+					  ipc::VariablesCallback<T> callback) {
+	return [=](const ipc::Response &resp) -> std::function<void()> {
+		T variables;
+		ipc::Breakpoint point;
+		bool paused =
+			decodeVariablesDelta(resp, id, cache, &variables, &point);
+		return [callback, paused, variables, point] {
+			callback(paused, variables, point);
+		};
+	};
+}
+
+template <typename T>
+static ipc::Decoder exitResultDecoder(ipc::ResultCallback<T> callback) {
+	return [=](const ipc::Response &resp) -> std::function<void()> {
+		T result;
+		bool exit = decodeExitResult(resp, &result);
+		return [callback, exit, result] { callback(exit, result); };
+	};
+}
+
+void ipc::LLProcessRelease(QString id) {
+	postRequest(makeIdRequest("ll_process_release", id));
+}
+
+void ipc::LLProcessGetVariablesAsync(
+	QString id, QObject *context,
+	VariablesCallback<LLBreakpointVariables> callback,
+	const CallOptions &options) {
+	RpcRequestAsync(makeIdRequest("ll_process_variables", id), context,
+					llVariablesDecoder(callback), false, options);
 }
 
-void ipc::LR1ProcessSetBreakpoints(QString id, QList<Breakpoint> breakpoints) {
-	QJsonArray array;
-	for (auto &breakpoint : breakpoints) {
-		QJsonObject o;
-		o["name"] = breakpoint.name;
-		o["line"] = breakpoint.line;
-		array.append(o);
+void ipc::LLProcessExitAsync(QString id, QObject *context,
+							 ResultCallback<LLExitResult> callback) {
+	RpcRequestAsync(makeIdRequest("ll_process_exit", id), context,
+					exitResultDecoder(callback));
+}
+
+void ipc::LR0ProcessRelease(QString id) {
+	{
+		QMutexLocker locker(&variablesMutex);
+		lr0Variables.remove(id);
 	}
-	QJsonObject data;
-	data["id"] = id;
-	data["breakpoints"] = array;
-	QJsonObject wrap;
-	wrap["action"] = "lr1_process_setbreakpoints";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
+	postRequest(makeIdRequest("lr0_process_release", id));
 }
 
-bool ipc::LR1ProcessGetVariables(QString id, LR1BreakpointVariables *variables,
-								 Breakpoint *point) {
-	QJsonObject data;
-	data["id"] = id;
-	QJsonObject wrap;
-	wrap["action"] = "lr1_process_variables";
-	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	if (resp.ResponseCode == 1003) {
-		return false;
+void ipc::LR0ProcessGetVariablesAsync(
+	QString id, QObject *context,
+	VariablesCallback<LR0BreakpointVariables> callback,
+	const CallOptions &options) {
+	auto req = makeVariablesRequest("lr0_process_variables", id, &lr0Variables);
+	RpcRequestAsync(req, context,
+					variablesDeltaDecoder(id, &lr0Variables, callback),
+					true, options);
+}
+
+void ipc::LR0ProcessExitAsync(QString id, QObject *context,
+							  ResultCallback<LR0ExitResult> callback) {
+	RpcRequestAsync(makeExitRequest("lr0_process_exit", id), context,
+					exitResultDecoder(callback),
+					true);
+}
+
+void ipc::LR1ProcessRelease(QString id) {
+	{
+		QMutexLocker locker(&variablesMutex);
+		lr1Variables.remove(id);
 	}
-	ipc::parseLR1Variables(resp.Data["var"].toObject(), variables);
-	point->name = resp.Data["point"].toObject()["name"].toString();
-	point->line = resp.Data["point"].toObject()["line"].toInt();
-	return true;
+	postRequest(makeIdRequest("lr1_process_release", id));
+}
+
+void ipc::LR1ProcessGetVariablesAsync(
+	QString id, QObject *context,
+	VariablesCallback<LR1BreakpointVariables> callback,
+	const CallOptions &options) {
+	auto req = makeVariablesRequest("lr1_process_variables", id, &lr1Variables);
+	RpcRequestAsync(req, context,
+					variablesDeltaDecoder(id, &lr1Variables, callback),
+					true, options);
+}
+
+void ipc::LR1ProcessExitAsync(QString id, QObject *context,
+							  ResultCallback<LR1ExitResult> callback) {
+	RpcRequestAsync(makeExitRequest("lr1_process_exit", id), context,
+					exitResultDecoder(callback),
+					true);
 }
 
-bool ipc::LR1ProcessExit(QString id, LR1ExitResult *exitResult) {
+void ipc::Batch::add(QJsonObject request, bool streaming, Decoder decode) {
+	auto data = request["data"].toObject();
+	if (data["id"].toString().isEmpty() && created >= 0) {
+		request["id_from"] = created;
+	}
+	entries << Entry{request, streaming, decode};
+}
+
+void ipc::Batch::LLProcessRequest(QString code, bool withTranslate,
+								  QString savePath) {
+	created = entries.size();
+	releaseAction = "ll_process_release";
+	add(makeProcessRequest("ll_process_request", code, "with_translate",
+						   withTranslate, savePath));
+}
+
+void ipc::Batch::LLProcessSwitchMode(QString id, int mode) {
+	add(makeSwitchModeRequest("ll_process_switchmode", id, mode));
+}
+
+void ipc::Batch::LLProcessSetBreakpoints(QString id,
+										 QList<Breakpoint> breakpoints) {
+	add(makeBreakpointsRequest("ll_process_setbreakpoints", id, breakpoints));
+}
+
+void ipc::Batch::LLProcessGetVariables(
+	QString id, VariablesCallback<LLBreakpointVariables> callback) {
+	add(makeIdRequest("ll_process_variables", id), false,
+		llVariablesDecoder(callback));
+}
+
+void ipc::Batch::LR0ProcessRequest(QString code, bool slr, QString savePath) {
+	created = entries.size();
+	releaseAction = "lr0_process_release";
+	add(makeProcessRequest("lr0_process_request", code, "slr", slr, savePath));
+}
+
+void ipc::Batch::LR0ProcessSwitchMode(QString id, int mode) {
+	add(makeSwitchModeRequest("lr0_process_switchmode", id, mode));
+}
+
+void ipc::Batch::LR0ProcessSetBreakpoints(QString id,
+										  QList<Breakpoint> breakpoints) {
+	add(makeBreakpointsRequest("lr0_process_setbreakpoints", id, breakpoints));
+}
+
+void ipc::Batch::LR0ProcessGetVariables(
+	QString id, VariablesCallback<LR0BreakpointVariables> callback) {
+	add(makeVariablesRequest("lr0_process_variables", id, &lr0Variables), true,
+		variablesDeltaDecoder(id, &lr0Variables, callback));
+}
+
+void ipc::Batch::LR1ProcessRequest(QString code, bool lalr, QString savePath) {
+	created = entries.size();
+	releaseAction = "lr1_process_release";
+	add(makeProcessRequest("lr1_process_request", code, "lalr", lalr,
+						   savePath));
+}
+
+void ipc::Batch::LR1ProcessSwitchMode(QString id, int mode) {
+	add(makeSwitchModeRequest("lr1_process_switchmode", id, mode));
+}
+
+void ipc::Batch::LR1ProcessSetBreakpoints(QString id,
+										  QList<Breakpoint> breakpoints) {
+	add(makeBreakpointsRequest("lr1_process_setbreakpoints", id, breakpoints));
+}
+
+void ipc::Batch::LR1ProcessGetVariables(
+	QString id, VariablesCallback<LR1BreakpointVariables> callback) {
+	add(makeVariablesRequest("lr1_process_variables", id, &lr1Variables), true,
+		variablesDeltaDecoder(id, &lr1Variables, callback));
+}
+
+bool ipc::Batch::isEmpty() const { return entries.isEmpty(); }
+
+QJsonObject ipc::Batch::request() const {
+	QJsonArray requests;
+	for (auto &entry : entries) {
+		requests.append(entry.request);
+	}
 	QJsonObject data;
-	data["id"] = id;
+	data["requests"] = requests;
 	QJsonObject wrap;
-	wrap["action"] = "lr1_process_exit";
+	wrap["action"] = "batch";
 	wrap["data"] = data;
-	auto req = QJsonDocument(wrap).toJson(QJsonDocument::Compact);
-	auto resp = RpcRequest(req);
-	if (resp.ResponseCode == 1004) {
-		return false;
+	return wrap;
+}
+
+bool ipc::Batch::streaming() const {
+	for (auto &entry : entries) {
+		if (entry.streaming) {
+			return true;
+		}
 	}
-	if (exitResult != nullptr) {
-		parseLR1ExitResult(resp.Data, exitResult);
+	return false;
+}
+
+// 解码各子请求的结果，返回按添加顺序执行回调的交付函数
+// 批量请求失败或结果缺失的子请求以 ResponseCode = -1 解码
+std::function<void()> ipc::Batch::decode(const Response &resp,
+										 QString *id) const {
+	QList<bool> streaming;
+	for (auto &entry : entries) {
+		streaming << entry.streaming;
 	}
-	return true;
-}
\ No newline at end of file
+	QList<Response> results;
+	if (resp.ResponseCode == 0) {
+		results = SplitBatchResponse(resp, streaming);
+	}
+	QList<std::function<void()>> delivers;
+	for (int i = 0; i < entries.size(); i++) {
+		Response sub;
+		sub.RequestId = resp.RequestId;
+		sub.ResponseCode = -1;
+		sub.Error = resp.Error;
+		if (i < results.size()) {
+			sub = results[i];
+		}
+		sub.Action = entries[i].request["action"].toString();
+		if (i == created && sub.ResponseCode == 0) {
+			*id = sub.Data["id"].toString();
+		}
+		if (entries[i].decode) {
+			delivers << entries[i].decode(sub);
+		}
+	}
+	return [delivers] {
+		for (auto &deliver : delivers) {
+			deliver();
+		}
+	};
+}
+
+void ipc::Batch::SendAsync(QObject *context, const CallOptions &options) {
+	SendAsync(context, nullptr, options);
+}
+
+void ipc::Batch::SendAsync(QObject *context, CreatedCallback onCreated,
+						   const CallOptions &options) {
+	if (entries.isEmpty()) {
+		return;
+	}
+	// 经 Notifier 交付，context 已销毁时仍能释放新建的会话
+	auto batch = *this;
+	QPointer<QObject> owner(context);
+	auto decode = [batch, owner,
+				   onCreated](const Response &resp) -> std::function<void()> {
+		QString id;
+		auto deliver = batch.decode(resp, &id);
+		auto release = batch.releaseAction;
+		return [owner, onCreated, id, deliver, release] {
+			if (!owner) {
+				if (!id.isEmpty() && release != nullptr) {
+					postRequest(makeIdRequest(release, id));
+				}
+				return;
+			}
+			if (onCreated) {
+				onCreated(id);
+			}
+			deliver();
+		};
+	};
+	RpcRequestAsync(request(), Notifier::Instance(), decode, streaming(),
+					options);
+}
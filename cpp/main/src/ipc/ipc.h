@@ -1,36 +1,124 @@
 #pragma once
 
+#include "base.h"
 #include "types.h"
+#include <QJsonObject>
 #include <QList>
+#include <QObject>
 #include <QString>
 #include <QStringList>
+#include <functional>
 
 namespace ipc {
-	QString ProductionParseStart(QString code);
-	bool ProductionParseQuery(QString id, ProductionResult *result);
+	// 接口都是异步的，GUI 线程不等待响应
+	// 带回调的接口在接收线程解码，回调在 GUI 线程执行，context 已销毁时不回调；
+	// 请求失败、超时或取消时以 false 回调
+	// 不带回调的接口（取消、释放、关闭文档）只发送请求，失败时记录日志
+	template <typename T>
+	using ResultCallback = std::function<void(bool, const T &)>;
+	template <typename T>
+	using VariablesCallback =
+		std::function<void(bool, const T &, const Breakpoint &)>;
+	// 解析已排队：id 为文档编号，revision 为本次文本的版本；失败时 id 为空
+	using ParseCallback = std::function<void(const QString &id, int revision)>;
+
+	// document 非空时服务端保存全文，之后以 ProductionParseEdit 只发送编辑
+	// 文档的解析由服务端排队，查询只返回最新版本的结果
+	void ProductionParseStart(QString code, QString document, QObject *context,
+							  ParseCallback callback);
+	// 在服务端保存的文档上应用编辑后解析，length 为编辑后的 UTF-8 字节数
+	// 文档不存在或与客户端不一致时以空 id 回调，应以 ProductionParseStart
+	// 发送全文；服务端并行处理请求，同一文档的编辑须在上次回调后再发送
+	void ProductionParseEdit(QString document, const QList<TextEdit> &edits,
+							 int length, QObject *context,
+							 ParseCallback callback);
+	void ProductionDocumentClose(QString document);
+	void ProductionParseQueryAsync(QString id, QObject *context,
+								   ResultCallback<ProductionResult> callback,
+								   const CallOptions &options = CallOptions());
 	void ProductionParseCancel(QString id);
 
-	QString LLProcessRequest(QString code, bool withTranslate, QString savePath = QString());
-	void LLProcessSwitchMode(QString id, int mode);
 	void LLProcessRelease(QString id);
-	void LLProcessSetBreakpoints(QString id, QList<Breakpoint> breakpoints);
-	bool LLProcessGetVariables(QString id, LLBreakpointVariables *variables,
-							   Breakpoint *point);
-	bool LLProcessExit(QString id, LLExitResult *exitResult);
+	void LLProcessGetVariablesAsync(
+		QString id, QObject *context,
+		VariablesCallback<LLBreakpointVariables> callback,
+		const CallOptions &options = CallOptions());
+	void LLProcessExitAsync(QString id, QObject *context,
+							ResultCallback<LLExitResult> callback);
 
-	QString LR0ProcessRequest(QString code, bool slr, QString savePath = QString());
-	void LR0ProcessSwitchMode(QString id, int mode);
 	void LR0ProcessRelease(QString id);
-	void LR0ProcessSetBreakpoints(QString id, QList<Breakpoint> breakpoints);
-	bool LR0ProcessGetVariables(QString id, LR0BreakpointVariables *variables,
-								Breakpoint *point);
-	bool LR0ProcessExit(QString id, LR0ExitResult *exitResult);
+	void LR0ProcessGetVariablesAsync(
+		QString id, QObject *context,
+		VariablesCallback<LR0BreakpointVariables> callback,
+		const CallOptions &options = CallOptions());
+	void LR0ProcessExitAsync(QString id, QObject *context,
+							 ResultCallback<LR0ExitResult> callback);
 
-	QString LR1ProcessRequest(QString code, bool lalr, QString savePath = QString());
-	void LR1ProcessSwitchMode(QString id, int mode);
 	void LR1ProcessRelease(QString id);
-	void LR1ProcessSetBreakpoints(QString id, QList<Breakpoint> breakpoints);
-	bool LR1ProcessGetVariables(QString id, LR1BreakpointVariables *variables,
-								Breakpoint *point);
-	bool LR1ProcessExit(QString id, LR1ExitResult *exitResult);
+	void LR1ProcessGetVariablesAsync(
+		QString id, QObject *context,
+		VariablesCallback<LR1BreakpointVariables> callback,
+		const CallOptions &options = CallOptions());
+	void LR1ProcessExitAsync(QString id, QObject *context,
+							 ResultCallback<LR1ExitResult> callback);
+
+	// 批量请求：子请求合并为一次往返，服务端在一次分派中按顺序执行
+	// 会话 id 为空的子请求作用于本批量中此前新建的会话
+	// 在接收线程解码后于 GUI 线程回调：先以新建会话的 id 回调 onCreated
+	// （新建失败时 id 为空），再按添加顺序执行子请求的回调；
+	// 子请求失败时以 false 回调；context 在回调前销毁时不回调，
+	// 并释放本批量中新建的会话
+	class Batch {
+	public:
+		using CreatedCallback = std::function<void(const QString &id)>;
+
+		void LLProcessRequest(QString code, bool withTranslate,
+							  QString savePath = QString());
+		void LLProcessSwitchMode(QString id, int mode);
+		void LLProcessSetBreakpoints(QString id, QList<Breakpoint> breakpoints);
+		void LLProcessGetVariables(
+			QString id, VariablesCallback<LLBreakpointVariables> callback);
+
+		void LR0ProcessRequest(QString code, bool slr,
+							   QString savePath = QString());
+		void LR0ProcessSwitchMode(QString id, int mode);
+		void LR0ProcessSetBreakpoints(QString id,
+									  QList<Breakpoint> breakpoints);
+		void LR0ProcessGetVariables(
+			QString id, VariablesCallback<LR0BreakpointVariables> callback);
+
+		void LR1ProcessRequest(QString code, bool lalr,
+							   QString savePath = QString());
+		void LR1ProcessSwitchMode(QString id, int mode);
+		void LR1ProcessSetBreakpoints(QString id,
+									  QList<Breakpoint> breakpoints);
+		void LR1ProcessGetVariables(
+			QString id, VariablesCallback<LR1BreakpointVariables> callback);
+
+		bool isEmpty() const;
+		void SendAsync(QObject *context,
+					   const CallOptions &options = CallOptions());
+		void SendAsync(QObject *context, CreatedCallback onCreated,
+					   const CallOptions &options = CallOptions());
+
+	private:
+		// 在接收线程解码，返回 GUI 线程执行的交付函数
+		using Decoder =
+			std::function<std::function<void()>(const Response &)>;
+		struct Entry {
+			QJsonObject request;
+			bool streaming;
+			Decoder decode;
+		};
+		QList<Entry> entries;
+		// 新建会话的子请求下标，以及释放该会话的 action
+		int created = -1;
+		const char *releaseAction = nullptr;
+
+		void add(QJsonObject request, bool streaming = false,
+				 Decoder decode = nullptr);
+		QJsonObject request() const;
+		bool streaming() const;
+		std::function<void()> decode(const Response &resp, QString *id) const;
+	};
 } // namespace ipc
\ No newline at end of file
@@ -0,0 +1,9 @@
+#include "notifier.h"
+
+ipc::Notifier::Notifier(QObject *parent) : QObject(parent) {
+}
+
+ipc::Notifier *ipc::Notifier::Instance() {
+	static Notifier *notifier = new Notifier();
+	return notifier;
+}
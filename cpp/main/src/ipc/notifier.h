@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+namespace ipc {
+	// 服务端推送的事件，由接收线程发出，槽函数经队列连接在 GUI 线程执行
+	class Notifier : public QObject {
+		Q_OBJECT
+
+	public:
+		static Notifier *Instance();
+
+	signals:
+		void productionParseFinished(QString id);
+		void processPaused(QString id);
+		void processExited(QString id);
+
+	private:
+		explicit Notifier(QObject *parent = nullptr);
+	};
+} // namespace ipc
@@ -0,0 +1,66 @@
+#include "record.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QMutex>
+#include <atomic>
+
+namespace ipc {
+	QMutex recordMutex;
+	QFile *recordFile = nullptr;
+	QElapsedTimer recordTimer;
+	std::atomic<bool> recording{false};
+
+	void writeRecord(const QJsonObject &);
+} // namespace ipc
+
+bool ipc::StartRecording(const QString &path) {
+	QMutexLocker locker(&recordMutex);
+	if (recordFile != nullptr) {
+		return false;
+	}
+	auto file = new QFile(path);
+	if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		delete file;
+		return false;
+	}
+	recordFile = file;
+	recordTimer.start();
+	QJsonObject header;
+	header["version"] = RecordingVersion;
+	header["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+	writeRecord(header);
+	recording = true;
+	return true;
+}
+
+void ipc::StopRecording() {
+	QMutexLocker locker(&recordMutex);
+	recording = false;
+	delete recordFile;
+	recordFile = nullptr;
+}
+
+bool ipc::IsRecording() {
+	return recording;
+}
+
+void ipc::RecordMessage(const QString &kind, const QJsonObject &msg) {
+	QMutexLocker locker(&recordMutex);
+	if (recordFile == nullptr) {
+		return;
+	}
+	QJsonObject record;
+	record["t"] = recordTimer.nsecsElapsed();
+	record["kind"] = kind;
+	record["msg"] = msg;
+	writeRecord(record);
+}
+
+// 每行写出后立即刷新，进程异常退出时记录仍然完整
+void ipc::writeRecord(const QJsonObject &record) {
+	recordFile->write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+	recordFile->write("\n");
+	recordFile->flush();
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+// 记录收发的消息，供替身后端回放（benchmark/standin_backend.cpp）
+// 设置环境变量 IPC_RECORD 为文件路径时，Init 在协商后开始记录
+// 文件每行一个 JSON 对象：首行为头部 {"version", "time"}，之后每行为
+// {"t": 开始记录后的纳秒数, "kind": "request" | "response" | "event",
+//  "msg": 消息}
+// 消息为解码后的内容，与传输编码及共享内存无关；线程安全
+namespace ipc {
+	constexpr int RecordingVersion = 1;
+
+	bool StartRecording(const QString &path);
+	void StopRecording();
+	// 未记录时开销很小，调用方据此跳过构造消息
+	bool IsRecording();
+	void RecordMessage(const QString &kind, const QJsonObject &msg);
+} // namespace ipc
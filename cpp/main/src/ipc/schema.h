@@ -0,0 +1,157 @@
+#pragma once
+
+#include "types.h"
+#include <tuple>
+
+// IPC 结构体的模式：按结构体列出键名与对应的成员
+// codec.h 据此生成 JSON 与 CBOR 的编码、解码，新增字段只需在此登记；
+// 服务端对应的 Go 结构体由 service/schema_test.go 检查键名一致
+namespace ipc {
+	// Value：出现的字段整体替换，结构体字段就地解码
+	// Patch：列表字段还可以是 {length, index, items} 形式的增量
+	enum class FieldKind { Value, Patch };
+
+	template <typename T, typename M> struct Field {
+		const char *key;
+		M T::*member;
+		FieldKind kind;
+
+		M &get(T &object) const {
+			return object.*member;
+		}
+		const M &get(const T &object) const {
+			return object.*member;
+		}
+	};
+
+	// 键位于外层，成员位于内层结构体，如退出结果中的符号表
+	template <typename T, typename N, typename M> struct NestedField {
+		const char *key;
+		N T::*outer;
+		M N::*member;
+		FieldKind kind;
+
+		M &get(T &object) const {
+			return object.*outer.*member;
+		}
+		const M &get(const T &object) const {
+			return object.*outer.*member;
+		}
+	};
+
+	template <typename T, typename M>
+	constexpr Field<T, M> field(const char *key, M T::*member,
+								FieldKind kind = FieldKind::Value) {
+		return {key, member, kind};
+	}
+
+	template <typename T, typename N, typename M>
+	constexpr NestedField<T, N, M> field(const char *key, N T::*outer,
+										 M N::*member) {
+		return {key, outer, member, FieldKind::Value};
+	}
+
+	// 未登记的类型不是结构体，由 codec.h 按值类型处理
+	template <typename T> struct Schema {
+		static constexpr bool defined = false;
+	};
+
+#define IPC_SCHEMA(type, ...)                                                  \
+	template <> struct Schema<type> {                                          \
+		static constexpr bool defined = true;                                  \
+		static constexpr auto fields = std::make_tuple(__VA_ARGS__);           \
+	}
+
+	IPC_SCHEMA(ErrorType, field("type", &ErrorType::type),
+			   field("file", &ErrorType::file),
+			   field("line", &ErrorType::line),
+			   field("column", &ErrorType::column),
+			   field("detail", &ErrorType::detail),
+			   field("length", &ErrorType::length));
+
+	IPC_SCHEMA(TextEdit, field("position", &TextEdit::position),
+			   field("deleted", &TextEdit::deleted),
+			   field("inserted", &TextEdit::inserted));
+
+	IPC_SCHEMA(Breakpoint, field("name", &Breakpoint::name),
+			   field("line", &Breakpoint::line));
+
+	IPC_SCHEMA(ReplaceProduction,
+			   field("original", &ReplaceProduction::original),
+			   field("replace", &ReplaceProduction::replace));
+
+	IPC_SCHEMA(LLBreakpointVariables,
+			   field("terminals", &LLBreakpointVariables::terminals),
+			   field("productions", &LLBreakpointVariables::productions),
+			   field("loop_variable_i", &LLBreakpointVariables::loopVariableI),
+			   field("loop_variable_j", &LLBreakpointVariables::loopVariableJ),
+			   field("loop_variable_k", &LLBreakpointVariables::loopVariableK),
+			   field("modified_flag", &LLBreakpointVariables::modifiedFlag),
+			   field("nonterminal_orders",
+					 &LLBreakpointVariables::nonterminalOrders),
+			   field("current_process_production",
+					 &LLBreakpointVariables::currentProcessProduction),
+			   field("remove_production",
+					 &LLBreakpointVariables::removeProductions),
+			   field("add_production", &LLBreakpointVariables::addProductions),
+			   field("replace_production",
+					 &LLBreakpointVariables::replaceProduction),
+			   field("common_prefix", &LLBreakpointVariables::commonPrefix),
+			   field("first", &LLBreakpointVariables::firstSet),
+			   field("follow", &LLBreakpointVariables::followSet),
+			   field("select", &LLBreakpointVariables::selectSet),
+			   field("automaton", &LLBreakpointVariables::automation),
+			   field("code_path", &LLBreakpointVariables::codePath));
+
+	IPC_SCHEMA(LLExitResult, field("code", &LLExitResult::code),
+			   field("variables", &LLExitResult::variable));
+
+	IPC_SCHEMA(LRItem, field("prod", &LRItem::production),
+			   field("progress", &LRItem::progress),
+			   field("lookahead", &LRItem::lookahead));
+
+	IPC_SCHEMA(LRItemClosureMapEdge, field("from", &LRItemClosureMapEdge::from),
+			   field("to", &LRItemClosureMapEdge::to),
+			   field("symbol", &LRItemClosureMapEdge::symbol));
+
+	IPC_SCHEMA(LRItemClosureMap,
+			   field("closures", &LRItemClosureMap::closures,
+					 FieldKind::Patch),
+			   field("edges", &LRItemClosureMap::edges, FieldKind::Patch));
+
+// LR(0) 与 LR(1) 断点变量共有的字段
+#define IPC_LR_FIELDS(type)                                                    \
+	field("terminals", &type::terminals),                                      \
+		field("productions", &type::productions),                              \
+		field("loop_variable_i", &type::loopVariableI),                        \
+		field("loop_variable_j", &type::loopVariableJ),                        \
+		field("loop_variable_k", &type::loopVariableK),                        \
+		field("modified_flag", &type::modifiedFlag),                           \
+		field("nonterminal_orders", &type::nonterminalOrders),                 \
+		field("process_symbol", &type::processedSymbol),                       \
+		field("current_symbol", &type::currentProcessSymbol),                  \
+		field("first", &type::firstSet),                                       \
+		field("closure_map", &type::closureMap),                               \
+		field("current_closure", &type::currentClosure),                       \
+		field("action_table", &type::actionTable, FieldKind::Patch),           \
+		field("goto_table", &type::gotoTable, FieldKind::Patch),               \
+		field("code_path", &type::codePath)
+
+	IPC_SCHEMA(LR0BreakpointVariables, IPC_LR_FIELDS(LR0BreakpointVariables),
+			   field("follow", &LR0BreakpointVariables::followSet));
+
+	IPC_SCHEMA(LR0ExitResult, field("code", &LR0ExitResult::code),
+			   field("symbols", &LR0ExitResult::variable,
+					 &LR0BreakpointVariables::symbols),
+			   field("variables", &LR0ExitResult::variable));
+
+	IPC_SCHEMA(LR1BreakpointVariables, IPC_LR_FIELDS(LR1BreakpointVariables));
+
+	IPC_SCHEMA(LR1ExitResult, field("code", &LR1ExitResult::code),
+			   field("symbols", &LR1ExitResult::variable,
+					 &LR1BreakpointVariables::symbols),
+			   field("variables", &LR1ExitResult::variable));
+
+#undef IPC_LR_FIELDS
+#undef IPC_SCHEMA
+} // namespace ipc
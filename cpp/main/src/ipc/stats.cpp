@@ -0,0 +1,146 @@
+#include "stats.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+
+namespace ipc {
+	const qint64 LatencyBucketBounds[LatencyBucketCount - 1] = {
+		100,   250,   500,    1000,   2500,   5000,    10000,
+		25000, 50000, 100000, 250000, 500000, 1000000,
+	};
+
+	QMutex statisticsMutex;
+	QHash<QString, ActionStatistics> statistics;
+} // namespace ipc
+
+void ipc::RecordRequest(const QString &action, qint64 bytes, qint64 queueNs) {
+	QMutexLocker locker(&statisticsMutex);
+	auto &stats = statistics[action];
+	stats.count++;
+	stats.requestBytes += bytes;
+	stats.queueNs += queueNs;
+	stats.maxQueueNs = qMax(stats.maxQueueNs, queueNs);
+}
+
+void ipc::RecordResponse(const QString &action, qint64 bytes,
+						 qint64 roundTripNs) {
+	int bucket = 0;
+	while (bucket < LatencyBucketCount - 1 &&
+		   roundTripNs > LatencyBucketBounds[bucket] * 1000) {
+		bucket++;
+	}
+	QMutexLocker locker(&statisticsMutex);
+	auto &stats = statistics[action];
+	stats.responseBytes += bytes;
+	stats.roundTripNs += roundTripNs;
+	stats.maxRoundTripNs = qMax(stats.maxRoundTripNs, roundTripNs);
+	stats.latency[bucket]++;
+}
+
+void ipc::RecordCompression(const QString &action, qint64 compressedBytes,
+							qint64 uncompressedBytes) {
+	QMutexLocker locker(&statisticsMutex);
+	auto &stats = statistics[action];
+	stats.compressedBytes += compressedBytes;
+	stats.uncompressedBytes += uncompressedBytes;
+}
+
+void ipc::RecordFailure(const QString &action) {
+	QMutexLocker locker(&statisticsMutex);
+	statistics[action].failures++;
+}
+
+void ipc::RecordDecode(const QString &action, qint64 ns) {
+	QMutexLocker locker(&statisticsMutex);
+	statistics[action].decodeNs += ns;
+}
+
+QHash<QString, ipc::ActionStatistics> ipc::Statistics() {
+	QMutexLocker locker(&statisticsMutex);
+	return statistics;
+}
+
+void ipc::ResetStatistics() {
+	QMutexLocker locker(&statisticsMutex);
+	statistics.clear();
+}
+
+double ipc::LatencyPercentile(const ActionStatistics &stats, double p) {
+	qint64 total = 0;
+	for (auto n : stats.latency) {
+		total += n;
+	}
+	if (total == 0) {
+		return 0;
+	}
+	qint64 seen = 0;
+	for (int i = 0; i < LatencyBucketCount - 1; i++) {
+		seen += stats.latency[i];
+		if (seen >= total * p) {
+			return LatencyBucketBounds[i] / 1000.0;
+		}
+	}
+	return stats.maxRoundTripNs / 1e6;
+}
+
+double ipc::CompressionRatio(const ActionStatistics &stats) {
+	if (stats.compressedBytes == 0) {
+		return 0;
+	}
+	return double(stats.uncompressedBytes) / stats.compressedBytes;
+}
+
+QJsonObject ipc::StatisticsToJson() {
+	QJsonArray bounds;
+	for (auto bound : LatencyBucketBounds) {
+		bounds.append(bound);
+	}
+	QJsonObject actions;
+	auto all = Statistics();
+	for (auto it = all.constBegin(); it != all.constEnd(); ++it) {
+		auto &stats = it.value();
+		QJsonArray latency;
+		for (auto n : stats.latency) {
+			latency.append(n);
+		}
+		QJsonObject o;
+		o["count"] = stats.count;
+		o["failures"] = stats.failures;
+		o["request_bytes"] = stats.requestBytes;
+		o["response_bytes"] = stats.responseBytes;
+		o["compressed_bytes"] = stats.compressedBytes;
+		o["uncompressed_bytes"] = stats.uncompressedBytes;
+		o["compression_ratio"] = CompressionRatio(stats);
+		o["queue_ns"] = stats.queueNs;
+		o["max_queue_ns"] = stats.maxQueueNs;
+		o["round_trip_ns"] = stats.roundTripNs;
+		o["max_round_trip_ns"] = stats.maxRoundTripNs;
+		o["decode_ns"] = stats.decodeNs;
+		o["latency"] = latency;
+		actions[it.key()] = o;
+	}
+	QJsonObject res;
+	res["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+	res["latency_bounds_us"] = bounds;
+	res["actions"] = actions;
+	return res;
+}
+
+bool ipc::DumpStatistics(const QString &path) {
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	file.write(QJsonDocument(StatisticsToJson()).toJson());
+	return file.error() == QFileDevice::NoError;
+}
+
+ipc::DecodeTimer::DecodeTimer(const QString &action) : action(action) {
+	timer.start();
+}
+
+ipc::DecodeTimer::~DecodeTimer() {
+	RecordDecode(action, timer.nsecsElapsed());
+}
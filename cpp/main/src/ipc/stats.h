@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+
+// 按 action 统计的 RPC 开销
+// 由 base.cpp 在收发时记录，解码函数以 DecodeTimer 记录解码时间；线程安全
+namespace ipc {
+	// 往返延迟直方图：桶上界（微秒），最后一个桶没有上界
+	constexpr int LatencyBucketCount = 14;
+	extern const qint64 LatencyBucketBounds[LatencyBucketCount - 1];
+
+	struct ActionStatistics {
+		qint64 count = 0;
+		// 未收到响应的请求：超时、取消或接收线程退出
+		qint64 failures = 0;
+		qint64 requestBytes = 0;
+		// 管道上传输的字节数，包括经共享内存传输的部分
+		qint64 responseBytes = 0;
+		// 压缩的响应帧：压缩后与解压后的字节数
+		qint64 compressedBytes = 0, uncompressedBytes = 0;
+		// 等待 IPC 锁的时间
+		qint64 queueNs = 0, maxQueueNs = 0;
+		// 发出请求到读完响应，不含解码
+		qint64 roundTripNs = 0, maxRoundTripNs = 0;
+		// 接收线程解码信封与调用方解码结构体的时间
+		qint64 decodeNs = 0;
+		qint64 latency[LatencyBucketCount] = {};
+	};
+
+	void RecordRequest(const QString &action, qint64 bytes, qint64 queueNs);
+	void RecordResponse(const QString &action, qint64 bytes,
+						qint64 roundTripNs);
+	void RecordCompression(const QString &action, qint64 compressedBytes,
+						   qint64 uncompressedBytes);
+	void RecordFailure(const QString &action);
+	void RecordDecode(const QString &action, qint64 ns);
+
+	QHash<QString, ActionStatistics> Statistics();
+	void ResetStatistics();
+	// 延迟的近似分位数（毫秒），取所在桶的上界；最后一个桶取最大值
+	double LatencyPercentile(const ActionStatistics &stats, double p);
+	// 压缩比：解压后与压缩后的字节数之比，没有压缩的帧时为 0
+	double CompressionRatio(const ActionStatistics &stats);
+	QJsonObject StatisticsToJson();
+	bool DumpStatistics(const QString &path);
+
+	// 作用域内计时，析构时计入 action 的解码时间
+	class DecodeTimer {
+	public:
+		explicit DecodeTimer(const QString &action);
+		~DecodeTimer();
+
+	private:
+		QString action;
+		QElapsedTimer timer;
+	};
+} // namespace ipc
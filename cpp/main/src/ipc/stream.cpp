@@ -0,0 +1,35 @@
+#include "stream.h"
+
+QString ipc::streamString(QCborStreamReader &reader) {
+	QString res;
+	if (!reader.isString()) {
+		reader.next();
+		return res;
+	}
+	if (reader.isLengthKnown()) {
+		res.reserve(reader.length());
+	}
+	auto chunk = reader.readString();
+	while (chunk.status == QCborStreamReader::Ok) {
+		res += chunk.data;
+		chunk = reader.readString();
+	}
+	return res;
+}
+
+qint64 ipc::streamInteger(QCborStreamReader &reader) {
+	qint64 res = 0;
+	if (reader.isInteger()) {
+		res = reader.toInteger();
+	} else if (reader.isDouble()) {
+		res = qint64(reader.toDouble());
+	}
+	reader.next();
+	return res;
+}
+
+bool ipc::streamBool(QCborStreamReader &reader) {
+	bool res = reader.isBool() && reader.toBool();
+	reader.next();
+	return res;
+}
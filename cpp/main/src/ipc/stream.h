@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QCborStreamReader>
+#include <QString>
+
+// 基于 QCborStreamReader 的流式解码的基本类型
+// 类型不符时跳过该项并返回空值；结构体的解码见 codec.h
+namespace ipc {
+	QString streamString(QCborStreamReader &reader);
+	qint64 streamInteger(QCborStreamReader &reader);
+	bool streamBool(QCborStreamReader &reader);
+} // namespace ipc
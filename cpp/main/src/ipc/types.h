@@ -1,15 +1,41 @@
 #pragma once
 
+#include <QByteArray>
 #include <QHash>
 #include <QJsonObject>
 #include <QList>
 #include <QString>
 #include <QStringList>
+#include <memory>
 
 namespace ipc {
+	// 请求没有得到服务端响应的原因
+	// Protocol 为消息格式错误：帧、CBOR/JSON 或共享内存引用无法解码
+	enum class RpcErrorKind { None, Timeout, Cancelled, Disconnected, Protocol };
+
+	// 传输与解码错误在 base.cpp 内部以 RpcError 抛出，此时 action 为空；
+	// 请求失败时原因记录在 Response::Error 中
+	struct RpcError {
+		RpcErrorKind kind = RpcErrorKind::None;
+		QString action;
+		QString message;
+	};
+
 	struct Response {
+		qint64 RequestId;
 		int ResponseCode;
 		QJsonObject Data;
+		// 服务端推送的事件名，普通响应为空
+		QString Event;
+		// 流式解码请求的 data 原始编码，非空时 Data 为空
+		// 经共享内存传输时直接引用映射区域，不能在 Response 之外保留
+		QByteArray Payload;
+		// Payload 引用映射区域时持有该区域，最后一个副本销毁后服务端才能复用
+		std::shared_ptr<void> SharedRegion;
+		// 对应请求的 action，用于统计解码时间
+		QString Action;
+		// ResponseCode = -1 时为请求失败的原因
+		RpcErrorKind Error = RpcErrorKind::None;
 	};
 
 	struct ErrorType {
@@ -24,6 +50,15 @@ namespace ipc {
 		QStringList nonterminals;
 		QList<QStringList> productions;
 		QList<ErrorType> fatals, errors, warnings;
+		int revision = 0;
+	};
+
+	// 编辑器中的一次修改：删除 position 起的 deleted 个字节，再插入 inserted
+	// 位置与长度以 UTF-8 字节计，与 QScintilla 的修改通知一致
+	struct TextEdit {
+		int position = 0;
+		int deleted = 0;
+		QString inserted;
 	};
 
 	constexpr int ProcessModeRun = 1;
@@ -31,7 +66,7 @@ namespace ipc {
 	constexpr int ProcessModeExit = 4;
 	struct Breakpoint {
 		QString name;
-		int line;
+		int line = 0;
 	};
 	struct ReplaceProduction {
 		QStringList original, replace;
@@ -57,14 +92,36 @@ namespace ipc {
 		LLBreakpointVariables variable;
 	};
 
+	// 会话内的符号编号，即 SymbolTable::names 的下标
+	typedef int Symbol;
+	constexpr Symbol NoSymbol = -1;
+	// 服务端按会话增量发送的符号表，符号名只发送一次
+	struct SymbolTable {
+		QStringList names;
+		QHash<QString, Symbol> ids;
+
+		void append(const QString &name) {
+			ids[name] = names.size();
+			names.append(name);
+		}
+		QString name(Symbol symbol) const {
+			return symbol >= 0 && symbol < names.size() ? names[symbol]
+														: QString();
+		}
+		Symbol id(const QString &name) const {
+			return ids.value(name, NoSymbol);
+		}
+	};
+
 	struct LRItem {
 		int production;
 		int progress;
-		QString lookahead;
+		// LR(0) 项目没有向前看符号
+		Symbol lookahead = NoSymbol;
 	};
 	struct LRItemClosureMapEdge {
 		int from, to;
-		QString symbol;
+		Symbol symbol = NoSymbol;
 	};
 	typedef QList<LRItem> LRItemClosure;
 	struct LRItemClosureMap {
@@ -83,9 +140,10 @@ namespace ipc {
 		QHash<QString, QStringList> firstSet, followSet;
 		LRItemClosureMap closureMap;
 		LRItemClosure currentClosure;
-		QList<QHash<QString, QString>> actionTable;
-		QList<QHash<QString, int>> gotoTable;
+		QList<QHash<Symbol, QString>> actionTable;
+		QList<QHash<Symbol, int>> gotoTable;
 		QString codePath;
+		SymbolTable symbols;
 	};
 	struct LR0ExitResult {
 		int code;
@@ -103,9 +161,10 @@ namespace ipc {
 		QHash<QString, QStringList> firstSet;
 		LRItemClosureMap closureMap;
 		LRItemClosure currentClosure;
-		QList<QHash<QString, QString>> actionTable;
-		QList<QHash<QString, int>> gotoTable;
+		QList<QHash<Symbol, QString>> actionTable;
+		QList<QHash<Symbol, int>> gotoTable;
 		QString codePath;
+		SymbolTable symbols;
 	};
 	struct LR1ExitResult {
 		int code;
@@ -1,13 +1,29 @@
 #include "mainwindow.h"
 
+#include "BatchGenerator.h"
 #include "ipc/base.h"
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QLocale>
+#include <QThread>
 #include <QTranslator>
+#include <cstring>
+
+// 批量生成代码时不需要窗口，在没有显示设备的构建机上也能运行
+static bool isHeadless(int argc, char *argv[]) {
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--generate") == 0) {
+			return true;
+		}
+	}
+	return false;
+}
 
 #pragma comment(linker, "/subsystem:\"windows\" /entry:\"mainCRTStartup\"")
 int main(int argc, char *argv[]) {
-	QApplication a(argc, argv);
+	QScopedPointer<QCoreApplication> a(isHeadless(argc, argv)
+										   ? new QCoreApplication(argc, argv)
+										   : new QApplication(argc, argv));
 
 	ipc::Init();
 
@@ -16,14 +32,53 @@ int main(int argc, char *argv[]) {
 	for (const QString &locale : uiLanguages) {
 		const QString baseName = "main_" + QLocale(locale).name();
 		if (translator.load(":/i18n/" + baseName)) {
-			a.installTranslator(&translator);
+			a->installTranslator(&translator);
 			break;
 		}
 	}
 
-	MainWindow *w = new MainWindow;
+	// 可选参数用于以替身后端进行基准测试：打开文件并直接打开演示窗口
+	QCommandLineParser parser;
+	QCommandLineOption demo("demo", "打开算法演示窗口", "algorithm");
+	parser.addOption(demo);
+	// 批量生成代码：文件为文法列表，每个文法按逗号分隔的各算法生成
+	QCommandLineOption generate("generate", "不打开窗口，批量生成代码",
+								"algorithms");
+	QCommandLineOption output("output", "生成代码的目录", "dir");
+	QCommandLineOption jobs("jobs", "同时运行的任务数", "n",
+							QString::number(QThread::idealThreadCount()));
+	parser.addOptions({generate, output, jobs});
+	parser.addPositionalArgument("file", "打开的文件");
+	parser.process(*a);
+
+	if (parser.isSet(generate)) {
+		auto algorithms = parser.value(generate).split(',', Qt::SkipEmptyParts);
+		for (auto &algorithm : algorithms) {
+			if (!BatchGenerator::IsAlgorithm(algorithm)) {
+				ipc::SendLogMessage("unknown algorithm: " + algorithm);
+				return 2;
+			}
+		}
+		auto generator = new BatchGenerator(
+			parser.positionalArguments(), algorithms, parser.value(output),
+			parser.value(jobs).toInt(), a.data());
+		QObject::connect(generator, &BatchGenerator::finished, a.data(),
+						 [](int failed) {
+							 QCoreApplication::exit(failed == 0 ? 0 : 1);
+						 });
+		// 在事件循环中开始，没有任务时也能正常退出
+		QMetaObject::invokeMethod(generator, &BatchGenerator::Start,
+								  Qt::QueuedConnection);
+		return a->exec();
+	}
+
+	auto file = parser.positionalArguments().value(0);
+	MainWindow *w = new MainWindow(nullptr, file);
 	w->show();
 	w->activateWindow();
+	if (parser.isSet(demo) && !w->OpenDemo(parser.value(demo))) {
+		ipc::SendLogMessage("unknown demo: " + parser.value(demo));
+	}
 
-	return a.exec();
+	return a->exec();
 }
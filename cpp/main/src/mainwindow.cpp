@@ -6,11 +6,14 @@
 #include "demo_lr1_alogrithm.h"
 #include "ipc/base.h"
 #include "ipc/ipc.h"
+#include "ipc/notifier.h"
 #include <QCloseEvent>
+#include <QCryptographicHash>
 #include <QFileDialog>
 #include <QFontDatabase>
 #include <QMessageBox>
 #include <QProcess>
+#include <QUuid>
 
 static QString readFileContent(QString filename) {
 	QFile file(filename);
@@ -20,6 +23,9 @@ static QString readFileContent(QString filename) {
 	return QString::fromUtf8(content);
 }
 
+// 缓存的解析结果个数
+static constexpr int productionCacheSize = 32;
+
 static void writeFileContent(QString filename, QString content) {
 	QFile file(filename);
 	file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
@@ -28,13 +34,19 @@ static void writeFileContent(QString filename, QString content) {
 }
 
 MainWindow::MainWindow(QWidget *parent, QString filename)
-	: QMainWindow(parent), ui(new Ui::MainWindow), parseId(""), errorDialog() {
-	codeAnalyseTimer.start(100);
-
-	connect(&codeAnalyseTimer, &QTimer::timeout, this,
-			&MainWindow::timerUpdate);
+	: QMainWindow(parent), ui(new Ui::MainWindow), parseId(""), errorDialog(),
+	  documentId(QUuid::createUuid().toString(QUuid::WithoutBraces)),
+	  productionCache(productionCacheSize) {
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::productionParseFinished,
+			this, &MainWindow::productionParseFinished);
+	connect(ipc::Notifier::Instance(), &ipc::Notifier::processExited, this,
+			&MainWindow::processExited);
 
 	ui->setupUi(this);
+	ui->terminalList->setModel(&terminalModel);
+	ui->nonterminalList->setModel(&nonterminalModel);
+	connect(ui->symbolFilter, &QLineEdit::textChanged, this,
+			&MainWindow::symbolFilterChanged);
 
 	ui->codeView->SendScintilla(QsciScintilla::SCI_SETCODEPAGE,
 								QsciScintilla::SC_CP_UTF8);
@@ -57,8 +69,8 @@ MainWindow::MainWindow(QWidget *parent, QString filename)
 
 	connect(ui->codeView, &QsciScintilla::linesChanged, this,
 			&MainWindow::codeLineChange);
-	connect(ui->codeView, &QsciScintilla::textChanged, this,
-			&MainWindow::codeChange);
+	connect(ui->codeView, &QsciScintillaBase::SCN_MODIFIED, this,
+			&MainWindow::codeModified);
 	connect(ui->codeView, &QsciScintilla::cursorPositionChanged, this,
 			&MainWindow::codePositionChanged);
 	connect(statusLabel, &ClickableLabel::clicked, this,
@@ -77,6 +89,10 @@ MainWindow::MainWindow(QWidget *parent, QString filename)
 			&QsciScintilla::redo);
 	connect(ui->actionErrorDialog, &QAction::triggered, this,
 			&MainWindow::statusLabelClicked);
+	connect(ui->actionDiagnostics, &QAction::triggered, this,
+			&MainWindow::actionDiagnostics);
+	connect(ui->actionDumpDiagnostics, &QAction::triggered, this,
+			&MainWindow::actionDumpDiagnostics);
 	connect(ui->actionCodeLL, &QAction::triggered, this,
 			&MainWindow::actionCodeLL);
 	connect(ui->actionCodeLLWithoutTranslate, &QAction::triggered, this,
@@ -100,6 +116,8 @@ MainWindow::MainWindow(QWidget *parent, QString filename)
 			&MainWindow::actionAlogLR1);
 	connect(ui->actionLALR, &QAction::triggered, this,
 			&MainWindow::actionAlogLALR);
+	connect(ui->actionCompare, &QAction::triggered, this,
+			&MainWindow::actionCompare);
 
 	codeChange();
 	codePositionChanged(0, 0);
@@ -113,9 +131,10 @@ MainWindow::MainWindow(QWidget *parent, QString filename)
 MainWindow::~MainWindow() {
 	delete ui;
 	errorDialog.close();
-	if (!parseId.isEmpty()) {
-		ipc::ProductionParseCancel(parseId);
-	}
+	diagnosticsDialog.close();
+	compareDialog.close();
+	cancelProductionParse();
+	ipc::ProductionDocumentClose(documentId);
 	if (!llProcessId.isEmpty()) {
 		ipc::LLProcessRelease(llProcessId);
 	}
@@ -140,13 +159,84 @@ void MainWindow::codeLineChange() {
 	ui->codeView->setMarginWidth(0, QString("0%1").arg(lineCount));
 }
 
+// 由修改通知得到增量编辑；删除时 text 为被删除的内容，只需要长度
+void MainWindow::codeModified(int position, int type, const char *text,
+							  int length) {
+	if (type & QsciScintillaBase::SC_MOD_INSERTTEXT) {
+		pendingEdits.append({position, 0, QString::fromUtf8(text, length)});
+	} else if (type & QsciScintillaBase::SC_MOD_DELETETEXT) {
+		pendingEdits.append({position, length, QString()});
+	} else {
+		return;
+	}
+	codeChange();
+}
+
+// 服务端按文档排队解析，新的文本会替代尚未解析的旧文本，无需先取消
+// 文本解析过时直接显示缓存的结果，编辑留到下次解析时一并发送
+// 提交期间的修改在提交的响应到达后再处理，使服务端按顺序应用编辑
 void MainWindow::codeChange() {
-	if (!parseId.isEmpty()) {
-		ipc::ProductionParseCancel(parseId);
+	auto text = ui->codeView->text();
+	parseDigest =
+		QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1);
+	if (parseSubmitting) {
+		parseResubmit = true;
+	}
+	if (auto cached = productionCache.object(parseDigest)) {
+		cancelProductionParse();
+		showProduction(*cached);
+		return;
 	}
-	parseId = ipc::ProductionParseStart(ui->codeView->text());
 	statusLabel->setText("正在解析产生式代码...");
-	receiveProduction();
+	if (!parseSubmitting) {
+		submitProduction();
+	}
+}
+
+// 文档已同步时只发送累积的编辑，服务端的文档不一致时再发送全文
+// 记录提交时文本的摘要，解析结果只缓存在与其版本对应的摘要下
+void MainWindow::submitProduction() {
+	parseSubmitting = true;
+	auto submitted = [this](const QByteArray &digest, const QString &id,
+							int revision) {
+		parseSubmitting = false;
+		parseId = id;
+		parseRevision = revision;
+		parseRevisionDigest = digest;
+		documentSynced = !id.isEmpty();
+		if (parseResubmit) {
+			parseResubmit = false;
+			codeChange();
+			return;
+		}
+		receiveProduction();
+	};
+	auto submitText = [this, submitted] {
+		pendingEdits.clear();
+		auto text = ui->codeView->text();
+		auto digest =
+			QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1);
+		ipc::ProductionParseStart(
+			text, documentId, this,
+			[submitted, digest](const QString &id, int revision) {
+				submitted(digest, id, revision);
+			});
+	};
+	if (!documentSynced) {
+		submitText();
+		return;
+	}
+	ipc::ProductionParseEdit(
+		documentId, pendingEdits, ui->codeView->length(), this,
+		[submitted, submitText, digest = parseDigest](const QString &id,
+													  int revision) {
+			if (id.isEmpty()) {
+				submitText();
+			} else {
+				submitted(digest, id, revision);
+			}
+		});
+	pendingEdits.clear();
 }
 
 void MainWindow::codePositionChanged(int line, int index) {
@@ -197,9 +287,17 @@ void MainWindow::actionCodeLL() {
 		return;
 	}
 	startCodeProcess();
-	llProcessId = ipc::LLProcessRequest(ui->codeView->text(), false, fileName);
-	ipc::LLProcessSwitchMode(llProcessId, ipc::ProcessModeRun);
-	checkLLProcess();
+	ipc::Batch batch;
+	batch.LLProcessRequest(ui->codeView->text(), false, fileName);
+	batch.LLProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	batch.SendAsync(this, [this](const QString &id) {
+		llProcessId = id;
+		if (id.isEmpty()) {
+			endCodeProcess();
+			return;
+		}
+		checkLLProcess();
+	});
 }
 
 void MainWindow::actionCodeLLWithoutTranslate() {
@@ -211,9 +309,17 @@ void MainWindow::actionCodeLLWithoutTranslate() {
 		return;
 	}
 	startCodeProcess();
-	llProcessId = ipc::LLProcessRequest(ui->codeView->text(), true, fileName);
-	ipc::LLProcessSwitchMode(llProcessId, ipc::ProcessModeRun);
-	checkLLProcess();
+	ipc::Batch batch;
+	batch.LLProcessRequest(ui->codeView->text(), true, fileName);
+	batch.LLProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	batch.SendAsync(this, [this](const QString &id) {
+		llProcessId = id;
+		if (id.isEmpty()) {
+			endCodeProcess();
+			return;
+		}
+		checkLLProcess();
+	});
 }
 
 void MainWindow::actionCodeLR0() {
@@ -225,10 +331,17 @@ void MainWindow::actionCodeLR0() {
 		return;
 	}
 	startCodeProcess();
-	lr0ProcessId =
-		ipc::LR0ProcessRequest(ui->codeView->text(), false, fileName);
-	ipc::LR0ProcessSwitchMode(lr0ProcessId, ipc::ProcessModeRun);
-	checkLR0Process();
+	ipc::Batch batch;
+	batch.LR0ProcessRequest(ui->codeView->text(), false, fileName);
+	batch.LR0ProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	batch.SendAsync(this, [this](const QString &id) {
+		lr0ProcessId = id;
+		if (id.isEmpty()) {
+			endCodeProcess();
+			return;
+		}
+		checkLR0Process();
+	});
 }
 
 void MainWindow::actionCodeSLR() {
@@ -240,9 +353,17 @@ void MainWindow::actionCodeSLR() {
 		return;
 	}
 	startCodeProcess();
-	lr0ProcessId = ipc::LR0ProcessRequest(ui->codeView->text(), true, fileName);
-	ipc::LR0ProcessSwitchMode(lr0ProcessId, ipc::ProcessModeRun);
-	checkLR0Process();
+	ipc::Batch batch;
+	batch.LR0ProcessRequest(ui->codeView->text(), true, fileName);
+	batch.LR0ProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	batch.SendAsync(this, [this](const QString &id) {
+		lr0ProcessId = id;
+		if (id.isEmpty()) {
+			endCodeProcess();
+			return;
+		}
+		checkLR0Process();
+	});
 }
 
 void MainWindow::actionCodeLR1() {
@@ -254,10 +375,17 @@ void MainWindow::actionCodeLR1() {
 		return;
 	}
 	startCodeProcess();
-	lr1ProcessId =
-		ipc::LR1ProcessRequest(ui->codeView->text(), false, fileName);
-	ipc::LR1ProcessSwitchMode(lr1ProcessId, ipc::ProcessModeRun);
-	checkLR1Process();
+	ipc::Batch batch;
+	batch.LR1ProcessRequest(ui->codeView->text(), false, fileName);
+	batch.LR1ProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	batch.SendAsync(this, [this](const QString &id) {
+		lr1ProcessId = id;
+		if (id.isEmpty()) {
+			endCodeProcess();
+			return;
+		}
+		checkLR1Process();
+	});
 }
 
 void MainWindow::actionCodeLALR() {
@@ -269,9 +397,36 @@ void MainWindow::actionCodeLALR() {
 		return;
 	}
 	startCodeProcess();
-	lr1ProcessId = ipc::LR1ProcessRequest(ui->codeView->text(), true, fileName);
-	ipc::LR1ProcessSwitchMode(lr1ProcessId, ipc::ProcessModeRun);
-	checkLR1Process();
+	ipc::Batch batch;
+	batch.LR1ProcessRequest(ui->codeView->text(), true, fileName);
+	batch.LR1ProcessSwitchMode(QString(), ipc::ProcessModeRun);
+	batch.SendAsync(this, [this](const QString &id) {
+		lr1ProcessId = id;
+		if (id.isEmpty()) {
+			endCodeProcess();
+			return;
+		}
+		checkLR1Process();
+	});
+}
+
+bool MainWindow::OpenDemo(const QString &algorithm) {
+	if (algorithm == "ll") {
+		actionAlogLL();
+	} else if (algorithm == "ll-notranslate") {
+		actionAlogLLWithoutTranslate();
+	} else if (algorithm == "lr0") {
+		actionAlogLR0();
+	} else if (algorithm == "slr") {
+		actionAlogSLR();
+	} else if (algorithm == "lr1") {
+		actionAlogLR1();
+	} else if (algorithm == "lalr") {
+		actionAlogLALR();
+	} else {
+		return false;
+	}
+	return true;
 }
 
 void MainWindow::actionAlogLL() {
@@ -304,39 +459,80 @@ void MainWindow::actionAlogLALR() {
 	w->show();
 }
 
+void MainWindow::actionCompare() {
+	compareDialog.compare(ui->codeView->text());
+	compareDialog.show();
+	compareDialog.activateWindow();
+}
+
 void MainWindow::receiveProduction() {
 	if (parseId.isEmpty()) {
 		return;
 	}
-	ipc::ProductionResult result;
-	bool ok = ipc::ProductionParseQuery(parseId, &result);
-	if (!ok) {
+	if (checkingIds.contains(parseId)) {
+		recheckIds.insert(parseId);
 		return;
 	}
-	parseId = "";
+	auto id = parseId;
+	checkingIds.insert(id);
+	ipc::ProductionParseQueryAsync(
+		id, this,
+		[this, id](bool ok, const ipc::ProductionResult &result) {
+			auto recheck = finishChecking(id);
+			if (!ok || id != parseId || result.revision != parseRevision) {
+				if (recheck) {
+					receiveProduction();
+				}
+				return;
+			}
+			parseId = "";
+			productionCache.insert(parseRevisionDigest,
+								   new ipc::ProductionResult(result));
+			showProduction(result);
+		},
+		parseOptions);
+}
+
+void MainWindow::showProduction(const ipc::ProductionResult &result) {
 	statusLabel->setText(QString("%1 个错误，%2 个警告")
 							 .arg(result.errors.size())
 							 .arg(result.warnings.size()));
 
-	updateList(ui->nonterminalList, result.nonterminals);
-	updateList(ui->terminalList, result.terminals);
+	nonterminalModel.setSymbols(result.nonterminals);
+	terminalModel.setSymbols(result.terminals);
 	errorDialog.updateInformation(&result);
 }
 
-void MainWindow::timerUpdate() {
-	receiveProduction();
-	checkLLProcess();
-	checkLR0Process();
-	checkLR1Process();
+void MainWindow::productionParseFinished(QString id) {
+	if (id == parseId) {
+		receiveProduction();
+	}
+}
+
+void MainWindow::processExited(QString id) {
+	if (id == llProcessId) {
+		checkLLProcess();
+	} else if (id == lr0ProcessId) {
+		checkLR0Process();
+	} else if (id == lr1ProcessId) {
+		checkLR1Process();
+	}
 }
 
 void MainWindow::startCodeProcess() {
 	setEnabled(false);
 	statusLabel->setText("正在导出代码...");
-	if (!parseId.isEmpty()) {
-		ipc::ProductionParseCancel(parseId);
-		parseId = "";
+	cancelProductionParse();
+}
+
+void MainWindow::cancelProductionParse() {
+	if (parseId.isEmpty()) {
+		return;
 	}
+	parseOptions.token.Cancel();
+	parseOptions.token = ipc::CancelToken::Create();
+	ipc::ProductionParseCancel(parseId);
+	parseId = "";
 }
 
 void MainWindow::endCodeProcess() {
@@ -348,93 +544,132 @@ void MainWindow::checkLLProcess() {
 	if (llProcessId.isEmpty()) {
 		return;
 	}
-	ipc::LLExitResult result;
-	auto exit = ipc::LLProcessExit(llProcessId, &result);
-	if (exit) {
-		endCodeProcess();
-		ipc::LLProcessRelease(llProcessId);
-		llProcessId = "";
-		switch (result.code) {
-			case 0:
-				QProcess::startDetached(
-					"explorer",
-					{"/select,", result.variable.codePath.replace('/', '\\')});
-				QMessageBox::information(this, "成功", "生成代码成功");
-				break;
-			case 1:
-				QMessageBox::information(this, "生成错误",
-										 "产生式代码解析错误");
-				break;
-			case 2:
-				QMessageBox::information(this, "生成错误",
-										 "Select 集合冲突，无法生成自动机");
-				break;
-		}
+	if (checkingIds.contains(llProcessId)) {
+		recheckIds.insert(llProcessId);
+		return;
 	}
+	auto id = llProcessId;
+	checkingIds.insert(id);
+	ipc::LLProcessExitAsync(
+		id, this, [this, id](bool exit, ipc::LLExitResult result) {
+			auto recheck = finishChecking(id);
+			if (!exit || id != llProcessId) {
+				if (recheck) {
+					checkLLProcess();
+				}
+				return;
+			}
+			endCodeProcess();
+			ipc::LLProcessRelease(llProcessId);
+			llProcessId = "";
+			switch (result.code) {
+				case 0:
+					QProcess::startDetached(
+						"explorer",
+						{"/select,",
+						 result.variable.codePath.replace('/', '\\')});
+					QMessageBox::information(this, "成功", "生成代码成功");
+					break;
+				case 1:
+					QMessageBox::information(this, "生成错误",
+											 "产生式代码解析错误");
+					break;
+				case 2:
+					QMessageBox::information(this, "生成错误",
+											 "Select 集合冲突，无法生成自动机");
+					break;
+			}
+		});
 }
 
 void MainWindow::checkLR0Process() {
 	if (lr0ProcessId.isEmpty()) {
 		return;
 	}
-	ipc::LR0ExitResult result;
-	auto exit = ipc::LR0ProcessExit(lr0ProcessId, &result);
-	if (exit) {
-		endCodeProcess();
-		ipc::LR0ProcessRelease(lr0ProcessId);
-		lr0ProcessId = "";
-		switch (result.code) {
-			case 0:
-				QProcess::startDetached(
-					"explorer",
-					{"/select,", result.variable.codePath.replace('/', '\\')});
-				QMessageBox::information(this, "成功", "生成代码成功");
-				break;
-			case 1:
-				QMessageBox::information(this, "生成错误",
-										 "产生式代码解析错误");
-				break;
-			case 2:
-				QMessageBox::information(this, "生成错误", "没有开始符号");
-				break;
-			case 3:
-				QMessageBox::information(this, "生成错误",
-										 "项目集闭包冲突，无法生成自动机");
-				break;
-		}
+	if (checkingIds.contains(lr0ProcessId)) {
+		recheckIds.insert(lr0ProcessId);
+		return;
 	}
+	auto id = lr0ProcessId;
+	checkingIds.insert(id);
+	ipc::LR0ProcessExitAsync(
+		id, this, [this, id](bool exit, ipc::LR0ExitResult result) {
+			auto recheck = finishChecking(id);
+			if (!exit || id != lr0ProcessId) {
+				if (recheck) {
+					checkLR0Process();
+				}
+				return;
+			}
+			endCodeProcess();
+			ipc::LR0ProcessRelease(lr0ProcessId);
+			lr0ProcessId = "";
+			switch (result.code) {
+				case 0:
+					QProcess::startDetached(
+						"explorer",
+						{"/select,",
+						 result.variable.codePath.replace('/', '\\')});
+					QMessageBox::information(this, "成功", "生成代码成功");
+					break;
+				case 1:
+					QMessageBox::information(this, "生成错误",
+											 "产生式代码解析错误");
+					break;
+				case 2:
+					QMessageBox::information(this, "生成错误", "没有开始符号");
+					break;
+				case 3:
+					QMessageBox::information(this, "生成错误",
+											 "项目集闭包冲突，无法生成自动机");
+					break;
+			}
+		});
 }
 
 void MainWindow::checkLR1Process() {
 	if (lr1ProcessId.isEmpty()) {
 		return;
 	}
-	ipc::LR1ExitResult result;
-	auto exit = ipc::LR1ProcessExit(lr1ProcessId, &result);
-	if (exit) {
-		endCodeProcess();
-		ipc::LR1ProcessRelease(lr1ProcessId);
-		lr1ProcessId = "";
-		switch (result.code) {
-			case 0:
-				QProcess::startDetached(
-					"explorer",
-					{"/select,", result.variable.codePath.replace('/', '\\')});
-				QMessageBox::information(this, "成功", "生成代码成功");
-				break;
-			case 1:
-				QMessageBox::information(this, "生成错误",
-										 "产生式代码解析错误");
-				break;
-			case 2:
-				QMessageBox::information(this, "生成错误", "没有开始符号");
-				break;
-			case 3:
-				QMessageBox::information(this, "生成错误",
-										 "项目集闭包冲突，无法生成自动机");
-				break;
-		}
+	if (checkingIds.contains(lr1ProcessId)) {
+		recheckIds.insert(lr1ProcessId);
+		return;
 	}
+	auto id = lr1ProcessId;
+	checkingIds.insert(id);
+	ipc::LR1ProcessExitAsync(
+		id, this, [this, id](bool exit, ipc::LR1ExitResult result) {
+			auto recheck = finishChecking(id);
+			if (!exit || id != lr1ProcessId) {
+				if (recheck) {
+					checkLR1Process();
+				}
+				return;
+			}
+			endCodeProcess();
+			ipc::LR1ProcessRelease(lr1ProcessId);
+			lr1ProcessId = "";
+			switch (result.code) {
+				case 0:
+					QProcess::startDetached(
+						"explorer",
+						{"/select,",
+						 result.variable.codePath.replace('/', '\\')});
+					QMessageBox::information(this, "成功", "生成代码成功");
+					break;
+				case 1:
+					QMessageBox::information(this, "生成错误",
+											 "产生式代码解析错误");
+					break;
+				case 2:
+					QMessageBox::information(this, "生成错误", "没有开始符号");
+					break;
+				case 3:
+					QMessageBox::information(this, "生成错误",
+											 "项目集闭包冲突，无法生成自动机");
+					break;
+			}
+		});
 }
 
 bool MainWindow::checkCodeGenerateState() {
@@ -442,13 +677,29 @@ bool MainWindow::checkCodeGenerateState() {
 			 lr1ProcessId.isEmpty());
 }
 
+// 查询完成，返回查询期间是否收到过该任务的事件
+bool MainWindow::finishChecking(const QString &id) {
+	checkingIds.remove(id);
+	return recheckIds.remove(id);
+}
+
 void MainWindow::statusLabelClicked() {
 	errorDialog.initView();
 	errorDialog.show();
 	errorDialog.activateWindow();
 }
 
-void MainWindow::updateList(QListWidget *listWidget, QStringList items) {
-	listWidget->clear();
-	listWidget->insertItems(0, items);
+void MainWindow::actionDiagnostics() {
+	diagnosticsDialog.updateInformation();
+	diagnosticsDialog.show();
+	diagnosticsDialog.activateWindow();
+}
+
+void MainWindow::actionDumpDiagnostics() {
+	DiagnosticsDialog::dumpStatistics(this);
+}
+
+void MainWindow::symbolFilterChanged(const QString &filter) {
+	terminalModel.setFilter(filter);
+	nonterminalModel.setFilter(filter);
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "CompareDialog.h"
+#include "DiagnosticsDialog.h"
 #include "ErrorDialog.h"
+#include "ipc/base.h"
 #include "ui_mainwindow.h"
+#include "view/SymbolListModel.h"
 #include "widget/ClickableLabel.h"
+#include <QCache>
 #include <QMainWindow>
-#include <QTimer>
+#include <QSet>
 
 class MainWindow : public QMainWindow {
 	Q_OBJECT
@@ -14,11 +19,15 @@ public:
 						QString filename = QString());
 	~MainWindow();
 
+	// 按名称打开算法演示窗口：ll、ll-notranslate、lr0、slr、lr1、lalr
+	bool OpenDemo(const QString &algorithm);
+
 protected:
 	virtual void closeEvent(QCloseEvent *) override;
 
 private slots:
 	void codeLineChange();
+	void codeModified(int position, int type, const char *text, int length);
 	void codeChange();
 	void codePositionChanged(int line, int index);
 	void actionNewFile();
@@ -36,12 +45,19 @@ private slots:
 	void actionAlogSLR();
 	void actionAlogLR1();
 	void actionAlogLALR();
-	void timerUpdate();
+	void actionCompare();
+	void productionParseFinished(QString id);
+	void processExited(QString id);
 	void statusLabelClicked();
+	void actionDiagnostics();
+	void actionDumpDiagnostics();
+	void symbolFilterChanged(const QString &filter);
 
 private:
-	void updateList(QListWidget *listWidget, QStringList items);
+	void submitProduction();
 	void receiveProduction();
+	void showProduction(const ipc::ProductionResult &result);
+	void cancelProductionParse();
 	void startCodeProcess();
 	void endCodeProcess();
 	void checkLLProcess();
@@ -49,16 +65,39 @@ private:
 	void checkLR1Process();
 
 	bool checkCodeGenerateState();
+	bool finishChecking(const QString &id);
 
 private:
 	Ui::MainWindow *ui;
 	ClickableLabel *statusLabel;
 	QLabel *columnLabel;
 	ErrorDialog errorDialog;
-	QTimer codeAnalyseTimer;
+	DiagnosticsDialog diagnosticsDialog;
+	CompareDialog compareDialog;
+	SymbolListModel terminalModel;
+	SymbolListModel nonterminalModel;
 
 	QString parseId;
+	// 服务端保存的文档：同步后只发送 pendingEdits 中累积的编辑
+	QString documentId;
+	bool documentSynced = false;
+	QList<ipc::TextEdit> pendingEdits;
+	// 最近一次提交的文本版本及其摘要，较旧的解析结果不再显示
+	int parseRevision = 0;
+	QByteArray parseRevisionDigest;
+	// 同一文档同时只提交一次；提交期间文本又有修改时，响应到达后再提交
+	bool parseSubmitting = false;
+	bool parseResubmit = false;
+	// 以文本摘要为键的解析结果，撤销、重做回到解析过的文本时直接显示
+	QCache<QByteArray, ipc::ProductionResult> productionCache;
+	QByteArray parseDigest;
+	// 产生式解析结果的查询，解析被取消时一并取消
+	ipc::CallOptions parseOptions{ipc::NoTimeout, ipc::CancelToken::Create()};
 	QString llProcessId;
 	QString lr0ProcessId;
 	QString lr1ProcessId;
+	// 已发出查询、尚未收到响应的任务 id
+	QSet<QString> checkingIds;
+	// 查询期间收到事件的任务 id，响应到达后需要重新查询
+	QSet<QString> recheckIds;
 };
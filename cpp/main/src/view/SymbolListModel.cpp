@@ -0,0 +1,114 @@
+#include "SymbolListModel.h"
+#include <QSet>
+#include <algorithm>
+
+SymbolListModel::SymbolListModel(QObject *parent)
+	: QAbstractListModel(parent) {
+}
+
+int SymbolListModel::rowCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : rows.size();
+}
+
+QVariant SymbolListModel::data(const QModelIndex &index, int role) const {
+	if (role != Qt::DisplayRole || !index.isValid() ||
+		index.row() >= rows.size()) {
+		return QVariant();
+	}
+	return rows[index.row()];
+}
+
+// 索引只折叠新增的符号
+void SymbolListModel::setSymbols(const QStringList &symbols) {
+	QHash<QString, QString> index;
+	index.reserve(symbols.size());
+	for (auto &symbol : symbols) {
+		auto it = folded.constFind(symbol);
+		index.insert(symbol, it != folded.constEnd() ? it.value()
+													  : symbol.toCaseFolded());
+	}
+	folded.swap(index);
+	this->symbols = symbols;
+	updateRows(filtered(symbols));
+}
+
+// 过滤文本变长时只需在当前显示的行中查找
+void SymbolListModel::setFilter(const QString &filter) {
+	auto key = filter.toCaseFolded();
+	if (key == this->filter) {
+		return;
+	}
+	bool narrowed = key.contains(this->filter);
+	this->filter = key;
+	updateRows(filtered(narrowed ? rows : symbols));
+}
+
+QStringList SymbolListModel::filtered(const QStringList &candidates) const {
+	if (filter.isEmpty()) {
+		return candidates;
+	}
+	QStringList result;
+	for (auto &symbol : candidates) {
+		if (folded.value(symbol).contains(filter)) {
+			result << symbol;
+		}
+	}
+	return result;
+}
+
+// 先从后向前删除不再显示的连续行，再按 next 的顺序插入新的连续行
+// 保留的行顺序改变时整体重置
+void SymbolListModel::updateRows(const QStringList &next) {
+	QSet<QString> nextSet(next.constBegin(), next.constEnd());
+	QSet<QString> kept;
+	for (auto &row : rows) {
+		if (nextSet.contains(row)) {
+			kept.insert(row);
+		}
+	}
+	int keptRow = 0;
+	for (auto &row : next) {
+		if (!kept.contains(row)) {
+			continue;
+		}
+		while (!kept.contains(rows[keptRow])) {
+			keptRow++;
+		}
+		if (rows[keptRow++] != row) {
+			beginResetModel();
+			rows = next;
+			endResetModel();
+			return;
+		}
+	}
+
+	for (int end = rows.size(); end > 0;) {
+		if (kept.contains(rows[end - 1])) {
+			end--;
+			continue;
+		}
+		int begin = end - 1;
+		while (begin > 0 && !kept.contains(rows[begin - 1])) {
+			begin--;
+		}
+		beginRemoveRows(QModelIndex(), begin, end - 1);
+		rows.remove(begin, end - begin);
+		endRemoveRows();
+		end = begin;
+	}
+	for (int i = 0; i < next.size();) {
+		if (kept.contains(next[i])) {
+			i++;
+			continue;
+		}
+		int end = i + 1;
+		while (end < next.size() && !kept.contains(next[end])) {
+			end++;
+		}
+		beginInsertRows(QModelIndex(), i, end - 1);
+		rows.insert(i, end - i, QString());
+		std::copy(next.begin() + i, next.begin() + end, rows.begin() + i);
+		endInsertRows();
+		i = end;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QStringList>
+
+// 符号列表：更新时只通知删除与插入的行，视图保留选择与滚动位置
+// 以 setFilter 过滤显示的符号，过滤索引随符号的增删更新
+class SymbolListModel : public QAbstractListModel {
+	Q_OBJECT
+
+public:
+	explicit SymbolListModel(QObject *parent = nullptr);
+
+	virtual int
+	rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	virtual QVariant data(const QModelIndex &index,
+						  int role = Qt::DisplayRole) const override;
+
+	// symbols 中的符号互不相同
+	void setSymbols(const QStringList &symbols);
+	// 只显示包含 filter 的符号，不区分大小写；为空时显示全部
+	void setFilter(const QString &filter);
+
+private:
+	QStringList filtered(const QStringList &candidates) const;
+	void updateRows(const QStringList &rows);
+
+	QStringList symbols;
+	// 符号到大小写折叠后文本的索引，过滤时不再逐个折叠
+	QHash<QString, QString> folded;
+	QString filter;
+	// 视图中显示的行
+	QStringList rows;
+};
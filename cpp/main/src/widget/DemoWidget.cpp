@@ -605,8 +605,9 @@ void DemoWidget::drawimpl_LR0_ItemClosure(const PaintContext &ctx) {
 			edge.to == variable.loopVariableK) {
 			ctx.painter->setPen(QColor(0xff, 0x88, 0));
 		}
+		auto label = variable.symbols.name(variable.closureMap.edges[i].symbol);
 		ctx.painter->drawText(edge.keyPointX[0] + 8, edge.keyPointY[0] - 4,
-							  variable.closureMap.edges[i].symbol);
+							  label);
 		for (int i = 0; i < edge.keyPointCount - 1; i++) {
 			ctx.painter->drawLine(edge.keyPointX[i], edge.keyPointY[i],
 								  edge.keyPointX[i + 1], edge.keyPointY[i + 1]);
@@ -665,8 +666,9 @@ void DemoWidget::drawimpl_LR0_AutomationTable(const PaintContext &ctx) {
 			ctx.painter->drawText(column2X[i], y, str);
 		};
 		draw(terminals[i]);
+		auto symbol = variable.symbols.id(terminals[i]);
 		for (int j = 0; j < variable.actionTable.size(); j++) {
-			draw(variable.actionTable[j][terminals[i]]);
+			draw(variable.actionTable[j].value(symbol));
 		}
 	}
 	y = height;
@@ -702,8 +704,9 @@ void DemoWidget::drawimpl_LR0_AutomationTable(const PaintContext &ctx) {
 			ctx.painter->drawText(column3X[i], y, str);
 		};
 		draw(nonterminals[i]);
+		auto symbol = variable.symbols.id(nonterminals[i]);
 		for (int j = 0; j < variable.gotoTable.size(); j++) {
-			auto jump = variable.gotoTable[j][nonterminals[i]];
+			auto jump = variable.gotoTable[j].value(symbol);
 			if (jump == -1) {
 				draw("");
 			} else {
@@ -857,8 +860,9 @@ void DemoWidget::drawimpl_LR1_ItemClosure(const PaintContext &ctx) {
 			edge.to == variable.loopVariableK) {
 			ctx.painter->setPen(QColor(0xff, 0x88, 0));
 		}
+		auto label = variable.symbols.name(variable.closureMap.edges[i].symbol);
 		ctx.painter->drawText(edge.keyPointX[0] + 8, edge.keyPointY[0] - 4,
-							  variable.closureMap.edges[i].symbol);
+							  label);
 		for (int i = 0; i < edge.keyPointCount - 1; i++) {
 			ctx.painter->drawLine(edge.keyPointX[i], edge.keyPointY[i],
 								  edge.keyPointX[i + 1], edge.keyPointY[i + 1]);
@@ -917,8 +921,9 @@ void DemoWidget::drawimpl_LR1_AutomationTable(const PaintContext &ctx) {
 			ctx.painter->drawText(column2X[i], y, str);
 		};
 		draw(terminals[i]);
+		auto symbol = variable.symbols.id(terminals[i]);
 		for (int j = 0; j < variable.actionTable.size(); j++) {
-			draw(variable.actionTable[j][terminals[i]]);
+			draw(variable.actionTable[j].value(symbol));
 		}
 	}
 	y = height;
@@ -954,8 +959,9 @@ void DemoWidget::drawimpl_LR1_AutomationTable(const PaintContext &ctx) {
 			ctx.painter->drawText(column3X[i], y, str);
 		};
 		draw(nonterminals[i]);
+		auto symbol = variable.symbols.id(nonterminals[i]);
 		for (int j = 0; j < variable.gotoTable.size(); j++) {
-			auto jump = variable.gotoTable[j][nonterminals[i]];
+			auto jump = variable.gotoTable[j].value(symbol);
 			if (jump == -1) {
 				draw("");
 			} else {
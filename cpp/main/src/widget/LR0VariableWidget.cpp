@@ -325,9 +325,9 @@ void LR0VariableWidget::paintLR0ItemClosure(const PaintContext &ctx, int left,
 			edge.to == variable.loopVariableK) {
 			ctx.painter->setPen(QColor(0xff, 0x88, 0));
 		}
+		auto label = variable.symbols.name(variable.closureMap.edges[i].symbol);
 		ctx.painter->drawText(left + edge.keyPointX[0] + 8,
-							  top + edge.keyPointY[0] - 4,
-							  variable.closureMap.edges[i].symbol);
+							  top + edge.keyPointY[0] - 4, label);
 		for (int i = 0; i < edge.keyPointCount - 1; i++) {
 			ctx.painter->drawLine(
 				left + edge.keyPointX[i], top + edge.keyPointY[i],
@@ -386,8 +386,9 @@ void LR0VariableWidget::paintAutomatonTable(const PaintContext &ctx, int left,
 			ctx.painter->drawText(column2X[i], y, str);
 		};
 		draw(terminals[i]);
+		auto symbol = variable.symbols.id(terminals[i]);
 		for (int j = 0; j < variable.actionTable.size(); j++) {
-			draw(variable.actionTable[j][terminals[i]]);
+			draw(variable.actionTable[j].value(symbol));
 		}
 	}
 	y = top + height;
@@ -423,8 +424,9 @@ void LR0VariableWidget::paintAutomatonTable(const PaintContext &ctx, int left,
 			ctx.painter->drawText(column3X[i], y, str);
 		};
 		draw(nonterminals[i]);
+		auto symbol = variable.symbols.id(nonterminals[i]);
 		for (int j = 0; j < variable.gotoTable.size(); j++) {
-			auto jump = variable.gotoTable[j][nonterminals[i]];
+			auto jump = variable.gotoTable[j].value(symbol);
 			if (jump == -1) {
 				draw("");
 			} else {
@@ -237,9 +237,9 @@ void LR1VariableWidget::paintLR1ItemClosure(const PaintContext &ctx, int left,
 			edge.to == variable.loopVariableK) {
 			ctx.painter->setPen(QColor(0xff, 0x88, 0));
 		}
+		auto label = variable.symbols.name(variable.closureMap.edges[i].symbol);
 		ctx.painter->drawText(left + edge.keyPointX[0] + 8,
-							  top + edge.keyPointY[0] - 4,
-							  variable.closureMap.edges[i].symbol);
+							  top + edge.keyPointY[0] - 4, label);
 		for (int i = 0; i < edge.keyPointCount - 1; i++) {
 			ctx.painter->drawLine(
 				left + edge.keyPointX[i], top + edge.keyPointY[i],
@@ -298,8 +298,9 @@ void LR1VariableWidget::paintAutomatonTable(const PaintContext &ctx, int left,
 			ctx.painter->drawText(column2X[i], y, str);
 		};
 		draw(terminals[i]);
+		auto symbol = variable.symbols.id(terminals[i]);
 		for (int j = 0; j < variable.actionTable.size(); j++) {
-			draw(variable.actionTable[j][terminals[i]]);
+			draw(variable.actionTable[j].value(symbol));
 		}
 	}
 	y = top + height;
@@ -335,8 +336,9 @@ void LR1VariableWidget::paintAutomatonTable(const PaintContext &ctx, int left,
 			ctx.painter->drawText(column3X[i], y, str);
 		};
 		draw(nonterminals[i]);
+		auto symbol = variable.symbols.id(nonterminals[i]);
 		for (int j = 0; j < variable.gotoTable.size(); j++) {
-			auto jump = variable.gotoTable[j][nonterminals[i]];
+			auto jump = variable.gotoTable[j].value(symbol);
 			if (jump == -1) {
 				draw("");
 			} else {
@@ -453,5 +455,5 @@ QString LR1VariableWidget::getItemString(const ipc::LRItem &item) {
 	if (production.size() - 1 == item.progress) {
 		prod += " ·";
 	}
-	return prod + " , " + item.lookahead;
+	return prod + " , " + variable.symbols.name(item.lookahead);
 }
\ No newline at end of file
@@ -26,13 +26,15 @@ type Point struct {
 
 // 调试上下文
 type DebugContext struct {
-	DebugRunMode RunMode     // 运行模式
-	BreakPoints  []*Point    // 断点
-	CurrentPoint *Point      // 当前执行点
-	Variables    interface{} // 当前变量
-	Lock         sync.Mutex  // 锁
-	Condition    *sync.Cond  // 条件变量
-	ExitResult   interface{} // 退出结果
+	DebugRunMode RunMode       // 运行模式
+	BreakPoints  []*Point      // 断点
+	CurrentPoint *Point        // 当前执行点
+	Variables    interface{}   // 当前变量
+	Version      int           // 埋点版本，每次埋点加一
+	Lock         sync.Mutex    // 锁
+	Condition    *sync.Cond    // 条件变量
+	ExitResult   interface{}   // 退出结果
+	Listener     func(RunMode) // 暂停或退出时回调，在释放锁后调用，可以阻塞
 }
 
 func NewDebugContext() *DebugContext {
@@ -48,6 +50,7 @@ func (ctx *DebugContext) RunReport(point *Point, variables interface{}) {
 	defer ctx.Lock.Unlock()
 	ctx.CurrentPoint = point
 	ctx.Variables = variables
+	ctx.Version++
 	if utilslice.LinearSearch(len(ctx.BreakPoints), func(i int) bool {
 		return ctx.BreakPoints[i].Line == point.Line && ctx.BreakPoints[i].Name == point.Name
 	}) != -1 {
@@ -56,6 +59,12 @@ func (ctx *DebugContext) RunReport(point *Point, variables interface{}) {
 	if ctx.DebugRunMode == RunMode_Pause {
 		ctx.DebugRunMode = RunMode_Paused
 	}
+	if ctx.DebugRunMode == RunMode_Paused && ctx.Listener != nil {
+		// 回调期间运行模式可能已被切换，重新加锁后按最新的模式继续
+		ctx.Lock.Unlock()
+		ctx.Listener(RunMode_Paused)
+		ctx.Lock.Lock()
+	}
 	for ctx.DebugRunMode == RunMode_Paused {
 		ctx.Condition.Wait()
 	}
@@ -116,6 +125,17 @@ func (ctx *DebugContext) GetVariables() (interface{}, *Point) {
 	return nil, nil
 }
 
+// 获取变量、执行点与埋点版本
+// 版本相同时变量未变化；若未暂停，返回 nil, nil, 0
+func (ctx *DebugContext) GetVersionedVariables() (interface{}, *Point, int) {
+	ctx.Lock.Lock()
+	defer ctx.Lock.Unlock()
+	if ctx.DebugRunMode == RunMode_Paused {
+		return ctx.Variables, ctx.CurrentPoint, ctx.Version
+	}
+	return nil, nil, 0
+}
+
 // 获取当前运行模式
 // 加入内存屏障保证获取最新值
 func (ctx *DebugContext) GetCurrentRunMode() RunMode {
@@ -126,11 +146,22 @@ func (ctx *DebugContext) GetCurrentRunMode() RunMode {
 
 // 启动测试 goroutine
 func StartDebugGoroutine(entry func(ctx *DebugContext)) *DebugContext {
+	return StartDebugGoroutineWithListener(entry, nil)
+}
+
+// 启动测试 goroutine，并监听暂停与退出
+func StartDebugGoroutineWithListener(entry func(ctx *DebugContext), listener func(RunMode)) *DebugContext {
 	ctx := NewDebugContext()
+	ctx.Listener = listener
 	ctx.SwitchRunMode(RunMode_Pause)
 	go func() {
 		defer func() {
+			ctx.Lock.Lock()
 			ctx.DebugRunMode = RunMode_Exit
+			ctx.Lock.Unlock()
+			if ctx.Listener != nil {
+				ctx.Listener(RunMode_Exit)
+			}
 			if err := recover(); err != nil {
 				if errErr, ok := err.(error); ok {
 					if errors.Is(errErr, errExit) {
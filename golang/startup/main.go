@@ -7,20 +7,30 @@ import (
 	"log"
 	"os"
 	"os/exec"
+	"runtime"
 
 	"github.com/chushi0/graduation_project/golang/startup/service"
 )
 
 var (
 	rpcinChannel  chan []byte
-	rpcoutChannel chan []byte
+	rpcoutChannel chan interface{} // JSON 格式的 []byte 或 *service.Response
 
 	logFile = flag.Bool("log", false, "记录日志")
+	ipcMode = flag.String("ipc", transportCBOR, "IPC 传输编码：cbor、json、line（按行 JSON，便于调试）")
+	ipcShm  = flag.Bool("shm", true, "较大的响应经共享内存文件传输")
+	ipcZlib = flag.Bool("compress", true, "较大的响应帧经 zlib 压缩")
+	workers = flag.Int("workers", runtime.NumCPU(), "并发处理请求的 goroutine 数，同一会话的请求仍串行执行")
+
+	workerMode = flag.Bool("worker", false, "作为工作进程运行：在标准输入输出上以按行 JSON 处理请求，不启动客户端")
+	isolate    = flag.Int("isolate", 30, "LR(1)/LALR 文法的产生式不少于该数量时在独立的工作进程中计算，0 表示不启用")
+	poolSize   = flag.Int("pool", runtime.NumCPU(), "同时运行的工作进程数上限")
 )
 
 func init() {
-	rpcinChannel = make(chan []byte, 1)
-	rpcoutChannel = make(chan []byte, 1)
+	// 服务处理较慢时读取 goroutine 继续读取，使取消消息能及时处理
+	rpcinChannel = make(chan []byte, 64)
+	rpcoutChannel = make(chan interface{}, 1)
 }
 
 func main() {
@@ -29,6 +39,13 @@ func main() {
 	}()
 
 	flag.Parse()
+	if *workers < 1 {
+		*workers = 1
+	}
+	if *workerMode {
+		serveWorker()
+		return
+	}
 	var err error
 	if *logFile {
 		logFile, err := os.Create("golang-log.log")
@@ -39,13 +56,19 @@ func main() {
 		log.SetOutput(logFile)
 	}
 
-	proc := exec.Command("main")
+	// 其余参数转交客户端，如 -- --generate lr1,lalr a.txt b.txt 批量生成代码
+	proc := exec.Command("main", flag.Args()...)
 	stdin, _ := proc.StdinPipe()
 	stdout, _ := proc.StdoutPipe()
 	stderr, _ := proc.StderrPipe()
-	go rpcinReader(stdout)
-	go rpcoutWriter(stdin)
-	go serviceProc()
+	if *isolate > 0 {
+		pool = newWorkerPool()
+	}
+	go rpcTransportProc(stdout, stdin)
+	for i := 0; i < *workers; i++ {
+		go serviceProc()
+	}
+	go eventProc()
 	go logProc(stderr)
 	err = proc.Run()
 	if err != nil {
@@ -53,35 +76,74 @@ func main() {
 	}
 }
 
-func rpcinReader(pipe io.ReadCloser) {
-	buf := bufio.NewReader(pipe)
+// 协商传输方式后启动读写 goroutine
+func rpcTransportProc(inPipe io.ReadCloser, outPipe io.WriteCloser) {
+	in := bufio.NewReader(inPipe)
+	out := bufio.NewWriter(outPipe)
+	transport, first, err := negotiateTransport(in, out, *ipcMode, *ipcShm, *ipcZlib)
+	if err != nil {
+		exitOnInputClosed(err)
+		log.Fatalf("rpc transport negotiate fail: %v", err)
+		return
+	}
+	service.SetEncoding(transport.Framed && transport.Encoding == transportCBOR)
+	log.Printf("rpc transport: framed=%v encoding=%s shm=%v compression=%s", transport.Framed, transport.Encoding, transport.Ring != nil, transport.Compression)
+	if first != nil {
+		dispatchRequest(first)
+	}
+	go rpcinReader(transport, in)
+	go rpcoutWriter(transport, out)
+}
+
+func rpcinReader(transport *rpcTransport, buf *bufio.Reader) {
 	for {
-		body := make([]byte, 0)
-		for {
-			line, isPrefix, err := buf.ReadLine()
-			if err != nil {
-				log.Fatalf("rpcinReader goroutine broken: %v", err)
-				return
-			}
-			body = append(body, line...)
-			if !isPrefix {
-				break
-			}
+		body, err := transport.ReadMessage(buf)
+		if err != nil {
+			exitOnInputClosed(err)
+			log.Fatalf("rpcinReader goroutine broken: %v", err)
+			return
 		}
-		rpcinChannel <- body
+		dispatchRequest(body)
 	}
 }
 
-func rpcoutWriter(pipe io.WriteCloser) {
-	buf := bufio.NewWriter(pipe)
+// 会话所在的工作进程处理的请求直接转发，其余请求进入服务队列
+func dispatchRequest(body []byte) {
+	if pool != nil && pool.Route(body) {
+		return
+	}
+	if service.ReceiveRequest(body) {
+		log.Printf("rpc cancel: %v", string(body))
+		return
+	}
+	rpcinChannel <- body
+}
+
+// 工作进程：由池启动，标准输入关闭表示池已回收该进程
+// 日志经标准错误由池转发，时间由池记录
+func serveWorker() {
+	log.SetFlags(0)
+	go rpcTransportProc(os.Stdin, os.Stdout)
+	for i := 0; i < *workers; i++ {
+		go serviceProc()
+	}
+	go eventProc()
+	select {}
+}
+
+func exitOnInputClosed(err error) {
+	if *workerMode && err == io.EOF {
+		os.Exit(0)
+	}
+}
+
+func rpcoutWriter(transport *rpcTransport, buf *bufio.Writer) {
 	for {
 		resp := <-rpcoutChannel
-		resp = append(resp, '\n')
-		_, err := buf.Write(resp)
+		err := transport.WriteMessage(buf, resp)
 		if err != nil {
 			log.Fatalf("rpcoutWriter goroutine broken: %v", err)
 		}
-		buf.Flush()
 	}
 }
 
@@ -89,16 +151,25 @@ func serviceProc() {
 	for {
 		req := <-rpcinChannel
 		log.Printf("rpc request: %v", string(req))
-		resp, err := service.CallService(req)
+		resp, err := service.HandleRequest(req)
 		if err != nil {
 			log.Printf("service process fail: %s (req: %s)", err, req)
-			resp = []byte(`{"code":500,"data":{}}`)
+			resp = service.ErrorResponse(req)
 		}
-		log.Printf("rpc response: %v", string(resp))
+		log.Printf("rpc response: code=%d id=%s", resp.Code, resp.ID)
 		rpcoutChannel <- resp
 	}
 }
 
+// 转发服务端主动推送的事件
+func eventProc() {
+	for {
+		event := <-service.Events
+		log.Printf("rpc event: %v", string(event))
+		rpcoutChannel <- event
+	}
+}
+
 func logProc(pipe io.ReadCloser) {
 	buf := bufio.NewReader(pipe)
 	for {
@@ -0,0 +1,410 @@
+package main
+
+import (
+	"bufio"
+	"encoding/json"
+	"flag"
+	"io"
+	"log"
+	"os"
+	"os/exec"
+	"strings"
+	"sync"
+
+	"github.com/chushi0/graduation_project/golang/startup/production"
+	"github.com/chushi0/graduation_project/golang/startup/service"
+)
+
+// 工作进程池：产生式较多的 LR(1)/LALR 会话在独立的后端进程中计算，
+// 内存耗尽或崩溃时只影响该会话，其余会话仍在本进程中处理
+// 会话新建后固定在所在的工作进程，之后的请求按会话 id 原样转发，响应也原样转发给客户端；
+// 会话释放后工作进程退出以归还内存，池中保留空闲进程供下一个会话使用
+// 与工作进程之间使用按行 JSON
+
+// 保留的空闲工作进程数
+const workerSpare = 1
+
+// 工作进程的参数中不转发的选项
+var workerExcludeFlags = map[string]bool{
+	"log": true, "ipc": true, "shm": true, "compress": true,
+	"worker": true, "isolate": true, "pool": true,
+}
+
+type backendWorker struct {
+	cmd      *exec.Cmd
+	stdin    io.WriteCloser
+	lock     sync.Mutex // 保护 stdin 的写入与关闭
+	sessions map[string]bool
+	pending  int  // 已转发、尚未响应的请求数
+	retired  bool // 已由池回收
+}
+
+// 已转发、尚未响应的请求
+type workerRoute struct {
+	worker  *backendWorker
+	created int    // 新建会话的请求，batch 中为子请求下标；-1 表示不新建会话
+	batch   bool   // 批量请求
+	release string // 释放的会话
+}
+
+type workerPool struct {
+	executable string
+
+	lock     sync.Mutex
+	spare    []*backendWorker
+	running  int // 运行中的工作进程数，包括空闲进程
+	sessions map[string]*backendWorker
+	routes   map[string]*workerRoute // 按请求 id 索引
+}
+
+type routedRequest struct {
+	Action string          `json:"action"`
+	Data   json.RawMessage `json:"data"`
+	ID     json.RawMessage `json:"id,omitempty"`
+}
+
+type routedData struct {
+	ID       string          `json:"id"`
+	Code     string          `json:"code"`
+	Requests []routedRequest `json:"requests"`
+}
+
+var pool *workerPool
+
+// 无法取得本程序路径时返回 nil，所有会话在本进程中处理
+func newWorkerPool() *workerPool {
+	executable, err := os.Executable()
+	if err != nil {
+		log.Printf("worker pool disabled: %v", err)
+		return nil
+	}
+	return &workerPool{
+		executable: executable,
+		sessions:   make(map[string]*backendWorker),
+		routes:     make(map[string]*workerRoute),
+	}
+}
+
+// 产生式较多的 LR(1)/LALR 会话需要独立的工作进程
+// 由读取 goroutine 调用，只做词法扫描，数到 isolate 条产生式即停止；字符串中的符号不计入
+func isolated(action, code string) bool {
+	if action != "lr1_process_request" || code == "" {
+		return false
+	}
+	return production.CountProductions(code, *isolate) >= *isolate
+}
+
+// 由读取 goroutine 调用；返回 true 表示已转发给工作进程，本进程不再处理
+// 取消消息转发给有未完成请求的工作进程，本进程同样处理
+func (pool *workerPool) Route(body []byte) bool {
+	var req routedRequest
+	if json.Unmarshal(body, &req) != nil {
+		return false
+	}
+	if req.Action == "ipc_cancel" {
+		pool.broadcast(body)
+		return false
+	}
+	var data routedData
+	json.Unmarshal(req.Data, &data)
+	route := &workerRoute{created: -1}
+	if req.Action == "batch" {
+		// 批量请求整体转发：作用于已有会话时转发给其所在进程，新建的会话也固定在该进程
+		route.batch = true
+		for i, sub := range data.Requests {
+			var subData routedData
+			json.Unmarshal(sub.Data, &subData)
+			if route.created < 0 && isolated(sub.Action, subData.Code) {
+				route.created = i
+			}
+			if route.worker == nil && subData.ID != "" {
+				route.worker = pool.session(subData.ID)
+			}
+		}
+	} else {
+		if isolated(req.Action, data.Code) {
+			route.created = 0
+		}
+		if data.ID != "" {
+			route.worker = pool.session(data.ID)
+		}
+		if strings.HasSuffix(req.Action, "_process_release") {
+			route.release = data.ID
+		}
+	}
+
+	pool.lock.Lock()
+	if route.worker == nil && route.created >= 0 && len(req.ID) > 0 {
+		route.worker = pool.take()
+	}
+	worker := route.worker
+	if worker == nil || worker.retired {
+		pool.lock.Unlock()
+		return false
+	}
+	if len(req.ID) > 0 {
+		worker.pending++
+		pool.routes[string(req.ID)] = route
+	}
+	pool.lock.Unlock()
+	worker.write(body)
+	return true
+}
+
+func (pool *workerPool) session(id string) *backendWorker {
+	pool.lock.Lock()
+	defer pool.lock.Unlock()
+	return pool.sessions[id]
+}
+
+// 取出空闲进程，没有时启动新进程；达到上限时返回 nil，调用时须持有锁
+func (pool *workerPool) take() *backendWorker {
+	var worker *backendWorker
+	if n := len(pool.spare); n > 0 {
+		worker = pool.spare[n-1]
+		pool.spare = pool.spare[:n-1]
+	} else if pool.running < *poolSize {
+		var err error
+		if worker, err = pool.start(); err != nil {
+			log.Printf("worker start fail: %v", err)
+			return nil
+		}
+	} else {
+		log.Printf("worker pool full (%d), run session locally", pool.running)
+		return nil
+	}
+	go pool.refill()
+	return worker
+}
+
+// 补充空闲进程
+func (pool *workerPool) refill() {
+	pool.lock.Lock()
+	defer pool.lock.Unlock()
+	for len(pool.spare) < workerSpare && pool.running < *poolSize {
+		worker, err := pool.start()
+		if err != nil {
+			log.Printf("worker start fail: %v", err)
+			return
+		}
+		pool.spare = append(pool.spare, worker)
+	}
+}
+
+// 启动工作进程，转发本进程显式设置的选项，调用时须持有锁
+func (pool *workerPool) start() (*backendWorker, error) {
+	args := []string{"-worker"}
+	flag.Visit(func(f *flag.Flag) {
+		if !workerExcludeFlags[f.Name] {
+			args = append(args, "-"+f.Name+"="+f.Value.String())
+		}
+	})
+	cmd := exec.Command(pool.executable, args...)
+	stdin, err := cmd.StdinPipe()
+	if err != nil {
+		return nil, err
+	}
+	stdout, err := cmd.StdoutPipe()
+	if err != nil {
+		return nil, err
+	}
+	stderr, err := cmd.StderrPipe()
+	if err != nil {
+		return nil, err
+	}
+	if err = cmd.Start(); err != nil {
+		return nil, err
+	}
+	worker := &backendWorker{
+		cmd:      cmd,
+		stdin:    stdin,
+		sessions: make(map[string]bool),
+	}
+	pool.running++
+	log.Printf("worker %d started", cmd.Process.Pid)
+	logged := make(chan struct{})
+	go func() {
+		workerLogProc(cmd.Process.Pid, stderr)
+		close(logged)
+	}()
+	go pool.readProc(worker, stdout, logged)
+	return worker, nil
+}
+
+func (worker *backendWorker) write(body []byte) {
+	worker.lock.Lock()
+	defer worker.lock.Unlock()
+	// 写入失败时进程已退出，由读取 goroutine 使未完成的请求失败
+	if _, err := worker.stdin.Write(append(body, '\n')); err != nil {
+		log.Printf("worker %d write fail: %v", worker.cmd.Process.Pid, err)
+	}
+}
+
+// 关闭标准输入，工作进程随即退出
+func (worker *backendWorker) close() {
+	worker.lock.Lock()
+	defer worker.lock.Unlock()
+	worker.stdin.Close()
+}
+
+func (pool *workerPool) broadcast(body []byte) {
+	pool.lock.Lock()
+	workers := make(map[*backendWorker]bool)
+	for _, route := range pool.routes {
+		workers[route.worker] = true
+	}
+	pool.lock.Unlock()
+	for worker := range workers {
+		worker.write(body)
+	}
+}
+
+// 转发工作进程的响应与事件，进程退出后清理
+func (pool *workerPool) readProc(worker *backendWorker, stdout io.Reader, logged chan struct{}) {
+	in := bufio.NewReader(stdout)
+	for {
+		msg, err := readLine(in)
+		if err != nil {
+			break
+		}
+		pool.receive(worker, msg)
+		rpcoutChannel <- forwardMessage(msg)
+	}
+	<-logged
+	pool.exited(worker, worker.cmd.Wait())
+}
+
+// 新建会话成功时固定到该进程；会话释放后进程没有会话与未完成的请求时回收
+func (pool *workerPool) receive(worker *backendWorker, msg []byte) {
+	var resp struct {
+		ID json.RawMessage `json:"id"`
+	}
+	if json.Unmarshal(msg, &resp) != nil || len(resp.ID) == 0 {
+		return
+	}
+	pool.lock.Lock()
+	defer pool.lock.Unlock()
+	route, ok := pool.routes[string(resp.ID)]
+	if !ok || route.worker != worker {
+		return
+	}
+	delete(pool.routes, string(resp.ID))
+	worker.pending--
+	if route.created >= 0 {
+		if id := createdSession(msg, route); id != "" {
+			worker.sessions[id] = true
+			pool.sessions[id] = worker
+			log.Printf("worker %d: session %s", worker.cmd.Process.Pid, id)
+		}
+	}
+	if route.release != "" && worker.sessions[route.release] {
+		delete(worker.sessions, route.release)
+		delete(pool.sessions, route.release)
+	}
+	if len(worker.sessions) == 0 && worker.pending == 0 && !worker.retired {
+		worker.retired = true
+		go worker.close()
+	}
+}
+
+// 响应中新建会话的 id，失败时返回空
+func createdSession(msg []byte, route *workerRoute) string {
+	type created struct {
+		Code int `json:"code"`
+		Data struct {
+			ID string `json:"id"`
+		} `json:"data"`
+	}
+	if !route.batch {
+		var resp created
+		if json.Unmarshal(msg, &resp) != nil || resp.Code != 0 {
+			return ""
+		}
+		return resp.Data.ID
+	}
+	var resp struct {
+		Code int `json:"code"`
+		Data struct {
+			Results []created `json:"results"`
+		} `json:"data"`
+	}
+	if json.Unmarshal(msg, &resp) != nil || resp.Code != 0 || route.created >= len(resp.Data.Results) {
+		return ""
+	}
+	result := resp.Data.Results[route.created]
+	if result.Code != 0 {
+		return ""
+	}
+	return result.Data.ID
+}
+
+// 较大的响应按响应转发，data 由传输层转码一次并可经共享内存传输；其余消息原样转发
+func forwardMessage(msg []byte) interface{} {
+	if len(msg) < sharedMemoryThreshold {
+		return msg
+	}
+	var resp struct {
+		Code int             `json:"code"`
+		Data json.RawMessage `json:"data"`
+		ID   json.RawMessage `json:"id"`
+	}
+	if json.Unmarshal(msg, &resp) != nil || len(resp.ID) == 0 {
+		return msg
+	}
+	return &service.Response{Code: resp.Code, Data: resp.Data, ID: resp.ID}
+}
+
+// 工作进程退出：未完成的请求以 500 失败，其上的会话视为已退出，之后的请求由本进程回复不存在
+func (pool *workerPool) exited(worker *backendWorker, err error) {
+	pool.lock.Lock()
+	pool.running--
+	for i, spare := range pool.spare {
+		if spare == worker {
+			pool.spare = append(pool.spare[:i], pool.spare[i+1:]...)
+			break
+		}
+	}
+	var failed []string
+	for id, route := range pool.routes {
+		if route.worker == worker {
+			failed = append(failed, id)
+			delete(pool.routes, id)
+		}
+	}
+	var lost []string
+	for id := range worker.sessions {
+		lost = append(lost, id)
+		delete(pool.sessions, id)
+	}
+	retired := worker.retired
+	worker.retired = true
+	pool.lock.Unlock()
+
+	pid := worker.cmd.Process.Pid
+	if !retired {
+		log.Printf("worker %d exited: %v, %d sessions lost", pid, err, len(lost))
+	} else {
+		log.Printf("worker %d recycled", pid)
+	}
+	for _, id := range failed {
+		rpcoutChannel <- service.ErrorResponse([]byte(`{"id":` + id + `}`))
+	}
+	for _, id := range lost {
+		service.PostEvent(service.Event_ProcessExited, id)
+	}
+	// 异常退出的空闲进程不再补充，避免无法启动时反复重试
+	if retired {
+		pool.refill()
+	}
+}
+
+func workerLogProc(pid int, pipe io.Reader) {
+	buf := bufio.NewReader(pipe)
+	for {
+		line, err := readLine(buf)
+		if err != nil {
+			return
+		}
+		log.Printf("worker %d: %s", pid, line)
+	}
+}
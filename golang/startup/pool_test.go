@@ -0,0 +1,233 @@
+package main
+
+import (
+	"bufio"
+	"encoding/json"
+	"fmt"
+	"os"
+	"strconv"
+	"syscall"
+	"testing"
+	"time"
+
+	"github.com/chushi0/graduation_project/golang/startup/service"
+)
+
+// 设置该环境变量时测试程序作为模拟的工作进程运行
+const fakeWorkerEnv = "POOL_TEST_FAKE_WORKER"
+
+func TestMain(m *testing.M) {
+	if os.Getenv(fakeWorkerEnv) != "" {
+		fakeWorker()
+		return
+	}
+	os.Exit(m.Run())
+}
+
+// 模拟的工作进程：新建会话时回复以进程号命名的会话，其余请求回复进程号，收到 crash 时立即退出
+func fakeWorker() {
+	in := bufio.NewReader(os.Stdin)
+	pid := os.Getpid()
+	for {
+		line, err := readLine(in)
+		if err != nil {
+			os.Exit(0)
+		}
+		var req struct {
+			Action string          `json:"action"`
+			ID     json.RawMessage `json:"id"`
+		}
+		json.Unmarshal(line, &req)
+		var data interface{}
+		switch req.Action {
+		case "lr1_process_request":
+			data = map[string]string{"id": fmt.Sprintf("session-%d", pid)}
+		case "lr1_process_crash":
+			os.Exit(2)
+		default:
+			data = map[string]int{"pid": pid}
+		}
+		resp, _ := json.Marshal(map[string]interface{}{"code": 0, "data": data, "id": req.ID})
+		fmt.Printf("%s\n", resp)
+	}
+}
+
+func newTestPool(t *testing.T) *workerPool {
+	os.Setenv(fakeWorkerEnv, "1")
+	*isolate, *poolSize = 3, 3
+	testPool := newWorkerPool()
+	if testPool == nil {
+		t.Fatal("pool unavailable")
+	}
+	return testPool
+}
+
+// 结束时关闭所有工作进程
+func closeTestPool(testPool *workerPool) {
+	testPool.lock.Lock()
+	workers := append([]*backendWorker{}, testPool.spare...)
+	for _, worker := range testPool.sessions {
+		workers = append(workers, worker)
+	}
+	testPool.lock.Unlock()
+	for _, worker := range workers {
+		worker.close()
+	}
+}
+
+// 只有一个 :=，但有三个产生式
+const isolatedCode = "S := a\n| b\n| c\n"
+
+func routeRequest(t *testing.T, testPool *workerPool, id int, action string, data interface{}) bool {
+	body, _ := json.Marshal(map[string]interface{}{"action": action, "data": data, "id": id})
+	return testPool.Route(body)
+}
+
+// 读取转发的消息，返回响应的 code 与 data
+func readForwarded(t *testing.T, id int) (int, map[string]interface{}) {
+	select {
+	case msg := <-rpcoutChannel:
+		switch msg := msg.(type) {
+		case []byte:
+			var resp struct {
+				Code int                    `json:"code"`
+				Data map[string]interface{} `json:"data"`
+				ID   int                    `json:"id"`
+			}
+			json.Unmarshal(msg, &resp)
+			if resp.ID != id {
+				t.Fatalf("unexpected response %s", msg)
+			}
+			return resp.Code, resp.Data
+		case *service.Response:
+			if string(msg.ID) != strconv.Itoa(id) {
+				t.Fatalf("unexpected response %+v", msg)
+			}
+			return msg.Code, nil
+		}
+		t.Fatalf("unexpected message %T", msg)
+	case <-time.After(10 * time.Second):
+		t.Fatalf("response %d timeout", id)
+	}
+	return 0, nil
+}
+
+// 等待条件成立
+func waitPool(t *testing.T, testPool *workerPool, cond func() bool) {
+	for i := 0; i < 1000; i++ {
+		testPool.lock.Lock()
+		ok := cond()
+		testPool.lock.Unlock()
+		if ok {
+			return
+		}
+		time.Sleep(10 * time.Millisecond)
+	}
+	t.Fatal("pool state timeout")
+}
+
+func TestIsolated(t *testing.T) {
+	*isolate = 3
+	if !isolated("lr1_process_request", isolatedCode) {
+		t.Fatal("three productions should be isolated")
+	}
+	// 字符串中的 := 不是产生式
+	if isolated("lr1_process_request", `S := ":=" ":=" ":="`) {
+		t.Fatal("symbols in strings should not count")
+	}
+	if isolated("lr0_process_request", isolatedCode) || isolated("lr1_process_request", "") {
+		t.Fatal("only lr1 sessions are isolated")
+	}
+}
+
+func TestWorkerPoolPinning(t *testing.T) {
+	testPool := newTestPool(t)
+	defer closeTestPool(testPool)
+
+	// 较小的文法在本进程中处理
+	if routeRequest(t, testPool, 1, "lr1_process_request", map[string]string{"code": "S := a"}) {
+		t.Fatal("small grammar should run locally")
+	}
+	if !routeRequest(t, testPool, 2, "lr1_process_request", map[string]string{"code": isolatedCode}) {
+		t.Fatal("large grammar should be isolated")
+	}
+	code, data := readForwarded(t, 2)
+	session, _ := data["id"].(string)
+	if code != 0 || session == "" {
+		t.Fatalf("create session fail: %d %v", code, data)
+	}
+	// 之后的请求转发给同一进程
+	for i := 3; i < 6; i++ {
+		if !routeRequest(t, testPool, i, "lr1_process_variables", map[string]string{"id": session}) {
+			t.Fatal("session request should be routed")
+		}
+		_, data = readForwarded(t, i)
+		if fmt.Sprintf("session-%v", data["pid"]) != session {
+			t.Fatalf("request %d not pinned: %v", i, data)
+		}
+	}
+	if routeRequest(t, testPool, 6, "lr1_process_variables", map[string]string{"id": "local"}) {
+		t.Fatal("unknown session should run locally")
+	}
+}
+
+func TestWorkerPoolRetire(t *testing.T) {
+	testPool := newTestPool(t)
+	defer closeTestPool(testPool)
+
+	routeRequest(t, testPool, 1, "lr1_process_request", map[string]string{"code": isolatedCode})
+	_, data := readForwarded(t, 1)
+	session := data["id"].(string)
+	testPool.lock.Lock()
+	worker := testPool.sessions[session]
+	testPool.lock.Unlock()
+
+	if !routeRequest(t, testPool, 2, "lr1_process_release", map[string]string{"id": session}) {
+		t.Fatal("release should be routed")
+	}
+	readForwarded(t, 2)
+	// 会话释放后进程被回收，池中仍保留空闲进程；进程退出并回收后不能再发送信号
+	waitPool(t, testPool, func() bool {
+		return worker.retired && len(testPool.sessions) == 0 && worker.cmd.Process.Signal(syscall.Signal(0)) != nil
+	})
+	waitPool(t, testPool, func() bool {
+		return len(testPool.spare) == workerSpare
+	})
+	if routeRequest(t, testPool, 3, "lr1_process_variables", map[string]string{"id": session}) {
+		t.Fatal("released session should not be routed")
+	}
+}
+
+func TestWorkerPoolExited(t *testing.T) {
+	testPool := newTestPool(t)
+	defer closeTestPool(testPool)
+
+	routeRequest(t, testPool, 1, "lr1_process_request", map[string]string{"code": isolatedCode})
+	_, data := readForwarded(t, 1)
+	session := data["id"].(string)
+
+	// 进程异常退出：未完成的请求以 500 失败，会话推送已退出
+	routeRequest(t, testPool, 2, "lr1_process_crash", map[string]string{"id": session})
+	if code, _ := readForwarded(t, 2); code != 500 {
+		t.Fatalf("expect 500, got %d", code)
+	}
+	// 其他用例关闭的进程上的会话同样推送事件，跳过
+	for exited := false; !exited; {
+		select {
+		case event := <-service.Events:
+			var msg struct {
+				Event string `json:"event"`
+				Data  struct {
+					ID string `json:"id"`
+				} `json:"data"`
+			}
+			json.Unmarshal(event, &msg)
+			exited = msg.Event == service.Event_ProcessExited && msg.Data.ID == session
+		case <-time.After(10 * time.Second):
+			t.Fatal("exit event timeout")
+		}
+	}
+	if routeRequest(t, testPool, 3, "lr1_process_variables", map[string]string{"id": session}) {
+		t.Fatal("lost session should not be routed")
+	}
+}
@@ -1,6 +1,10 @@
 package production
 
-import "github.com/chushi0/graduation_project/golang/startup/util/set"
+import (
+	"sync/atomic"
+
+	"github.com/chushi0/graduation_project/golang/startup/util/set"
+)
 
 // 词法分析自动机
 var fa *FiniteAutomaton
@@ -26,13 +30,160 @@ func init() {
 	fa = identify.MergeOr(product).MergeOr(asciiSymbol).MergeOr(escape).AsDFA()
 }
 
-func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *ErrorContainer) {
+// 中断标志由其他 goroutine 设置，原子地读取
+func interrupted(interruptFlag *int32) bool {
+	return interruptFlag != nil && atomic.LoadInt32(interruptFlag) != 0
+}
+
+func ParseProduction(code string, interruptFlag *int32) ([]Production, string, *ErrorContainer) {
+	lexer := &Lexer{
+		ErrorContainer: NewErrorContainer(),
+		Io:             NewIOFromString(code),
+		DFA:            fa,
+	}
+	return parseTokens(lexer, lexer.ErrorContainer, interruptFlag)
+}
+
+func NewLineCache() *LineCache {
+	return &LineCache{lines: make(map[string]*lexedLine)}
+}
+
+// 与 ParseProduction 相同，但只对缓存中没有的行做词法分析
+// 缓存随后替换为本次的各行，结果（包括错误的顺序）与 ParseProduction 一致
+func ParseProductionCached(code string, cache *LineCache, interruptFlag *int32) ([]Production, string, *ErrorContainer) {
+	cache.lock.Lock()
+	known := cache.lines
+	cache.lock.Unlock()
+
+	lines := splitLines(code)
+	source := &lineSource{
+		lines:     make([]*lexedLine, len(lines)),
+		container: NewErrorContainer(),
+	}
+	current := make(map[string]*lexedLine, len(lines))
+	for i, line := range lines {
+		if interrupted(interruptFlag) {
+			return nil, "", nil
+		}
+		lexed, ok := current[line]
+		if !ok {
+			if lexed, ok = known[line]; !ok {
+				lexed = lexLine(line)
+			}
+			current[line] = lexed
+		}
+		source.lines[i] = lexed
+	}
+	cache.lock.Lock()
+	cache.lines = current
+	cache.lock.Unlock()
+	return parseTokens(source, source.container, interruptFlag)
+}
+
+// 统计产生式的数量，达到 limit 后不再继续扫描
+// 与 parseTokens 相同，以行首的非终结符、:= 或 | 开始一条产生式，不构建产生式也不记录错误
+func CountProductions(code string, limit int) int {
 	lexer := &Lexer{
 		ErrorContainer: NewErrorContainer(),
 		Io:             NewIOFromString(code),
 		DFA:            fa,
 	}
+	count := 0
+	lastLineNo := 0
+	for count < limit {
+		token := lexer.NextToken()
+		if token == nil {
+			break
+		}
+		if token.Line == lastLineNo {
+			continue
+		}
+		lastLineNo = token.Line
+		if token.Tag == tagIdentify || token.Tag == tagProduct ||
+			token.Tag == tagSymbol && token.RawValue == "|" && count > 0 {
+			count++
+		}
+	}
+	return count
+}
+
+// 按 ReadChar 的换行规则（\r\n、\r、\n）切分，每行保留行尾的换行符
+func splitLines(code string) []string {
+	lines := make([]string, 0)
+	start := 0
+	for i := 0; i < len(code); i++ {
+		switch code[i] {
+		case '\r':
+			if i+1 < len(code) && code[i+1] == '\n' {
+				i++
+			}
+		case '\n':
+		default:
+			continue
+		}
+		lines = append(lines, code[start:i+1])
+		start = i + 1
+	}
+	if start < len(code) {
+		lines = append(lines, code[start:])
+	}
+	return lines
+}
+
+func lexLine(line string) *lexedLine {
+	lexer := &Lexer{
+		ErrorContainer: NewErrorContainer(),
+		Io:             NewIOFromString(line),
+		DFA:            fa,
+	}
+	lexed := &lexedLine{}
+	for {
+		token := lexer.NextToken()
+		for _, err := range lexer.ErrorContainer.Errors[len(lexed.errors):] {
+			lexed.errors = append(lexed.errors, err)
+			lexed.errorAt = append(lexed.errorAt, len(lexed.tokens))
+		}
+		if token == nil {
+			return lexed
+		}
+		lexed.tokens = append(lexed.tokens, token)
+	}
+}
 
+// 依次返回各行缓存的单词，行号加上所在行的偏移
+// 词法错误在其后的单词返回前写入，与逐字符分析时的顺序相同
+type lineSource struct {
+	lines     []*lexedLine
+	container *ErrorContainer
+	line      int // 当前行
+	token     int // 当前行中下一个单词
+	error     int // 当前行中下一个错误
+}
+
+func (source *lineSource) NextToken() *Token {
+	for source.line < len(source.lines) {
+		lexed := source.lines[source.line]
+		for source.error < len(lexed.errors) && lexed.errorAt[source.error] <= source.token {
+			err := *lexed.errors[source.error]
+			err.Line += source.line
+			source.container.Errors = append(source.container.Errors, &err)
+			source.error++
+		}
+		if source.token < len(lexed.tokens) {
+			token := *lexed.tokens[source.token]
+			token.Line += source.line
+			source.token++
+			return &token
+		}
+		source.line++
+		source.token = 0
+		source.error = 0
+	}
+	return nil
+}
+
+// 语法分析：将单词组织为产生式
+func parseTokens(source tokenSource, container *ErrorContainer, interruptFlag *int32) ([]Production, string, *ErrorContainer) {
 	result := make([]Production, 0)
 
 	var lastProduction Production = nil
@@ -42,10 +193,10 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 	var startSymbol string
 	startSymbolState := 0
 	for {
-		if interruptFlag != nil && *interruptFlag {
+		if interrupted(interruptFlag) {
 			return nil, "", nil
 		}
-		token := lexer.NextToken()
+		token := source.NextToken()
 		if token == nil {
 			break
 		}
@@ -53,7 +204,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 			switch startSymbolState {
 			case 0:
 				if token.RawValue != "@" {
-					lexer.ErrorContainer.Warnings = append(lexer.ErrorContainer.Warnings, &Error{
+					container.Warnings = append(container.Warnings, &Error{
 						Type: ErrorType_StartSymbolNotDeclear,
 					})
 					startSymbolState = -1
@@ -64,7 +215,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 				startToken = token
 			case 1:
 				if startToken.Line != token.Line || token.Tag != tagIdentify {
-					lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+					container.Errors = append(container.Errors, &Error{
 						Type:   ErrorType_InvalidSyntax,
 						Line:   startToken.Line,
 						Column: startToken.Column + len([]rune(startToken.RawValue)),
@@ -80,7 +231,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 					startSymbolState = -1
 					goto nocontinue
 				}
-				lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+				container.Errors = append(container.Errors, &Error{
 					Type:   ErrorType_TooManyStartSymbolDeclear,
 					Line:   token.Line,
 					Column: token.Column,
@@ -94,7 +245,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 		if token.Line != lastLineNo {
 			if startToken != nil && !productionProductSymbol {
 				productionProductSymbol = true
-				lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+				container.Errors = append(container.Errors, &Error{
 					Type:   ErrorType_MissingProduct,
 					Line:   startToken.Line,
 					Column: startToken.Column + len([]rune(startToken.RawValue)),
@@ -110,7 +261,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 				productionProductSymbol = false
 				startToken = token
 				if startChar := token.RawValue[0]; startChar >= '0' && startChar <= '9' {
-					lexer.ErrorContainer.Warnings = append(lexer.ErrorContainer.Warnings, &Error{
+					container.Warnings = append(container.Warnings, &Error{
 						Type:   ErrorType_NotSuggestNonterminal,
 						Line:   token.Line,
 						Column: token.Column,
@@ -118,7 +269,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 					})
 				}
 			} else if token.Tag == tagProduct {
-				lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+				container.Errors = append(container.Errors, &Error{
 					Type:   ErrorType_MissingNonterminal,
 					Line:   token.Line,
 					Column: token.Column,
@@ -131,7 +282,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 				lastProduction[0] = result[len(result)-1][0]
 				productionProductSymbol = true
 			} else {
-				lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+				container.Errors = append(container.Errors, &Error{
 					Type:   ErrorType_InvalidSyntax,
 					Line:   token.Line,
 					Column: token.Column,
@@ -143,7 +294,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 		}
 		lastLineNo = token.Line
 		if lastProduction == nil {
-			lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+			container.Errors = append(container.Errors, &Error{
 				Type:   ErrorType_InvalidSyntax,
 				Line:   token.Line,
 				Column: token.Column,
@@ -156,14 +307,14 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 			if token.Tag == tagProduct {
 				continue
 			}
-			lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+			container.Errors = append(container.Errors, &Error{
 				Type:   ErrorType_MissingProduct,
 				Line:   token.Line,
 				Column: token.Column,
 			})
 		}
 		if token.Tag == tagProduct {
-			lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+			container.Errors = append(container.Errors, &Error{
 				Type:   ErrorType_TooManyProduct,
 				Line:   token.Line,
 				Column: token.Column,
@@ -175,12 +326,12 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 	}
 	if startSymbolState == 0 {
 		startSymbol = "S"
-		lexer.ErrorContainer.Warnings = append(lexer.ErrorContainer.Warnings, &Error{
+		container.Warnings = append(container.Warnings, &Error{
 			Type: ErrorType_StartSymbolNotDeclear,
 		})
 	}
 	if startSymbolState == 1 {
-		lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+		container.Errors = append(container.Errors, &Error{
 			Type:   ErrorType_InvalidSyntax,
 			Line:   startToken.Line,
 			Column: startToken.Column + len([]rune(startToken.RawValue)),
@@ -189,7 +340,7 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 	}
 	if lastProduction != nil {
 		if !productionProductSymbol {
-			lexer.ErrorContainer.Errors = append(lexer.ErrorContainer.Errors, &Error{
+			container.Errors = append(container.Errors, &Error{
 				Type:   ErrorType_MissingProduct,
 				Line:   startToken.Line,
 				Column: startToken.Column + len([]rune(startToken.RawValue)),
@@ -205,11 +356,11 @@ func ParseProduction(code string, interruptFlag *bool) ([]Production, string, *E
 		}
 	}
 	if !found {
-		lexer.ErrorContainer.Warnings = append(lexer.ErrorContainer.Warnings, &Error{
+		container.Warnings = append(container.Warnings, &Error{
 			Type: ErrorType_NoStartSymbol,
 		})
 	}
-	return result, startSymbol, lexer.ErrorContainer
+	return result, startSymbol, container
 }
 
 func GetTerminalsAndNonterminals(productions []Production) (terminals, nonterminals set.StringSet) {
@@ -0,0 +1,95 @@
+package process
+
+import (
+	"crypto/sha256"
+	"encoding/hex"
+	"encoding/json"
+	"flag"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+
+	"github.com/chushi0/graduation_project/golang/startup/production"
+	"github.com/chushi0/graduation_project/golang/startup/util/cbor"
+)
+
+// 自动机缓存：生成代码时以（规范化的文法、算法、选项）为键，
+// 将计算完成的关键变量（项目集闭包、Action 表、Goto 表等）以 CBOR 保存在缓存目录中，
+// 文法未改变时跳过计算直接生成代码
+var automatonCache = flag.String("automaton-cache", defaultAutomatonCacheDir(), "自动机缓存目录，为空时不缓存")
+
+// 关键变量的结构改变时递增，使旧的缓存失效
+const automatonCacheVersion = 1
+
+func defaultAutomatonCacheDir() string {
+	dir, err := os.UserCacheDir()
+	if err != nil {
+		return ""
+	}
+	return filepath.Join(dir, "graduation_project", "automaton")
+}
+
+// 缓存键：产生式经解析后不含注释与空白，增广后的开始符号一并计入
+func automatonCacheKey(algorithm string, productions []production.Production, start string) string {
+	raw, _ := json.Marshal(struct {
+		Version     int                     `json:"version"`
+		Algorithm   string                  `json:"algorithm"`
+		Golang      bool                    `json:"golang"`
+		Start       string                  `json:"start"`
+		Productions []production.Production `json:"productions"`
+	}{automatonCacheVersion, algorithm, *golang, start, productions})
+	sum := sha256.Sum256(raw)
+	return hex.EncodeToString(sum[:])
+}
+
+func automatonCachePath(key string) string {
+	return filepath.Join(*automatonCache, key+".cbor")
+}
+
+// 读取缓存的关键变量，不存在或无法解码时返回 false
+func loadAutomaton(key string, variables interface{}) bool {
+	if *automatonCache == "" {
+		return false
+	}
+	data, err := ioutil.ReadFile(automatonCachePath(key))
+	if err != nil {
+		return false
+	}
+	raw, err := cbor.ToJSON(data)
+	if err != nil {
+		return false
+	}
+	return json.Unmarshal(raw, variables) == nil
+}
+
+// 保存关键变量，先写入临时文件再改名，并发生成时不会读到不完整的文件
+func storeAutomaton(key string, variables interface{}) {
+	if *automatonCache == "" {
+		return
+	}
+	raw, err := json.Marshal(variables)
+	if err != nil {
+		return
+	}
+	data, err := cbor.FromJSON(raw)
+	if err != nil {
+		return
+	}
+	if err := os.MkdirAll(*automatonCache, 0755); err != nil {
+		return
+	}
+	file, err := ioutil.TempFile(*automatonCache, key+".*.tmp")
+	if err != nil {
+		return
+	}
+	_, err = file.Write(data)
+	if closeErr := file.Close(); err == nil {
+		err = closeErr
+	}
+	if err == nil {
+		err = os.Rename(file.Name(), automatonCachePath(key))
+	}
+	if err != nil {
+		os.Remove(file.Name())
+	}
+}
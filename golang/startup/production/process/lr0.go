@@ -99,6 +99,21 @@ func (ctx *LR0Context) RunPipeline() {
 	ctx.ParseCode()
 	// 转换为增广文法
 	ctx.Translate()
+	// 生成代码时文法未改变则直接使用缓存的自动机
+	var cacheKey string
+	if ctx.CodeSaver.Enable {
+		algorithm := "lr0"
+		if ctx.SLR {
+			algorithm = "slr"
+		}
+		cacheKey = automatonCacheKey(algorithm, ctx.KeyVariables.Productions, ctx.Grammer.StartNonterminal)
+		cached := &LR0Variables{}
+		if loadAutomaton(cacheKey, cached) {
+			*ctx.KeyVariables = *cached
+			ctx.GenerateYaccCode()
+			return
+		}
+	}
 	// SLR的情况：计算 First 集和 Follow 集
 	if ctx.SLR {
 		ctx.ComputeFirstSet()
@@ -110,6 +125,7 @@ func (ctx *LR0Context) RunPipeline() {
 	// 生成自动机
 	ctx.GenerateAutomaton()
 	if ctx.CodeSaver.Enable {
+		storeAutomaton(cacheKey, ctx.KeyVariables)
 		ctx.GenerateYaccCode()
 	}
 }
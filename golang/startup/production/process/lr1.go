@@ -98,6 +98,21 @@ func (ctx *LR1Context) shutdownPipeline(res *LR1Result) {
 func (ctx *LR1Context) RunPipeline() {
 	ctx.ParseCode()
 	ctx.Translate()
+	// 生成代码时文法未改变则直接使用缓存的自动机
+	var cacheKey string
+	if ctx.CodeSaver.Enable {
+		algorithm := "lr1"
+		if ctx.LALR {
+			algorithm = "lalr"
+		}
+		cacheKey = automatonCacheKey(algorithm, ctx.KeyVariables.Productions, ctx.Grammer.StartNonterminal)
+		cached := &LR1Variables{}
+		if loadAutomaton(cacheKey, cached) {
+			*ctx.KeyVariables = *cached
+			ctx.GenerateYaccCode()
+			return
+		}
+	}
 	ctx.ComputeFirstSet()
 	ctx.ComputeItemClosure()
 	if ctx.LALR {
@@ -108,6 +123,7 @@ func (ctx *LR1Context) RunPipeline() {
 	}
 	ctx.GenerateAutomaton()
 	if ctx.CodeSaver.Enable {
+		storeAutomaton(cacheKey, ctx.KeyVariables)
 		ctx.GenerateYaccCode()
 	}
 }
@@ -4,10 +4,13 @@ import (
 	"bufio"
 	"encoding/csv"
 	"encoding/json"
+	"flag"
 	"fmt"
 	"io/ioutil"
 	"os"
+	"path/filepath"
 	"strconv"
+	"strings"
 	"testing"
 	"time"
 
@@ -153,3 +156,65 @@ func TestGetItemLink(t *testing.T) {
 	}
 	panic(link)
 }
+
+// 运行至退出
+func runLR1ToExit(ctx *process.LR1Context) *debug.DebugContext {
+	exited := make(chan struct{}, 1)
+	dbg := debug.StartDebugGoroutineWithListener(ctx.CreateLR1ProcessEntry(), func(mode debug.RunMode) {
+		if mode == debug.RunMode_Exit {
+			exited <- struct{}{}
+		}
+	})
+	dbg.SwitchRunMode(debug.RunMode_Run)
+	<-exited
+	return dbg
+}
+
+func TestLR1AutomatonCache(t *testing.T) {
+	dir, err := ioutil.TempDir("", "automaton")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	flag.Set("automaton-cache", filepath.Join(dir, "cache"))
+
+	var variables [2][]byte
+	var reports [2]int
+	for i := range variables {
+		ctx := process.NewLR1Context()
+		ctx.Code = `
+		S := S0
+		S0 := L = R
+		S0 := R
+		L := * R
+		L := id
+		R := L
+		`
+		// 空白不影响缓存
+		if i > 0 {
+			ctx.Code = strings.ReplaceAll(ctx.Code, " := ", "\t:=\t") + "\n\n"
+		}
+		ctx.LALR = true
+		ctx.CodeSaver.Enable = true
+		ctx.CodeSaver.SavePath = filepath.Join(dir, fmt.Sprintf("parser%d", i))
+		ctx.CodeSaver.Normalize()
+		dbg := runLR1ToExit(ctx)
+		if res := dbg.ExitResult.(*process.LR1Result); res.Code != process.LR1_Success {
+			t.Fatalf("run %d failed: %d", i, res.Code)
+		}
+		reports[i] = dbg.Version
+		ctx.KeyVariables.CodePath = ""
+		variables[i], _ = json.Marshal(ctx.KeyVariables)
+	}
+	files, _ := ioutil.ReadDir(filepath.Join(dir, "cache"))
+	if len(files) != 1 {
+		t.Fatalf("expect one cache file, got %d", len(files))
+	}
+	// 命中缓存时跳过计算，埋点只剩开始、转换与退出
+	if reports[1] >= reports[0] {
+		t.Fatalf("cache not used: %d reports, first run %d", reports[1], reports[0])
+	}
+	if string(variables[0]) != string(variables[1]) {
+		t.Fatalf("cached automaton mismatch:\n%s\n%s", variables[0], variables[1])
+	}
+}
@@ -1,6 +1,7 @@
 package production_test
 
 import (
+	"reflect"
 	"testing"
 
 	"github.com/chushi0/graduation_project/golang/startup/production"
@@ -16,3 +17,41 @@ func TestProduction(t *testing.T) {
 		t.Fail()
 	}
 }
+
+func TestCountProductions(t *testing.T) {
+	codes := []string{
+		"@S\nS := A b\n| c $ d\nA := \"a\n",
+		"@S\r\nS := A b\r\n| c d\r\nA := a := $\r\n\r\n",
+		"S := A b\rA := \"x y\" $\r:= c\n  \n| e",
+		"| a\nS := \":=\" \":=\"\n@ T\n",
+	}
+	for _, code := range codes {
+		expect, _, _ := production.ParseProduction(code, nil)
+		if count := production.CountProductions(code, 100); count != len(expect) {
+			t.Errorf("count %d for %q, expect %d", count, code, len(expect))
+		}
+	}
+	if count := production.CountProductions(codes[0], 2); count != 2 {
+		t.Errorf("count should stop at limit: %d", count)
+	}
+}
+
+func TestParseProductionCached(t *testing.T) {
+	codes := []string{
+		"@S\nS := A b\n| c $ d\nA := \"a\n",
+		"@S\r\nS := A b\r\n| c d\r\nA := a := $\r\n\r\n",
+		"S := A b\rA := \"x y\" $\r:= c\n  \n| e",
+		"@S T\nS := A b\n| c d\nA := a\nB\n",
+	}
+	cache := production.NewLineCache()
+	for _, code := range codes {
+		expect, expectStart, expectErrors := production.ParseProduction(code, nil)
+		result, start, errors := production.ParseProductionCached(code, cache, nil)
+		if !reflect.DeepEqual(result, expect) || start != expectStart {
+			t.Errorf("productions mismatch for %q:\n%v %s\n%v %s", code, result, start, expect, expectStart)
+		}
+		if !reflect.DeepEqual(errors, expectErrors) {
+			t.Errorf("errors mismatch for %q", code)
+		}
+	}
+}
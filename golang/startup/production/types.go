@@ -3,6 +3,7 @@ package production
 import (
 	"errors"
 	"fmt"
+	"sync"
 
 	"github.com/chushi0/graduation_project/golang/startup/util/set"
 )
@@ -63,6 +64,27 @@ type Token struct {
 	File     string // 文件名
 }
 
+// 单词的来源，按顺序返回单词，词法错误写入各自的错误容器
+type tokenSource interface {
+	NextToken() *Token
+}
+
+// 一行的词法分析结果，行号从 1 开始
+// errorAt[i] 为 errors[i] 之后的第一个单词的下标，用于还原错误与单词的先后顺序
+type lexedLine struct {
+	tokens  []*Token
+	errors  []*Error
+	errorAt []int
+}
+
+// 按行缓存的词法分析结果
+// 单词不跨行，行内容相同时分析结果相同，编辑后只需重新分析内容变化的行
+// 每次解析以新的映射替换，读取中的映射不被修改，可以同时解析
+type LineCache struct {
+	lock  sync.Mutex
+	lines map[string]*lexedLine
+}
+
 type ErrorContainer struct {
 	Fatal    []*Error `json:"fatal"`
 	Errors   []*Error `json:"error"`
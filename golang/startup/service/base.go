@@ -1,6 +1,7 @@
 package service
 
 import (
+	"context"
 	"encoding/json"
 	"fmt"
 	"runtime"
@@ -8,12 +9,35 @@ import (
 
 type Service = func(req json.RawMessage) (code int, resp interface{}, err error)
 
-var services map[string]Service = make(map[string]Service)
+// 可取消的服务：客户端放弃请求后 ctx 被取消，耗时的服务应尽快以 CodeCancelled 返回
+type ContextService = func(ctx context.Context, req json.RawMessage) (code int, resp interface{}, err error)
 
-func CallService(rawReq []byte) (rawResp []byte, err error) {
+var services map[string]ContextService = make(map[string]ContextService)
+
+// 服务的响应，由主程序按协商的负载编码直接编码，data 只编码一次
+type Response struct {
+	Code int             `json:"code"`
+	Data interface{}     `json:"data"`
+	ID   json.RawMessage `json:"id,omitempty"`
+}
+
+// 处理请求并返回 JSON 格式的响应
+func CallService(rawReq []byte) ([]byte, error) {
+	resp, err := HandleRequest(rawReq)
+	if err != nil {
+		return nil, err
+	}
+	rawResp, err := json.Marshal(resp)
+	if err != nil {
+		return nil, fmt.Errorf("marshal to json fail: %w", err)
+	}
+	return rawResp, nil
+}
+
+func HandleRequest(rawReq []byte) (resp *Response, err error) {
 	defer func() {
 		if errRecover := recover(); errRecover != nil {
-			rawResp = nil
+			resp = nil
 			buf := make([]byte, 1<<16)
 			len := runtime.Stack(buf, false)
 			err = fmt.Errorf("service panic: %v\n%v", errRecover, buf[:len])
@@ -23,11 +47,9 @@ func CallService(rawReq []byte) (rawResp []byte, err error) {
 	var req struct {
 		Action string          `json:"action"`
 		Data   json.RawMessage `json:"data"`
+		ID     json.RawMessage `json:"id,omitempty"`
 	}
-	var resp struct {
-		Code int         `json:"code"`
-		Data interface{} `json:"data"`
-	}
+	resp = &Response{}
 
 	err = json.Unmarshal(rawReq, &req)
 	if err != nil {
@@ -39,19 +61,38 @@ func CallService(rawReq []byte) (rawResp []byte, err error) {
 		return nil, fmt.Errorf("service %s not found", req.Action)
 	}
 
-	resp.Code, resp.Data, err = service(req.Data)
+	// 回传请求 id，客户端据此匹配乱序到达的响应
+	resp.ID = req.ID
+	ctx, finish := beginRequest(req.ID)
+	defer finish()
+	if ctx.Err() != nil {
+		// 排队期间已被客户端放弃，不再执行
+		resp.Code, resp.Data = CodeCancelled, struct{}{}
+	} else {
+		resp.Code, resp.Data, err = service(ctx, req.Data)
+	}
 	if err != nil {
 		return nil, fmt.Errorf("service return error: %w", err)
 	}
+	return resp, nil
+}
 
-	rawResp, err = json.Marshal(resp)
-	if err != nil {
-		return nil, fmt.Errorf("marshal to json fail: %w", err)
+// 服务处理失败时的响应，同样回传请求 id
+func ErrorResponse(rawReq []byte) *Response {
+	var req struct {
+		ID json.RawMessage `json:"id,omitempty"`
 	}
-	return rawResp, nil
+	json.Unmarshal(rawReq, &req)
+	return &Response{Code: 500, Data: struct{}{}, ID: req.ID}
 }
 
 func RegisteService(name string, service Service) {
+	RegisteContextService(name, func(ctx context.Context, req json.RawMessage) (int, interface{}, error) {
+		return service(req)
+	})
+}
+
+func RegisteContextService(name string, service ContextService) {
 	if _, ok := services[name]; ok {
 		panic(fmt.Sprintf("service %v has been regester", name))
 	}
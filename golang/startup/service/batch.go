@@ -0,0 +1,109 @@
+package service
+
+import (
+	"context"
+	"encoding/json"
+	"fmt"
+	"log"
+	"runtime"
+)
+
+func init() {
+	RegisteContextService("batch", Batch)
+}
+
+type batchRequest struct {
+	Action string          `json:"action"`
+	Data   json.RawMessage `json:"data"`
+	// 以之前某个子请求返回的 id 作为本请求的 id，用于新建会话后立即操作
+	IDFrom *int `json:"id_from,omitempty"`
+}
+
+type batchResult struct {
+	Code int         `json:"code"`
+	Data interface{} `json:"data"`
+}
+
+// 批量请求：在一次分派中按顺序执行多个子请求，结果按请求顺序返回
+// 子请求失败时该项的 code 为 500，不影响之后的子请求；
+// 客户端放弃后其余子请求的 code 为 CodeCancelled
+func Batch(ctx context.Context, req json.RawMessage) (code int, resp interface{}, err error) {
+	var reqStruct struct {
+		Requests []batchRequest `json:"requests"`
+	}
+	err = json.Unmarshal(req, &reqStruct)
+	if err != nil {
+		return
+	}
+	results := make([]batchResult, len(reqStruct.Requests))
+	for i, sub := range reqStruct.Requests {
+		if ctx.Err() != nil {
+			results[i] = batchResult{Code: CodeCancelled, Data: struct{}{}}
+			continue
+		}
+		data := sub.Data
+		if sub.IDFrom != nil {
+			if data, err = batchInjectID(data, results, *sub.IDFrom, i); err != nil {
+				log.Printf("batch request %d fail: %s", i, err)
+				results[i] = batchResult{Code: 500, Data: struct{}{}}
+				continue
+			}
+		}
+		results[i] = callBatchService(ctx, i, sub.Action, data)
+	}
+	var respStruct struct {
+		Results []batchResult `json:"results"`
+	}
+	respStruct.Results = results
+	resp = respStruct
+	return 0, resp, nil
+}
+
+func callBatchService(ctx context.Context, index int, action string, data json.RawMessage) (result batchResult) {
+	defer func() {
+		if errRecover := recover(); errRecover != nil {
+			buf := make([]byte, 1<<16)
+			len := runtime.Stack(buf, false)
+			log.Printf("batch request %d panic: %v\n%s", index, errRecover, buf[:len])
+			result = batchResult{Code: 500, Data: struct{}{}}
+		}
+	}()
+	service, exist := services[action]
+	if !exist || action == "batch" {
+		log.Printf("batch request %d fail: service %s not found", index, action)
+		return batchResult{Code: 500, Data: struct{}{}}
+	}
+	code, resp, err := service(ctx, data)
+	if err != nil {
+		log.Printf("batch request %d fail: %s", index, err)
+		return batchResult{Code: 500, Data: struct{}{}}
+	}
+	return batchResult{Code: code, Data: resp}
+}
+
+func batchInjectID(data json.RawMessage, results []batchResult, from, index int) (json.RawMessage, error) {
+	if from < 0 || from >= index {
+		return nil, fmt.Errorf("invalid id_from %d", from)
+	}
+	if results[from].Code != 0 {
+		return nil, fmt.Errorf("request %d failed", from)
+	}
+	raw, err := json.Marshal(results[from].Data)
+	if err != nil {
+		return nil, err
+	}
+	var source struct {
+		ID string `json:"id"`
+	}
+	if err = json.Unmarshal(raw, &source); err != nil {
+		return nil, err
+	}
+	fields := make(map[string]json.RawMessage)
+	if len(data) > 0 && string(data) != "null" {
+		if err = json.Unmarshal(data, &fields); err != nil {
+			return nil, err
+		}
+	}
+	fields["id"], _ = json.Marshal(source.ID)
+	return json.Marshal(fields)
+}
@@ -0,0 +1,71 @@
+package service_test
+
+import (
+	"encoding/json"
+	"errors"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/service"
+)
+
+func init() {
+	service.RegisteService("test_batch_open", func(req json.RawMessage) (int, interface{}, error) {
+		return 0, map[string]string{"id": "session"}, nil
+	})
+	service.RegisteService("test_batch_echo", func(req json.RawMessage) (int, interface{}, error) {
+		var data map[string]interface{}
+		err := json.Unmarshal(req, &data)
+		return 0, data, err
+	})
+	service.RegisteService("test_batch_fail", func(req json.RawMessage) (int, interface{}, error) {
+		return 0, nil, errors.New("fail")
+	})
+	service.RegisteService("test_batch_panic", func(req json.RawMessage) (int, interface{}, error) {
+		panic("panic")
+	})
+}
+
+func TestBatch(t *testing.T) {
+	req := `{"action":"batch","id":7,"data":{"requests":[
+		{"action":"test_batch_open","data":{}},
+		{"action":"test_batch_fail","data":{}},
+		{"action":"test_batch_echo","data":{"mode":1},"id_from":0},
+		{"action":"test_batch_panic","data":{}},
+		{"action":"test_batch_echo","data":{},"id_from":1},
+		{"action":"batch","data":{"requests":[]}},
+		{"action":"test_batch_echo","data":{"x":2}}
+	]}}`
+	raw, err := service.CallService([]byte(req))
+	if err != nil {
+		t.Fatal(err)
+	}
+	var resp struct {
+		Code int `json:"code"`
+		ID   int `json:"id"`
+		Data struct {
+			Results []struct {
+				Code int                    `json:"code"`
+				Data map[string]interface{} `json:"data"`
+			} `json:"results"`
+		} `json:"data"`
+	}
+	if err = json.Unmarshal(raw, &resp); err != nil {
+		t.Fatal(err)
+	}
+	results := resp.Data.Results
+	if resp.Code != 0 || resp.ID != 7 || len(results) != 7 {
+		t.Fatalf("unexpected response %s", raw)
+	}
+	codes := []int{0, 500, 0, 500, 500, 500, 0}
+	for i, code := range codes {
+		if results[i].Code != code {
+			t.Fatalf("result %d: code %d, want %d (%s)", i, results[i].Code, code, raw)
+		}
+	}
+	if results[2].Data["id"] != "session" || results[2].Data["mode"] != 1.0 {
+		t.Fatalf("id_from not applied: %v", results[2].Data)
+	}
+	if results[6].Data["x"] != 2.0 {
+		t.Fatalf("unexpected result %v", results[6].Data)
+	}
+}
@@ -0,0 +1,79 @@
+package service
+
+import (
+	"context"
+	"encoding/json"
+	"sync"
+)
+
+// 客户端超时或取消后放弃的请求返回该 code，客户端不再等待其响应
+const CodeCancelled = 499
+
+// 已读取、尚未处理完的请求，按请求 id 索引
+// 读取 goroutine 登记请求并处理取消消息，服务 goroutine 执行时取得对应的 context
+var (
+	pendingMutex    sync.Mutex
+	pendingRequests = make(map[string]*pendingRequest)
+)
+
+type pendingRequest struct {
+	ctx    context.Context
+	cancel context.CancelFunc
+}
+
+// 由读取 goroutine 在请求进入服务队列前调用
+// 返回 true 表示这是取消消息，已经处理，不需要进入服务队列，也没有响应
+func ReceiveRequest(rawReq []byte) bool {
+	var req struct {
+		Action string          `json:"action"`
+		Data   json.RawMessage `json:"data"`
+		ID     json.RawMessage `json:"id,omitempty"`
+	}
+	if json.Unmarshal(rawReq, &req) != nil {
+		return false
+	}
+	if req.Action == "ipc_cancel" {
+		var data struct {
+			IDs []json.RawMessage `json:"ids"`
+		}
+		json.Unmarshal(req.Data, &data)
+		CancelRequests(data.IDs)
+		return true
+	}
+	if len(req.ID) == 0 {
+		return false
+	}
+	ctx, cancel := context.WithCancel(context.Background())
+	pendingMutex.Lock()
+	pendingRequests[string(req.ID)] = &pendingRequest{ctx, cancel}
+	pendingMutex.Unlock()
+	return false
+}
+
+// 取消尚未处理完的请求；已完成或未知的 id 忽略
+func CancelRequests(ids []json.RawMessage) {
+	pendingMutex.Lock()
+	defer pendingMutex.Unlock()
+	for _, id := range ids {
+		if request, ok := pendingRequests[string(id)]; ok {
+			request.cancel()
+		}
+	}
+}
+
+// 取得请求的 context，处理完成后调用 finish 注销
+// 未经 ReceiveRequest 登记的请求不可取消
+func beginRequest(id json.RawMessage) (ctx context.Context, finish func()) {
+	pendingMutex.Lock()
+	request, ok := pendingRequests[string(id)]
+	pendingMutex.Unlock()
+	if !ok {
+		return context.Background(), func() {}
+	}
+	return request.ctx, func() {
+		request.cancel()
+		pendingMutex.Lock()
+		delete(pendingRequests, string(id))
+		pendingMutex.Unlock()
+	}
+}
@@ -0,0 +1,49 @@
+package service_test
+
+import (
+	"context"
+	"encoding/json"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/service"
+)
+
+func TestCancelRequest(t *testing.T) {
+	calls := 0
+	service.RegisteContextService("test_cancel", func(ctx context.Context, req json.RawMessage) (int, interface{}, error) {
+		calls++
+		return 0, struct{}{}, nil
+	})
+	code := func(raw []byte) int {
+		var resp struct {
+			Code int `json:"code"`
+		}
+		json.Unmarshal(raw, &resp)
+		return resp.Code
+	}
+
+	req := []byte(`{"action":"test_cancel","data":{},"id":3}`)
+	if service.ReceiveRequest(req) {
+		t.Fatal("request treated as cancel")
+	}
+	if !service.ReceiveRequest([]byte(`{"action":"ipc_cancel","data":{"ids":[3]}}`)) {
+		t.Fatal("cancel not recognized")
+	}
+	raw, err := service.CallService(req)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if code(raw) != service.CodeCancelled || calls != 0 {
+		t.Fatalf("cancelled request executed: %s", raw)
+	}
+
+	// 处理完成后注销，同一 id 的新请求不受之前取消的影响
+	service.ReceiveRequest(req)
+	raw, err = service.CallService(req)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if code(raw) != 0 || calls != 1 {
+		t.Fatalf("unexpected response %s", raw)
+	}
+}
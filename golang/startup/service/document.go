@@ -0,0 +1,174 @@
+package service
+
+import (
+	"sync"
+	"time"
+
+	"github.com/chushi0/graduation_project/golang/startup/production"
+)
+
+// 文本修改后等待该时间再开始解析，连续输入只解析最后的文本
+const parseDebounce = 50 * time.Millisecond
+
+// 文档超过该时间未提交、未查询时丢弃
+const documentIdleTimeout = 30 * time.Minute
+
+// 客户端编辑器中的文档，保存文本后客户端只需发送编辑
+// 每个文档同时至多解析一次；解析期间提交的文本排队，解析结束后只解析最新的文本
+type ProductionDocument struct {
+	ID    string
+	Lines *production.LineCache // 各行的词法分析结果
+
+	lock     sync.Mutex
+	text     string
+	revision int                // 最新提交的文本版本
+	parsed   int                // 最近一次完成解析的版本
+	running  *ProductionProcess // 正在进行的解析
+	result   *ProductionResult  // 最新版本的解析结果
+	timer    *time.Timer
+	waiting  bool // 等待防抖结束
+	lastUsed time.Time
+}
+
+// 文本编辑：删除 Position 起的 Deleted 个字节，再插入 Inserted；位置与长度以 UTF-8 字节计
+type TextEdit struct {
+	Position int    `json:"position"`
+	Deleted  int    `json:"deleted"`
+	Inserted string `json:"inserted"`
+}
+
+var productionDocuments = newSessionMap()
+
+func getProductionDocument(id string) (*ProductionDocument, bool) {
+	session, exist := productionDocuments.Get(id)
+	if !exist {
+		return nil, false
+	}
+	return session.(*ProductionDocument), true
+}
+
+func NewProductionDocument(id string) *ProductionDocument {
+	return &ProductionDocument{
+		ID:       id,
+		Lines:    production.NewLineCache(),
+		lastUsed: time.Now(),
+	}
+}
+
+// 以 code 为全文提交，返回其版本
+func (doc *ProductionDocument) Replace(code string) int {
+	doc.lock.Lock()
+	defer doc.lock.Unlock()
+	doc.text = code
+	return doc.submit()
+}
+
+// 按顺序应用编辑后提交，返回其版本
+// 位置越界或编辑后的字节数不等于 length 时返回 false，文本不变
+func (doc *ProductionDocument) Edit(edits []TextEdit, length int) (int, bool) {
+	doc.lock.Lock()
+	defer doc.lock.Unlock()
+	text := doc.text
+	for _, edit := range edits {
+		if edit.Position < 0 || edit.Deleted < 0 || edit.Position+edit.Deleted > len(text) {
+			return 0, false
+		}
+		text = text[:edit.Position] + edit.Inserted + text[edit.Position+edit.Deleted:]
+	}
+	if len(text) != length {
+		return 0, false
+	}
+	doc.text = text
+	return doc.submit(), true
+}
+
+// 正在解析的旧文本被中断，防抖结束后再解析新文本，调用时须持有锁
+func (doc *ProductionDocument) submit() int {
+	doc.revision++
+	doc.result = nil
+	doc.lastUsed = time.Now()
+	if doc.running != nil {
+		doc.running.Interrupt()
+	}
+	doc.waiting = true
+	if doc.timer == nil {
+		doc.timer = time.AfterFunc(parseDebounce, doc.debounced)
+	} else {
+		doc.timer.Reset(parseDebounce)
+	}
+	return doc.revision
+}
+
+func (doc *ProductionDocument) debounced() {
+	doc.lock.Lock()
+	defer doc.lock.Unlock()
+	doc.waiting = false
+	doc.start()
+}
+
+// 没有正在进行的解析且最新版本未解析时开始解析，调用时须持有锁
+func (doc *ProductionDocument) start() {
+	if doc.running != nil || doc.waiting || doc.parsed == doc.revision {
+		return
+	}
+	process := &ProductionProcess{}
+	revision, text := doc.revision, doc.text
+	doc.running = process
+	go func() {
+		ProcessProductionParse(text, doc.Lines, process)
+		doc.finish(process, revision)
+	}()
+}
+
+// 解析结束：仍是最新版本时保存结果并推送事件，否则解析排队中的最新文本
+func (doc *ProductionDocument) finish(process *ProductionProcess, revision int) {
+	doc.lock.Lock()
+	doc.running = nil
+	latest := revision == doc.revision && !process.Interrupted()
+	if latest {
+		result := process.Result
+		result.Revision = revision
+		doc.parsed = revision
+		doc.result = &result
+	} else {
+		doc.start()
+	}
+	doc.lock.Unlock()
+	// 推送可能阻塞，不能持有锁
+	if latest {
+		PostEvent(Event_ProductionParseFinished, doc.ID)
+	}
+}
+
+// 最新版本的解析结果，尚未解析完成时返回 nil
+func (doc *ProductionDocument) Result() *ProductionResult {
+	doc.lock.Lock()
+	defer doc.lock.Unlock()
+	doc.lastUsed = time.Now()
+	return doc.result
+}
+
+// 放弃尚未完成的解析，之后的查询返回未完成，直到再次提交
+func (doc *ProductionDocument) Cancel() {
+	doc.lock.Lock()
+	defer doc.lock.Unlock()
+	if doc.timer != nil {
+		doc.timer.Stop()
+	}
+	doc.waiting = false
+	if doc.running != nil {
+		doc.running.Interrupt()
+	}
+	if doc.result == nil {
+		// 新版本不会被解析
+		doc.revision++
+		doc.parsed = doc.revision
+	}
+}
+
+// 文档长时间未使用且没有进行中的解析
+func (doc *ProductionDocument) Idle(now time.Time) bool {
+	doc.lock.Lock()
+	defer doc.lock.Unlock()
+	return doc.running == nil && !doc.waiting && now.Sub(doc.lastUsed) > documentIdleTimeout
+}
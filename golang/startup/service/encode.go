@@ -0,0 +1,44 @@
+package service
+
+import (
+	"encoding/json"
+
+	"github.com/chushi0/graduation_project/golang/startup/util/cbor"
+)
+
+// 响应数据的负载编码，由主程序在传输协商后、处理请求前设置
+var cborEncoding bool
+
+func SetEncoding(useCBOR bool) {
+	cborEncoding = useCBOR
+}
+
+// 已按负载编码序列化的响应数据，传输层原样写入或写入共享内存
+// 引用会话状态的数据须在持有会话锁时编码，此后会话继续运行不影响响应
+type Encoded struct {
+	CBOR  bool
+	Bytes []byte
+}
+
+func Encode(v interface{}) (Encoded, error) {
+	if cborEncoding {
+		raw, err := cbor.Marshal(v)
+		return Encoded{CBOR: true, Bytes: raw}, err
+	}
+	raw, err := json.Marshal(v)
+	return Encoded{Bytes: raw}, err
+}
+
+func (encoded Encoded) MarshalJSON() ([]byte, error) {
+	if encoded.CBOR {
+		return cbor.ToJSON(encoded.Bytes)
+	}
+	return encoded.Bytes, nil
+}
+
+func (encoded Encoded) MarshalCBOR() ([]byte, error) {
+	if encoded.CBOR {
+		return encoded.Bytes, nil
+	}
+	return cbor.FromJSON(encoded.Bytes)
+}
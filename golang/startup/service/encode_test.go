@@ -0,0 +1,30 @@
+package service_test
+
+import (
+	"encoding/json"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/service"
+	"github.com/chushi0/graduation_project/golang/startup/util/cbor"
+)
+
+func TestEncode(t *testing.T) {
+	value := map[string]interface{}{"var": []int{1, 2}, "point": nil}
+	expect, _ := json.Marshal(value)
+	for _, useCBOR := range []bool{false, true} {
+		service.SetEncoding(useCBOR)
+		encoded, err := service.Encode(value)
+		if err != nil {
+			t.Fatal(err)
+		}
+		raw, _ := json.Marshal(map[string]interface{}{"data": encoded})
+		if string(raw) != `{"data":`+string(expect)+`}` {
+			t.Fatalf("cbor=%v: unexpected json %s", useCBOR, raw)
+		}
+		raw, _ = cbor.Marshal(encoded)
+		if json, _ := cbor.ToJSON(raw); string(json) != string(expect) {
+			t.Fatalf("cbor=%v: unexpected cbor %s", useCBOR, json)
+		}
+	}
+	service.SetEncoding(false)
+}
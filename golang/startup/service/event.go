@@ -0,0 +1,42 @@
+package service
+
+import (
+	"encoding/json"
+
+	"github.com/chushi0/graduation_project/golang/startup/debug"
+)
+
+// 服务端主动推送的事件，消息中没有请求 id
+const (
+	Event_ProductionParseFinished = "production_parse_finished"
+	Event_ProcessPaused           = "process_paused"
+	Event_ProcessExited           = "process_exited"
+)
+
+// 待发送的事件消息，由主程序转发给客户端
+var Events chan []byte = make(chan []byte, 64)
+
+func PostEvent(event string, id string) {
+	var msg struct {
+		Event string `json:"event"`
+		Data  struct {
+			ID string `json:"id"`
+		} `json:"data"`
+	}
+	msg.Event = event
+	msg.Data.ID = id
+	rawMsg, _ := json.Marshal(msg)
+	Events <- rawMsg
+}
+
+// 调试会话暂停或退出时推送事件
+func processListener(id string) func(debug.RunMode) {
+	return func(mode debug.RunMode) {
+		switch mode {
+		case debug.RunMode_Paused:
+			PostEvent(Event_ProcessPaused, id)
+		case debug.RunMode_Exit:
+			PostEvent(Event_ProcessExited, id)
+		}
+	}
+}
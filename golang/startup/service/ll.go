@@ -2,6 +2,7 @@ package service
 
 import (
 	"encoding/json"
+	"sync"
 
 	"github.com/chushi0/graduation_project/golang/startup/debug"
 	ll "github.com/chushi0/graduation_project/golang/startup/production/process"
@@ -9,11 +10,24 @@ import (
 )
 
 type LLProcess struct {
+	lock sync.Mutex // 同一会话的请求串行执行
+
 	DebugContext *debug.DebugContext
 	LLContext    *ll.LLContext
 }
 
-var llProcess map[string]*LLProcess = make(map[string]*LLProcess)
+var llProcess = newSessionMap()
+
+// 取得会话并加锁，调用方须在处理完成后解锁
+func lockLLProcess(id string) (*LLProcess, bool) {
+	session, exist := llProcess.Get(id)
+	if !exist {
+		return nil, false
+	}
+	proc := session.(*LLProcess)
+	proc.lock.Lock()
+	return proc, true
+}
 
 func init() {
 	RegisteService("ll_process_request", LLProcessRequest)
@@ -44,9 +58,9 @@ func LLProcessRequest(req json.RawMessage) (code int, resp interface{}, err erro
 		process.LLContext.Normalize()
 	}
 	entry := process.LLContext.CreateLLProcessEntry()
-	process.DebugContext = debug.StartDebugGoroutine(entry)
 	id := uuid.New()
-	llProcess[id] = process
+	process.DebugContext = debug.StartDebugGoroutineWithListener(entry, processListener(id))
+	llProcess.Put(id, process)
 	var respStruct struct {
 		ID string `json:"id"`
 	}
@@ -64,11 +78,12 @@ func LLProcessSwitchMode(req json.RawMessage) (code int, resp interface{}, err e
 	if err != nil {
 		return
 	}
-	proc, exist := llProcess[reqStruct.ID]
+	proc, exist := lockLLProcess(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.SwitchRunMode(debug.RunMode(reqStruct.Mode))
 	return
 }
@@ -81,13 +96,14 @@ func LLProcessRelease(req json.RawMessage) (code int, resp interface{}, err erro
 	if err != nil {
 		return
 	}
-	proc, exist := llProcess[reqStruct.ID]
+	proc, exist := lockLLProcess(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.SwitchRunMode(debug.RunMode_Exit)
-	delete(llProcess, reqStruct.ID)
+	llProcess.Delete(reqStruct.ID)
 	return
 }
 
@@ -103,11 +119,12 @@ func LLProcessSetBreakpoints(req json.RawMessage) (code int, resp interface{}, e
 	if err != nil {
 		return
 	}
-	proc, exist := llProcess[reqStruct.ID]
+	proc, exist := lockLLProcess(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.ClearBreakPoints()
 	for _, bp := range reqStruct.Breakpoints {
 		proc.DebugContext.AddBreakPoint(&debug.Point{
@@ -126,20 +143,22 @@ func LLProcessGetVariables(req json.RawMessage) (code int, resp interface{}, err
 	if err != nil {
 		return
 	}
-	proc, exist := llProcess[reqStruct.ID]
+	proc, exist := lockLLProcess(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	variables, point := proc.DebugContext.GetVariables()
 	if variables == nil {
 		code = 1003
 		return
 	}
-	resp = map[string]interface{}{
+	// 变量引用会话的当前状态，须在持有锁时编码
+	resp, err = Encode(map[string]interface{}{
 		"var":   variables,
 		"point": point,
-	}
+	})
 	return
 }
 
@@ -151,11 +170,12 @@ func LLProcessGetExitResult(req json.RawMessage) (code int, resp interface{}, er
 	if err != nil {
 		return
 	}
-	proc, exist := llProcess[reqStruct.ID]
+	proc, exist := lockLLProcess(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	if proc.DebugContext.GetCurrentRunMode() != debug.RunMode_Exit {
 		code = 1004
 		return
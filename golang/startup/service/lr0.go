@@ -1,7 +1,9 @@
 package service
 
 import (
+	"context"
 	"encoding/json"
+	"sync"
 
 	"github.com/chushi0/graduation_project/golang/startup/debug"
 	lr "github.com/chushi0/graduation_project/golang/startup/production/process"
@@ -9,18 +11,33 @@ import (
 )
 
 type LR0Process struct {
+	lock sync.Mutex // 同一会话的请求串行执行
+
 	DebugContext *debug.DebugContext
 	LR0Context   *lr.LR0Context
+	Snapshot     *VariablesSnapshot
+	Symbols      *SymbolTable
 }
 
-var lr0Process map[string]*LR0Process = make(map[string]*LR0Process)
+var lr0Process = newSessionMap()
+
+// 取得会话并加锁，调用方须在处理完成后解锁
+func lockLR0Process(id string) (*LR0Process, bool) {
+	session, exist := lr0Process.Get(id)
+	if !exist {
+		return nil, false
+	}
+	proc := session.(*LR0Process)
+	proc.lock.Lock()
+	return proc, true
+}
 
 func init() {
 	RegisteService("lr0_process_request", LR0ProcessRequest)
 	RegisteService("lr0_process_switchmode", LR0ProcessSwitchMode)
 	RegisteService("lr0_process_release", LR0ProcessRelease)
 	RegisteService("lr0_process_setbreakpoints", LR0ProcessSetBreakpoints)
-	RegisteService("lr0_process_variables", LR0ProcessGetVariables)
+	RegisteContextService("lr0_process_variables", LR0ProcessGetVariables)
 	RegisteService("lr0_process_exit", LR0ProcessGetExitResult)
 }
 
@@ -35,6 +52,8 @@ func LR0ProcessRequest(req json.RawMessage) (code int, resp interface{}, err err
 		return
 	}
 	process := &LR0Process{}
+	process.Snapshot = NewVariablesSnapshot()
+	process.Symbols = NewSymbolTable()
 	process.LR0Context = lr.NewLR0Context()
 	process.LR0Context.Code = reqStruct.Code
 	process.LR0Context.SLR = reqStruct.SLR
@@ -44,9 +63,9 @@ func LR0ProcessRequest(req json.RawMessage) (code int, resp interface{}, err err
 		process.LR0Context.Normalize()
 	}
 	entry := process.LR0Context.CreateLR0ProcessEntry()
-	process.DebugContext = debug.StartDebugGoroutine(entry)
 	id := uuid.New()
-	lr0Process[id] = process
+	process.DebugContext = debug.StartDebugGoroutineWithListener(entry, processListener(id))
+	lr0Process.Put(id, process)
 	var respStruct struct {
 		ID string `json:"id"`
 	}
@@ -64,11 +83,12 @@ func LR0ProcessSwitchMode(req json.RawMessage) (code int, resp interface{}, err
 	if err != nil {
 		return
 	}
-	proc, exist := lr0Process[reqStruct.ID]
+	proc, exist := lockLR0Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.SwitchRunMode(debug.RunMode(reqStruct.Mode))
 	return
 }
@@ -81,13 +101,14 @@ func LR0ProcessRelease(req json.RawMessage) (code int, resp interface{}, err err
 	if err != nil {
 		return
 	}
-	proc, exist := lr0Process[reqStruct.ID]
+	proc, exist := lockLR0Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.SwitchRunMode(debug.RunMode_Exit)
-	delete(lr0Process, reqStruct.ID)
+	lr0Process.Delete(reqStruct.ID)
 	return
 }
 
@@ -103,11 +124,12 @@ func LR0ProcessSetBreakpoints(req json.RawMessage) (code int, resp interface{},
 	if err != nil {
 		return
 	}
-	proc, exist := lr0Process[reqStruct.ID]
+	proc, exist := lockLR0Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.ClearBreakPoints()
 	for _, bp := range reqStruct.Breakpoints {
 		proc.DebugContext.AddBreakPoint(&debug.Point{
@@ -118,48 +140,114 @@ func LR0ProcessSetBreakpoints(req json.RawMessage) (code int, resp interface{},
 	return
 }
 
-func LR0ProcessGetVariables(req json.RawMessage) (code int, resp interface{}, err error) {
+func LR0ProcessGetVariables(ctx context.Context, req json.RawMessage) (code int, resp interface{}, err error) {
 	var reqStruct struct {
-		ID string `json:"id"`
+		ID    string `json:"id"`
+		Delta bool   `json:"delta"` // 只发送相对 base 快照变化的部分
+		Base  int    `json:"base"`
+		// 客户端已持有的符号数，非空时符号以编号发送
+		Symbols *int `json:"symbols"`
+		// 客户端已持有的埋点版本，未产生更新的版本时只回复 unchanged
+		IfNewerThan int `json:"if_newer_than"`
 	}
 	err = json.Unmarshal(req, &reqStruct)
 	if err != nil {
 		return
 	}
-	proc, exist := lr0Process[reqStruct.ID]
+	proc, exist := lockLR0Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
-	variables, point := proc.DebugContext.GetVariables()
+	defer proc.lock.Unlock()
+	variables, point, version := proc.DebugContext.GetVersionedVariables()
 	if variables == nil {
 		code = 1003
 		return
 	}
-	resp = map[string]interface{}{
-		"var":   variables,
-		"point": point,
+	if reqStruct.IfNewerThan != 0 && reqStruct.IfNewerThan == version {
+		resp = map[string]interface{}{
+			"unchanged": true,
+			"version":   version,
+		}
+		return
+	}
+	// 序列化与快照比较是最耗时的部分，客户端已放弃时不再进行
+	if ctx.Err() != nil {
+		code = CodeCancelled
+		return
+	}
+	interned := reqStruct.Symbols != nil
+	prepared, err := proc.Snapshot.Prepare(version, interned, func() (interface{}, error) {
+		if interned {
+			return proc.Symbols.InternLRVariables(variables)
+		}
+		return variables, nil
+	})
+	if err != nil {
+		return
 	}
+	var result map[string]interface{}
+	if !reqStruct.Delta {
+		// 完整读取时复用该版本变量已编码的字节
+		encoded, err := proc.Snapshot.EncodePrepared()
+		if err != nil {
+			return 0, nil, err
+		}
+		result = map[string]interface{}{
+			"var":     encoded,
+			"point":   point,
+			"version": version,
+		}
+	} else {
+		delta, base, seq, err := proc.Snapshot.Delta(prepared, version, reqStruct.Base)
+		if err != nil {
+			return 0, nil, err
+		}
+		result = map[string]interface{}{
+			"var":     delta,
+			"point":   point,
+			"base":    base,
+			"seq":     seq,
+			"version": version,
+		}
+	}
+	if reqStruct.Symbols != nil {
+		result["symbols"] = proc.Symbols.Since(*reqStruct.Symbols)
+	}
+	// 变量引用会话的当前状态，须在持有锁时编码
+	resp, err = Encode(result)
 	return
 }
 
 func LR0ProcessGetExitResult(req json.RawMessage) (code int, resp interface{}, err error) {
 	var reqStruct struct {
-		ID string `json:"id"`
+		ID      string `json:"id"`
+		Symbols *int   `json:"symbols"`
 	}
 	err = json.Unmarshal(req, &reqStruct)
 	if err != nil {
 		return
 	}
-	proc, exist := lr0Process[reqStruct.ID]
+	proc, exist := lockLR0Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	if proc.DebugContext.GetCurrentRunMode() != debug.RunMode_Exit {
 		code = 1004
 		return
 	}
-	resp = proc.DebugContext.ExitResult
+	if reqStruct.Symbols == nil {
+		resp = proc.DebugContext.ExitResult
+		return
+	}
+	result, err := proc.Symbols.InternLRExitResult(proc.DebugContext.ExitResult)
+	if err != nil {
+		return
+	}
+	result["symbols"] = proc.Symbols.Since(*reqStruct.Symbols)
+	resp = result
 	return
 }
@@ -1,7 +1,9 @@
 package service
 
 import (
+	"context"
 	"encoding/json"
+	"sync"
 
 	"github.com/chushi0/graduation_project/golang/startup/debug"
 	lr "github.com/chushi0/graduation_project/golang/startup/production/process"
@@ -9,18 +11,33 @@ import (
 )
 
 type LR1Process struct {
+	lock sync.Mutex // 同一会话的请求串行执行
+
 	DebugContext *debug.DebugContext
 	LR1Context   *lr.LR1Context
+	Snapshot     *VariablesSnapshot
+	Symbols      *SymbolTable
 }
 
-var lr1Process map[string]*LR1Process = make(map[string]*LR1Process)
+var lr1Process = newSessionMap()
+
+// 取得会话并加锁，调用方须在处理完成后解锁
+func lockLR1Process(id string) (*LR1Process, bool) {
+	session, exist := lr1Process.Get(id)
+	if !exist {
+		return nil, false
+	}
+	proc := session.(*LR1Process)
+	proc.lock.Lock()
+	return proc, true
+}
 
 func init() {
 	RegisteService("lr1_process_request", LR1ProcessRequest)
 	RegisteService("lr1_process_switchmode", LR1ProcessSwitchMode)
 	RegisteService("lr1_process_release", LR1ProcessRelease)
 	RegisteService("lr1_process_setbreakpoints", LR1ProcessSetBreakpoints)
-	RegisteService("lr1_process_variables", LR1ProcessGetVariables)
+	RegisteContextService("lr1_process_variables", LR1ProcessGetVariables)
 	RegisteService("lr1_process_exit", LR1ProcessGetExitResult)
 }
 
@@ -35,6 +52,8 @@ func LR1ProcessRequest(req json.RawMessage) (code int, resp interface{}, err err
 		return
 	}
 	process := &LR1Process{}
+	process.Snapshot = NewVariablesSnapshot()
+	process.Symbols = NewSymbolTable()
 	process.LR1Context = lr.NewLR1Context()
 	process.LR1Context.Code = reqStruct.Code
 	process.LR1Context.LALR = reqStruct.LALR
@@ -44,9 +63,9 @@ func LR1ProcessRequest(req json.RawMessage) (code int, resp interface{}, err err
 		process.LR1Context.Normalize()
 	}
 	entry := process.LR1Context.CreateLR1ProcessEntry()
-	process.DebugContext = debug.StartDebugGoroutine(entry)
 	id := uuid.New()
-	lr1Process[id] = process
+	process.DebugContext = debug.StartDebugGoroutineWithListener(entry, processListener(id))
+	lr1Process.Put(id, process)
 	var respStruct struct {
 		ID string `json:"id"`
 	}
@@ -64,11 +83,12 @@ func LR1ProcessSwitchMode(req json.RawMessage) (code int, resp interface{}, err
 	if err != nil {
 		return
 	}
-	proc, exist := lr1Process[reqStruct.ID]
+	proc, exist := lockLR1Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.SwitchRunMode(debug.RunMode(reqStruct.Mode))
 	return
 }
@@ -81,13 +101,14 @@ func LR1ProcessRelease(req json.RawMessage) (code int, resp interface{}, err err
 	if err != nil {
 		return
 	}
-	proc, exist := lr1Process[reqStruct.ID]
+	proc, exist := lockLR1Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.SwitchRunMode(debug.RunMode_Exit)
-	delete(lr1Process, reqStruct.ID)
+	lr1Process.Delete(reqStruct.ID)
 	return
 }
 
@@ -103,11 +124,12 @@ func LR1ProcessSetBreakpoints(req json.RawMessage) (code int, resp interface{},
 	if err != nil {
 		return
 	}
-	proc, exist := lr1Process[reqStruct.ID]
+	proc, exist := lockLR1Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	proc.DebugContext.ClearBreakPoints()
 	for _, bp := range reqStruct.Breakpoints {
 		proc.DebugContext.AddBreakPoint(&debug.Point{
@@ -118,48 +140,114 @@ func LR1ProcessSetBreakpoints(req json.RawMessage) (code int, resp interface{},
 	return
 }
 
-func LR1ProcessGetVariables(req json.RawMessage) (code int, resp interface{}, err error) {
+func LR1ProcessGetVariables(ctx context.Context, req json.RawMessage) (code int, resp interface{}, err error) {
 	var reqStruct struct {
-		ID string `json:"id"`
+		ID    string `json:"id"`
+		Delta bool   `json:"delta"` // 只发送相对 base 快照变化的部分
+		Base  int    `json:"base"`
+		// 客户端已持有的符号数，非空时符号以编号发送
+		Symbols *int `json:"symbols"`
+		// 客户端已持有的埋点版本，未产生更新的版本时只回复 unchanged
+		IfNewerThan int `json:"if_newer_than"`
 	}
 	err = json.Unmarshal(req, &reqStruct)
 	if err != nil {
 		return
 	}
-	proc, exist := lr1Process[reqStruct.ID]
+	proc, exist := lockLR1Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
-	variables, point := proc.DebugContext.GetVariables()
+	defer proc.lock.Unlock()
+	variables, point, version := proc.DebugContext.GetVersionedVariables()
 	if variables == nil {
 		code = 1003
 		return
 	}
-	resp = map[string]interface{}{
-		"var":   variables,
-		"point": point,
+	if reqStruct.IfNewerThan != 0 && reqStruct.IfNewerThan == version {
+		resp = map[string]interface{}{
+			"unchanged": true,
+			"version":   version,
+		}
+		return
+	}
+	// 序列化与快照比较是最耗时的部分，客户端已放弃时不再进行
+	if ctx.Err() != nil {
+		code = CodeCancelled
+		return
+	}
+	interned := reqStruct.Symbols != nil
+	prepared, err := proc.Snapshot.Prepare(version, interned, func() (interface{}, error) {
+		if interned {
+			return proc.Symbols.InternLRVariables(variables)
+		}
+		return variables, nil
+	})
+	if err != nil {
+		return
 	}
+	var result map[string]interface{}
+	if !reqStruct.Delta {
+		// 完整读取时复用该版本变量已编码的字节
+		encoded, err := proc.Snapshot.EncodePrepared()
+		if err != nil {
+			return 0, nil, err
+		}
+		result = map[string]interface{}{
+			"var":     encoded,
+			"point":   point,
+			"version": version,
+		}
+	} else {
+		delta, base, seq, err := proc.Snapshot.Delta(prepared, version, reqStruct.Base)
+		if err != nil {
+			return 0, nil, err
+		}
+		result = map[string]interface{}{
+			"var":     delta,
+			"point":   point,
+			"base":    base,
+			"seq":     seq,
+			"version": version,
+		}
+	}
+	if reqStruct.Symbols != nil {
+		result["symbols"] = proc.Symbols.Since(*reqStruct.Symbols)
+	}
+	// 变量引用会话的当前状态，须在持有锁时编码
+	resp, err = Encode(result)
 	return
 }
 
 func LR1ProcessGetExitResult(req json.RawMessage) (code int, resp interface{}, err error) {
 	var reqStruct struct {
-		ID string `json:"id"`
+		ID      string `json:"id"`
+		Symbols *int   `json:"symbols"`
 	}
 	err = json.Unmarshal(req, &reqStruct)
 	if err != nil {
 		return
 	}
-	proc, exist := lr1Process[reqStruct.ID]
+	proc, exist := lockLR1Process(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
+	defer proc.lock.Unlock()
 	if proc.DebugContext.GetCurrentRunMode() != debug.RunMode_Exit {
 		code = 1004
 		return
 	}
-	resp = proc.DebugContext.ExitResult
+	if reqStruct.Symbols == nil {
+		resp = proc.DebugContext.ExitResult
+		return
+	}
+	result, err := proc.Symbols.InternLRExitResult(proc.DebugContext.ExitResult)
+	if err != nil {
+		return
+	}
+	result["symbols"] = proc.Symbols.Since(*reqStruct.Symbols)
+	resp = result
 	return
 }
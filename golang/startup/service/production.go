@@ -3,15 +3,37 @@ package service
 import (
 	"encoding/json"
 	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
 
 	"github.com/chushi0/graduation_project/golang/startup/production"
 	"github.com/go-basic/uuid"
 )
 
 type ProductionProcess struct {
-	Exit      bool
-	Result    ProductionResult
-	Interrupt bool
+	Result  ProductionResult
+	Created time.Time
+
+	interrupt int32 // 由其他 goroutine 设置，原子地读写
+	lock      sync.Mutex
+	exit      bool
+}
+
+// 中断解析，可以在任意 goroutine 调用
+func (process *ProductionProcess) Interrupt() {
+	atomic.StoreInt32(&process.interrupt, 1)
+}
+
+func (process *ProductionProcess) Interrupted() bool {
+	return atomic.LoadInt32(&process.interrupt) != 0
+}
+
+// 解析是否结束；返回 true 后 Result 不再改变，可以在其他 goroutine 读取
+func (process *ProductionProcess) Exited() bool {
+	process.lock.Lock()
+	defer process.lock.Unlock()
+	return process.exit
 }
 
 type ProductionResult struct {
@@ -19,28 +41,74 @@ type ProductionResult struct {
 	Nonterminals []string                   `json:"nonterminal"`
 	Productions  []production.Production    `json:"productions"`
 	Errors       *production.ErrorContainer `json:"errors"`
+	Revision     int                        `json:"revision"` // 文档的解析结果对应的文本版本
 }
 
-var productionParse map[string]*ProductionProcess = make(map[string]*ProductionProcess)
+// 未指定文档的解析结果超过该时间未查询时丢弃
+const productionResultTTL = time.Minute
+
+var productionParse = newSessionMap()
 
 func init() {
 	RegisteService("production_parse_start", ProductionParseRequest)
 	RegisteService("production_parse_query", ProductionParseQuery)
 	RegisteService("production_parse_cancel", ProductionParseCancel)
+	RegisteService("production_document_close", ProductionDocumentClose)
 }
 
+// 解析产生式
+// document 非空时保存文本：length 为空时以 code 为全文，否则在保存的文本上应用 edits，
+// 应用后的字节数须等于 length；文档不存在返回 1001，与客户端不一致返回 1005，客户端应重新发送全文
+// 文档的解析由其调度器排队，返回的 id 即文档编号，revision 为本次提交的文本版本
 func ProductionParseRequest(req json.RawMessage) (code int, resp interface{}, err error) {
 	var reqStruct struct {
-		Code string `json:"code"`
+		Code     string     `json:"code"`
+		Document string     `json:"document"`
+		Edits    []TextEdit `json:"edits"`
+		Length   *int       `json:"length"`
 	}
 	err = json.Unmarshal(req, &reqStruct)
 	if err != nil {
 		return
 	}
-	process := &ProductionProcess{}
-	go ProcessProductionParse(reqStruct.Code, process)
+	evictProductionResults()
+	if reqStruct.Document != "" {
+		doc, exist := getProductionDocument(reqStruct.Document)
+		var revision int
+		if reqStruct.Length == nil {
+			if !exist {
+				doc = NewProductionDocument(reqStruct.Document)
+				productionDocuments.Put(reqStruct.Document, doc)
+			}
+			revision = doc.Replace(reqStruct.Code)
+		} else {
+			if !exist {
+				code = 1001
+				return
+			}
+			var ok bool
+			revision, ok = doc.Edit(reqStruct.Edits, *reqStruct.Length)
+			if !ok {
+				doc.Cancel()
+				productionDocuments.Delete(reqStruct.Document)
+				code = 1005
+				return
+			}
+		}
+		resp = map[string]interface{}{
+			"id":       reqStruct.Document,
+			"revision": revision,
+		}
+		return
+	}
+	process := &ProductionProcess{Created: time.Now()}
 	id := uuid.New()
-	productionParse[id] = process
+	// 先登记会话，使事件推送后的查询能找到结果
+	productionParse.Put(id, process)
+	go func() {
+		ProcessProductionParse(reqStruct.Code, nil, process)
+		PostEvent(Event_ProductionParseFinished, id)
+	}()
 	var respStruct struct {
 		ID string `json:"id"`
 	}
@@ -49,6 +117,23 @@ func ProductionParseRequest(req json.RawMessage) (code int, resp interface{}, er
 	return
 }
 
+// 丢弃长时间未查询的解析结果与长时间未使用的文档
+func evictProductionResults() {
+	now := time.Now()
+	productionParse.DeleteIf(func(id string, session interface{}) bool {
+		proc := session.(*ProductionProcess)
+		return proc.Exited() && now.Sub(proc.Created) > productionResultTTL
+	})
+	productionDocuments.DeleteIf(func(id string, session interface{}) bool {
+		doc := session.(*ProductionDocument)
+		if !doc.Idle(now) {
+			return false
+		}
+		doc.Cancel()
+		return true
+	})
+}
+
 func ProductionParseQuery(req json.RawMessage) (code int, resp interface{}, err error) {
 	var reqStruct struct {
 		ID string `json:"id"`
@@ -57,17 +142,27 @@ func ProductionParseQuery(req json.RawMessage) (code int, resp interface{}, err
 	if err != nil {
 		return
 	}
-	proc, exist := productionParse[reqStruct.ID]
+	if doc, exist := getProductionDocument(reqStruct.ID); exist {
+		result := doc.Result()
+		if result == nil {
+			code = 1002
+			return
+		}
+		resp = result
+		return
+	}
+	session, exist := productionParse.Get(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
-	if !proc.Exit {
+	proc := session.(*ProductionProcess)
+	if !proc.Exited() {
 		code = 1002
 		return
 	}
 	resp = proc.Result
-	delete(productionParse, reqStruct.ID)
+	productionParse.Delete(reqStruct.ID)
 	return
 }
 
@@ -79,26 +174,56 @@ func ProductionParseCancel(req json.RawMessage) (code int, resp interface{}, err
 	if err != nil {
 		return
 	}
-	proc, exist := productionParse[reqStruct.ID]
+	if doc, exist := getProductionDocument(reqStruct.ID); exist {
+		doc.Cancel()
+		return
+	}
+	session, exist := productionParse.Get(reqStruct.ID)
 	if !exist {
 		code = 1001
 		return
 	}
-	proc.Interrupt = true
-	delete(productionParse, reqStruct.ID)
+	session.(*ProductionProcess).Interrupt()
+	productionParse.Delete(reqStruct.ID)
 	return
 }
 
-func ProcessProductionParse(code string, process *ProductionProcess) {
-	defer func() { process.Exit = true }()
-	productions, _, errors := production.ParseProduction(code, &process.Interrupt)
-	if process.Interrupt {
+func ProductionDocumentClose(req json.RawMessage) (code int, resp interface{}, err error) {
+	var reqStruct struct {
+		Document string `json:"document"`
+	}
+	err = json.Unmarshal(req, &reqStruct)
+	if err != nil {
+		return
+	}
+	if doc, exist := getProductionDocument(reqStruct.Document); exist {
+		doc.Cancel()
+		productionDocuments.Delete(reqStruct.Document)
+	}
+	return
+}
+
+// lines 非空时复用其中各行的词法分析结果
+func ProcessProductionParse(code string, lines *production.LineCache, process *ProductionProcess) {
+	defer func() {
+		process.lock.Lock()
+		process.exit = true
+		process.lock.Unlock()
+	}()
+	var productions []production.Production
+	var errors *production.ErrorContainer
+	if lines != nil {
+		productions, _, errors = production.ParseProductionCached(code, lines, &process.interrupt)
+	} else {
+		productions, _, errors = production.ParseProduction(code, &process.interrupt)
+	}
+	if process.Interrupted() {
 		return
 	}
 	process.Result.Productions = productions
 	process.Result.Errors = errors
 	terminals, nonterminals := production.GetTerminalsAndNonterminals(productions)
-	if process.Interrupt {
+	if process.Interrupted() {
 		return
 	}
 	process.Result.Nonterminals = make([]string, 0, len(nonterminals))
@@ -109,7 +234,7 @@ func ProcessProductionParse(code string, process *ProductionProcess) {
 	for s := range terminals {
 		process.Result.Terminals = append(process.Result.Terminals, s)
 	}
-	if process.Interrupt {
+	if process.Interrupted() {
 		return
 	}
 	sort.Strings(process.Result.Nonterminals)
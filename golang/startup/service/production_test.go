@@ -0,0 +1,127 @@
+package service_test
+
+import (
+	"encoding/json"
+	"reflect"
+	"testing"
+	"time"
+
+	"github.com/chushi0/graduation_project/golang/startup/service"
+)
+
+func callProduction(t *testing.T, action string, data interface{}) (int, json.RawMessage) {
+	raw, _ := json.Marshal(map[string]interface{}{"action": action, "data": data})
+	resp, err := service.CallService(raw)
+	if err != nil {
+		t.Fatal(err)
+	}
+	var res struct {
+		Code int             `json:"code"`
+		Data json.RawMessage `json:"data"`
+	}
+	json.Unmarshal(resp, &res)
+	return res.Code, res.Data
+}
+
+// 启动解析并等待结果
+func parseProduction(t *testing.T, data interface{}) (int, *service.ProductionResult) {
+	code, raw := callProduction(t, "production_parse_start", data)
+	if code != 0 {
+		return code, nil
+	}
+	var started struct {
+		ID string `json:"id"`
+	}
+	json.Unmarshal(raw, &started)
+	for i := 0; i < 1000; i++ {
+		code, raw = callProduction(t, "production_parse_query", map[string]string{"id": started.ID})
+		if code != 1002 {
+			break
+		}
+		time.Sleep(time.Millisecond)
+	}
+	result := &service.ProductionResult{}
+	json.Unmarshal(raw, result)
+	return code, result
+}
+
+func TestProductionDocumentEdits(t *testing.T) {
+	text := "@S\nS := A b\nA := a\n"
+	code, _ := parseProduction(t, map[string]interface{}{"code": text, "document": "doc"})
+	if code != 0 {
+		t.Fatalf("full text parse failed: %d", code)
+	}
+
+	// 在 "A := a" 之后追加 " c"，并新增一行
+	edits := []service.TextEdit{
+		{Position: len(text) - 1, Deleted: 0, Inserted: " c"},
+		{Position: len(text) + 2, Deleted: 0, Inserted: "| d\n"},
+	}
+	text = "@S\nS := A b\nA := a c\n| d\n"
+	code, result := parseProduction(t, map[string]interface{}{"document": "doc", "edits": edits, "length": len(text)})
+	_, expect := parseProduction(t, map[string]interface{}{"code": text})
+	expect.Revision = 2
+	if code != 0 || !reflect.DeepEqual(result, expect) {
+		t.Fatalf("edited parse mismatch: %d %+v %+v", code, result, expect)
+	}
+
+	// 长度不符时丢弃文档
+	code, _ = parseProduction(t, map[string]interface{}{"document": "doc", "edits": []service.TextEdit{}, "length": 1})
+	if code != 1005 {
+		t.Fatalf("expect out of sync, got %d", code)
+	}
+	code, _ = parseProduction(t, map[string]interface{}{"document": "doc", "edits": []service.TextEdit{}, "length": len(text)})
+	if code != 1001 {
+		t.Fatalf("expect unknown document, got %d", code)
+	}
+}
+
+func TestProductionDocumentLatestWins(t *testing.T) {
+	text := "@S\nS := a\n"
+	code, _ := callProduction(t, "production_parse_start", map[string]interface{}{"code": text, "document": "latest"})
+	if code != 0 {
+		t.Fatalf("full text parse failed: %d", code)
+	}
+	// 连续输入，只有最后的文本会得到结果
+	var revision int
+	for i := 0; i < 20; i++ {
+		edits := []service.TextEdit{{Position: len(text), Inserted: "| b\n"}}
+		text += "| b\n"
+		code, raw := callProduction(t, "production_parse_start", map[string]interface{}{"document": "latest", "edits": edits, "length": len(text)})
+		if code != 0 {
+			t.Fatalf("edit %d failed: %d", i, code)
+		}
+		var started struct {
+			ID       string `json:"id"`
+			Revision int    `json:"revision"`
+		}
+		json.Unmarshal(raw, &started)
+		if started.ID != "latest" || started.Revision <= revision {
+			t.Fatalf("unexpected start response: %s", raw)
+		}
+		revision = started.Revision
+	}
+	var raw json.RawMessage
+	for i := 0; i < 1000; i++ {
+		code, raw = callProduction(t, "production_parse_query", map[string]string{"id": "latest"})
+		if code != 1002 {
+			break
+		}
+		time.Sleep(time.Millisecond)
+	}
+	result := &service.ProductionResult{}
+	json.Unmarshal(raw, result)
+	_, expect := parseProduction(t, map[string]interface{}{"code": text})
+	expect.Revision = revision
+	if code != 0 || !reflect.DeepEqual(result, expect) {
+		t.Fatalf("latest parse mismatch: %d %+v %+v", code, result, expect)
+	}
+
+	// 取消后不再产生结果
+	callProduction(t, "production_parse_cancel", map[string]string{"id": "latest"})
+	callProduction(t, "production_document_close", map[string]string{"document": "latest"})
+	code, _ = callProduction(t, "production_parse_query", map[string]string{"id": "latest"})
+	if code != 1001 {
+		t.Fatalf("expect closed document, got %d", code)
+	}
+}
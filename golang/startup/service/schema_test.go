@@ -0,0 +1,98 @@
+package service_test
+
+import (
+	"io/ioutil"
+	"reflect"
+	"regexp"
+	"strings"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/debug"
+	"github.com/chushi0/graduation_project/golang/startup/production"
+	"github.com/chushi0/graduation_project/golang/startup/production/process"
+	"github.com/chushi0/graduation_project/golang/startup/service"
+)
+
+// 客户端的 IPC 模式，键名须与服务端结构体的 json 标签一致
+const schemaPath = "../../../cpp/main/src/ipc/schema.h"
+
+// 模式中的结构体对应的服务端结构体，以及服务层另外附加的键
+var schemaTypes = map[string]struct {
+	value interface{}
+	extra []string
+}{
+	"ErrorType":              {production.Error{}, nil},
+	"TextEdit":               {service.TextEdit{}, nil},
+	"Breakpoint":             {debug.Point{}, nil},
+	"ReplaceProduction":      {process.ReplaceProduction{}, nil},
+	"LLBreakpointVariables":  {process.LLKeyVariables{}, nil},
+	"LLExitResult":           {process.LLResult{}, nil},
+	"LRItem":                 {process.LR1Item{}, nil},
+	"LRItemClosureMapEdge":   {process.LR1ItemClosureMapEdge{}, nil},
+	"LRItemClosureMap":       {process.LR1ItemClosureMap{}, nil},
+	"LR0BreakpointVariables": {process.LR0Variables{}, nil},
+	"LR0ExitResult":          {process.LR0Result{}, []string{"symbols"}},
+	"LR1BreakpointVariables": {process.LR1Variables{}, nil},
+	"LR1ExitResult":          {process.LR1Result{}, []string{"symbols"}},
+}
+
+var (
+	schemaBlock  = regexp.MustCompile(`(?m)^\s*IPC_SCHEMA\((\w+),`)
+	schemaField  = regexp.MustCompile(`field\("(\w+)"`)
+	schemaMacro  = regexp.MustCompile(`(?s)#define IPC_LR_FIELDS\(type\)(.*?)\n\n`)
+	schemaShared = "IPC_LR_FIELDS("
+)
+
+func TestSchemaMatchesJSONTags(t *testing.T) {
+	raw, err := ioutil.ReadFile(schemaPath)
+	if err != nil {
+		t.Skipf("schema not available: %v", err)
+	}
+	source := string(raw)
+	shared := schemaMacro.FindStringSubmatch(source)
+	if shared == nil {
+		t.Fatal("IPC_LR_FIELDS not found")
+	}
+	source = strings.Replace(source, shared[0], "", 1)
+
+	blocks := schemaBlock.FindAllStringSubmatchIndex(source, -1)
+	if len(blocks) != len(schemaTypes) {
+		t.Errorf("schema has %d types, expect %d", len(blocks), len(schemaTypes))
+	}
+	for i, block := range blocks {
+		name := source[block[2]:block[3]]
+		end := len(source)
+		if i+1 < len(blocks) {
+			end = blocks[i+1][0]
+		}
+		body := source[block[1]:end]
+		if strings.Contains(body, schemaShared) {
+			body += shared[1]
+		}
+		goType, ok := schemaTypes[name]
+		if !ok {
+			t.Errorf("schema type %s has no server struct", name)
+			continue
+		}
+		tags := jsonTags(reflect.TypeOf(goType.value))
+		for _, key := range goType.extra {
+			tags[key] = true
+		}
+		for _, match := range schemaField.FindAllStringSubmatch(body, -1) {
+			if !tags[match[1]] {
+				t.Errorf("%s.%s not found in %T", name, match[1], goType.value)
+			}
+		}
+	}
+}
+
+func jsonTags(typ reflect.Type) map[string]bool {
+	tags := make(map[string]bool)
+	for i := 0; i < typ.NumField(); i++ {
+		tag := strings.Split(typ.Field(i).Tag.Get("json"), ",")[0]
+		if tag != "" && tag != "-" {
+			tags[tag] = true
+		}
+	}
+	return tags
+}
@@ -0,0 +1,44 @@
+package service
+
+import "sync"
+
+// 会话表：按 id 保存某一服务的会话
+// 请求并发处理，会话表由读写锁保护；同一会话的请求由会话自身的锁串行执行
+type sessionMap struct {
+	lock     sync.RWMutex
+	sessions map[string]interface{}
+}
+
+func newSessionMap() *sessionMap {
+	return &sessionMap{sessions: make(map[string]interface{})}
+}
+
+func (m *sessionMap) Get(id string) (interface{}, bool) {
+	m.lock.RLock()
+	defer m.lock.RUnlock()
+	session, exist := m.sessions[id]
+	return session, exist
+}
+
+func (m *sessionMap) Put(id string, session interface{}) {
+	m.lock.Lock()
+	defer m.lock.Unlock()
+	m.sessions[id] = session
+}
+
+func (m *sessionMap) Delete(id string) {
+	m.lock.Lock()
+	defer m.lock.Unlock()
+	delete(m.sessions, id)
+}
+
+// 删除 remove 返回 true 的会话，remove 在持有写锁时调用
+func (m *sessionMap) DeleteIf(remove func(id string, session interface{}) bool) {
+	m.lock.Lock()
+	defer m.lock.Unlock()
+	for id, session := range m.sessions {
+		if remove(id, session) {
+			delete(m.sessions, id)
+		}
+	}
+}
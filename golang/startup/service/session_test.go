@@ -0,0 +1,48 @@
+package service_test
+
+import (
+	"encoding/json"
+	"sync"
+	"testing"
+	"time"
+)
+
+// 多个会话的请求并发处理
+func TestConcurrentSessions(t *testing.T) {
+	code := "@S\nS := L = R\nS := R\nL := * R\nL := id\nR := L\n"
+	var wg sync.WaitGroup
+	for i := 0; i < 8; i++ {
+		wg.Add(1)
+		go func(lalr bool) {
+			defer wg.Done()
+			status, raw := callProduction(t, "lr1_process_request", map[string]interface{}{"code": code, "lalr": lalr})
+			var started struct {
+				ID string `json:"id"`
+			}
+			json.Unmarshal(raw, &started)
+			if status != 0 || started.ID == "" {
+				t.Errorf("start failed: %d %s", status, raw)
+				return
+			}
+			callProduction(t, "lr1_process_switchmode", map[string]interface{}{"id": started.ID, "mode": 1})
+			for j := 0; j < 1000; j++ {
+				status, raw = callProduction(t, "lr1_process_exit", map[string]interface{}{"id": started.ID, "symbols": 0})
+				if status != 1004 {
+					break
+				}
+				time.Sleep(time.Millisecond)
+			}
+			var result struct {
+				Code int `json:"code"`
+			}
+			json.Unmarshal(raw, &result)
+			if status != 0 || result.Code != 0 {
+				t.Errorf("exit failed: %d %s", status, raw)
+			}
+			if status, _ = callProduction(t, "lr1_process_release", map[string]string{"id": started.ID}); status != 0 {
+				t.Errorf("release failed: %d", status)
+			}
+		}(i%2 == 0)
+	}
+	wg.Wait()
+}
@@ -0,0 +1,354 @@
+package service
+
+import (
+	"math"
+	"reflect"
+	"strings"
+)
+
+// 断点变量快照，用于增量发送
+// 客户端请求时带上已持有的快照序号，服务端只发送相对该快照变化的字段；
+// 列表字段只发送新长度与变化的元素
+// 快照只保存各字段与列表元素的摘要：变量在会话继续运行后原地修改，不能保留引用比较
+// Version 为快照对应的埋点版本，版本不变时变量不变，无需再次比较
+type VariablesSnapshot struct {
+	Seq      int
+	Version  int
+	Fields   map[string]uint64
+	Lists    map[string][]uint64
+	Prepared *PreparedVariables
+}
+
+// 最近一次准备的变量，同一埋点版本的重复请求直接复用
+// Encoded 为变量按负载编码序列化的结果，完整读取未变化的版本时直接发送
+type PreparedVariables struct {
+	Version   int
+	Interned  bool // 是否已将符号替换为编号
+	Variables interface{}
+	Encoded   *Encoded
+}
+
+// 列表的增量：截断或扩展到 Length 后，用 Items 替换 Index 处的元素
+type ListPatch struct {
+	Length int           `json:"length"`
+	Index  []int         `json:"index"`
+	Items  []interface{} `json:"items"`
+}
+
+// 按元素增量发送的列表字段
+// 值非空时字段为对象，其中列出的子字段为列表，其余子字段整体发送
+var deltaListFields = map[string][]string{
+	"action_table": nil,
+	"goto_table":   nil,
+	"closure_map":  {"closures", "edges"},
+}
+
+func NewVariablesSnapshot() *VariablesSnapshot {
+	return &VariablesSnapshot{}
+}
+
+// 准备埋点版本 version 的变量，同一版本只准备一次
+// prepare 仅在需要时调用，返回待发送的变量
+func (snapshot *VariablesSnapshot) Prepare(version int, interned bool, prepare func() (interface{}, error)) (interface{}, error) {
+	if cached := snapshot.Prepared; cached != nil && cached.Version == version && cached.Interned == interned {
+		return cached.Variables, nil
+	}
+	variables, err := prepare()
+	if err != nil {
+		return nil, err
+	}
+	snapshot.Prepared = &PreparedVariables{
+		Version:   version,
+		Interned:  interned,
+		Variables: variables,
+	}
+	return variables, nil
+}
+
+// 编码最近一次准备的变量，同一版本在同一负载编码下只编码一次
+// 须在 Prepare 之后、持有会话锁时调用
+func (snapshot *VariablesSnapshot) EncodePrepared() (Encoded, error) {
+	prepared := snapshot.Prepared
+	if prepared.Encoded != nil && prepared.Encoded.CBOR == cborEncoding {
+		return *prepared.Encoded, nil
+	}
+	encoded, err := Encode(prepared.Variables)
+	if err != nil {
+		return Encoded{}, err
+	}
+	prepared.Encoded = &encoded
+	return encoded, nil
+}
+
+// 生成相对 base 快照的增量，并将埋点版本 version 的变量记为新快照
+// variables 为结构体（字段按 json 标签命名）或键为字符串的映射
+// base 为 0 或与服务端快照不符时发送完整快照，此时返回的 base 为 0
+// 版本与当前快照相同时不再比较，快照序号不变
+// 增量中的值引用 variables，须在变量不变时（持有会话锁）序列化
+func (snapshot *VariablesSnapshot) Delta(variables interface{}, version int, base int) (delta map[string]interface{}, deltaBase int, seq int, err error) {
+	incremental := base != 0 && base == snapshot.Seq
+	fields := variableFields(reflect.ValueOf(variables))
+	if version != 0 && version == snapshot.Version && snapshot.Fields != nil {
+		delta = make(map[string]interface{})
+		if incremental {
+			return delta, base, snapshot.Seq, nil
+		}
+		for _, field := range fields {
+			delta[field.name] = field.value.Interface()
+		}
+		return delta, 0, snapshot.Seq, nil
+	}
+	hashes := make(map[string]uint64, len(fields))
+	lists := make(map[string][]uint64)
+	delta = make(map[string]interface{})
+	for _, field := range fields {
+		key, value := field.name, field.value
+		hash := hashValue(value)
+		hashes[key] = hash
+		subkeys, isList := deltaListFields[key]
+		if old, ok := snapshot.Fields[key]; incremental && ok && old == hash {
+			if isList {
+				snapshot.keepLists(key, subkeys, lists)
+			}
+			continue
+		}
+		if !isList {
+			delta[key] = value.Interface()
+			continue
+		}
+		if subkeys == nil {
+			if patch, changed := snapshot.diffList(key, value, incremental, lists); changed {
+				delta[key] = patch
+			}
+			continue
+		}
+		object := variableFields(value)
+		if object == nil {
+			delta[key] = value.Interface()
+			continue
+		}
+		patches := make(map[string]interface{})
+		for _, sub := range object {
+			if !containsString(subkeys, sub.name) {
+				patches[sub.name] = sub.value.Interface()
+				continue
+			}
+			if patch, changed := snapshot.diffList(key+"."+sub.name, sub.value, incremental, lists); changed {
+				patches[sub.name] = patch
+			}
+		}
+		delta[key] = patches
+	}
+
+	snapshot.Seq++
+	snapshot.Version = version
+	snapshot.Fields = hashes
+	snapshot.Lists = lists
+	if incremental {
+		deltaBase = base
+	}
+	return delta, deltaBase, snapshot.Seq, nil
+}
+
+// 字段未变化时沿用上次的元素摘要
+func (snapshot *VariablesSnapshot) keepLists(key string, subkeys []string, lists map[string][]uint64) {
+	if subkeys == nil {
+		if list, ok := snapshot.Lists[key]; ok {
+			lists[key] = list
+		}
+		return
+	}
+	for _, subkey := range subkeys {
+		if list, ok := snapshot.Lists[key+"."+subkey]; ok {
+			lists[key+"."+subkey] = list
+		}
+	}
+}
+
+// 比较列表元素，返回增量或完整列表；列表未变化时 changed 为 false
+// 变化的元素超过一半时直接发送完整列表
+func (snapshot *VariablesSnapshot) diffList(path string, value reflect.Value, incremental bool, lists map[string][]uint64) (patch interface{}, changed bool) {
+	list := indirect(value)
+	if list.Kind() != reflect.Slice || list.IsNil() {
+		return value.Interface(), true
+	}
+	items := make([]uint64, list.Len())
+	for i := range items {
+		items[i] = hashValue(list.Index(i))
+	}
+	lists[path] = items
+	old, ok := snapshot.Lists[path]
+	if !incremental || !ok {
+		return value.Interface(), true
+	}
+	res := ListPatch{
+		Length: len(items),
+		Index:  make([]int, 0),
+		Items:  make([]interface{}, 0),
+	}
+	for i, item := range items {
+		if i < len(old) && old[i] == item {
+			continue
+		}
+		res.Index = append(res.Index, i)
+		res.Items = append(res.Items, list.Index(i).Interface())
+	}
+	if len(res.Index) == 0 && len(items) == len(old) {
+		return nil, false
+	}
+	if len(res.Index)*2 > len(items) {
+		return value.Interface(), true
+	}
+	return res, true
+}
+
+func containsString(list []string, s string) bool {
+	for _, v := range list {
+		if v == s {
+			return true
+		}
+	}
+	return false
+}
+
+type variableField struct {
+	name  string
+	value reflect.Value
+}
+
+// 结构体按 json 标签列出导出的字段，键为字符串的映射列出各项；其他值及空指针返回 nil
+func variableFields(v reflect.Value) []variableField {
+	v = indirect(v)
+	switch v.Kind() {
+	case reflect.Struct:
+		t := v.Type()
+		fields := make([]variableField, 0, t.NumField())
+		for i := 0; i < t.NumField(); i++ {
+			f := t.Field(i)
+			name := strings.Split(f.Tag.Get("json"), ",")[0]
+			if f.PkgPath != "" || name == "-" {
+				continue
+			}
+			if name == "" {
+				name = f.Name
+			}
+			fields = append(fields, variableField{name, v.Field(i)})
+		}
+		return fields
+	case reflect.Map:
+		if v.IsNil() || v.Type().Key().Kind() != reflect.String {
+			return nil
+		}
+		fields := make([]variableField, 0, v.Len())
+		iter := v.MapRange()
+		for iter.Next() {
+			fields = append(fields, variableField{iter.Key().String(), iter.Value()})
+		}
+		return fields
+	}
+	return nil
+}
+
+// 去掉指针与接口，空值原样返回
+func indirect(v reflect.Value) reflect.Value {
+	for (v.Kind() == reflect.Ptr || v.Kind() == reflect.Interface) && !v.IsNil() {
+		v = v.Elem()
+	}
+	return v
+}
+
+// 值的 64 位 FNV-1a 摘要，JSON 相同的值摘要相同
+// 映射的各项摘要相加，与遍历顺序无关；结构体只计入导出的字段
+const (
+	hashOffset = 14695981039346656037
+	hashPrime  = 1099511628211
+)
+
+type hasher uint64
+
+func (h *hasher) byte(b byte) {
+	*h = (*h ^ hasher(b)) * hashPrime
+}
+
+func (h *hasher) uint64(n uint64) {
+	for i := 0; i < 8; i++ {
+		h.byte(byte(n >> (8 * i)))
+	}
+}
+
+func (h *hasher) string(s string) {
+	h.uint64(uint64(len(s)))
+	for i := 0; i < len(s); i++ {
+		h.byte(s[i])
+	}
+}
+
+func hashValue(v reflect.Value) uint64 {
+	h := hasher(hashOffset)
+	h.value(v)
+	return uint64(h)
+}
+
+func (h *hasher) value(v reflect.Value) {
+	if !v.IsValid() {
+		h.byte(0)
+		return
+	}
+	h.byte(byte(v.Kind()))
+	switch v.Kind() {
+	case reflect.Bool:
+		if v.Bool() {
+			h.byte(1)
+		} else {
+			h.byte(0)
+		}
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64:
+		h.uint64(uint64(v.Int()))
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32, reflect.Uint64, reflect.Uintptr:
+		h.uint64(v.Uint())
+	case reflect.Float32, reflect.Float64:
+		h.uint64(math.Float64bits(v.Float()))
+	case reflect.String:
+		h.string(v.String())
+	case reflect.Ptr, reflect.Interface:
+		if v.IsNil() {
+			h.byte(0)
+			return
+		}
+		h.byte(1)
+		h.value(v.Elem())
+	case reflect.Slice, reflect.Array:
+		if v.Kind() == reflect.Slice && v.IsNil() {
+			h.byte(0)
+			return
+		}
+		h.byte(1)
+		h.uint64(uint64(v.Len()))
+		for i := 0; i < v.Len(); i++ {
+			h.value(v.Index(i))
+		}
+	case reflect.Map:
+		if v.IsNil() {
+			h.byte(0)
+			return
+		}
+		h.byte(1)
+		h.uint64(uint64(v.Len()))
+		var sum uint64
+		iter := v.MapRange()
+		for iter.Next() {
+			entry := hasher(hashOffset)
+			entry.value(iter.Key())
+			entry.value(iter.Value())
+			sum += uint64(entry)
+		}
+		h.uint64(sum)
+	case reflect.Struct:
+		t := v.Type()
+		for i := 0; i < t.NumField(); i++ {
+			if t.Field(i).PkgPath == "" {
+				h.value(v.Field(i))
+			}
+		}
+	}
+}
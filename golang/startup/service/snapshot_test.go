@@ -0,0 +1,197 @@
+package service_test
+
+import (
+	"encoding/json"
+	"reflect"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/service"
+)
+
+type testClosureMap struct {
+	Closures [][]int `json:"closures"`
+	Edges    []int   `json:"edges"`
+}
+
+type testVariables struct {
+	LoopVariableI int                 `json:"loop_variable_i"`
+	Terminals     []string            `json:"terminals"`
+	ClosureMap    *testClosureMap     `json:"closure_map"`
+	ActionTable   []map[string]string `json:"action_table"`
+}
+
+// 模拟客户端：按增量更新本地的 JSON 对象
+func applyDelta(t *testing.T, state map[string]interface{}, delta map[string]interface{}) {
+	raw, _ := json.Marshal(delta)
+	var patch map[string]interface{}
+	json.Unmarshal(raw, &patch)
+	for key, value := range patch {
+		if key == "closure_map" {
+			if object, ok := value.(map[string]interface{}); ok && state[key] != nil {
+				current := state[key].(map[string]interface{})
+				for subkey, subvalue := range object {
+					current[subkey] = applyList(current[subkey], subvalue)
+				}
+				continue
+			}
+		}
+		state[key] = applyList(state[key], value)
+	}
+}
+
+func applyList(current interface{}, value interface{}) interface{} {
+	patch, ok := value.(map[string]interface{})
+	if !ok || patch["length"] == nil {
+		return value
+	}
+	list := current.([]interface{})
+	length := int(patch["length"].(float64))
+	for len(list) < length {
+		list = append(list, nil)
+	}
+	list = list[:length]
+	items := patch["items"].([]interface{})
+	for i, index := range patch["index"].([]interface{}) {
+		list[int(index.(float64))] = items[i]
+	}
+	return list
+}
+
+func checkState(t *testing.T, state map[string]interface{}, variables *testVariables) {
+	raw, _ := json.Marshal(variables)
+	var expect map[string]interface{}
+	json.Unmarshal(raw, &expect)
+	if !reflect.DeepEqual(state, expect) {
+		t.Fatalf("state mismatch:\n%v\n%v", state, expect)
+	}
+}
+
+func TestVariablesSnapshotDelta(t *testing.T) {
+	snapshot := service.NewVariablesSnapshot()
+	variables := &testVariables{Terminals: []string{"a", "b"}}
+	state := make(map[string]interface{})
+
+	delta, base, seq, err := snapshot.Delta(variables, 1, 0)
+	if err != nil || base != 0 || len(delta) != 4 {
+		t.Fatalf("first snapshot should be full: %v %v %v", delta, base, err)
+	}
+	applyDelta(t, state, delta)
+	checkState(t, state, variables)
+
+	variables.ClosureMap = &testClosureMap{Closures: [][]int{{1}}, Edges: []int{}}
+	for i := 0; i < 10; i++ {
+		variables.ClosureMap.Closures = append(variables.ClosureMap.Closures, []int{i})
+		variables.ActionTable = append(variables.ActionTable, map[string]string{"a": "s1"})
+	}
+	delta, base, seq, _ = snapshot.Delta(variables, 2, seq)
+	if base == 0 {
+		t.Fatal("expect incremental delta")
+	}
+	applyDelta(t, state, delta)
+	checkState(t, state, variables)
+
+	// 只修改一个闭包、追加一条边
+	variables.LoopVariableI = 3
+	variables.ClosureMap.Closures[4] = []int{4, 5}
+	variables.ClosureMap.Edges = append(variables.ClosureMap.Edges, 7)
+	delta, base, seq, _ = snapshot.Delta(variables, 3, seq)
+	if _, ok := delta["terminals"]; ok {
+		t.Fatal("unchanged field should be omitted")
+	}
+	if _, ok := delta["action_table"]; ok {
+		t.Fatal("unchanged list should be omitted")
+	}
+	patch := delta["closure_map"].(map[string]interface{})["closures"].(service.ListPatch)
+	if patch.Length != 11 || !reflect.DeepEqual(patch.Index, []int{4}) {
+		t.Fatalf("unexpected patch %v", patch)
+	}
+	applyDelta(t, state, delta)
+	checkState(t, state, variables)
+
+	// 基准不符时回退为完整快照
+	delta, base, _, _ = snapshot.Delta(variables, 3, seq-1)
+	if base != 0 || len(delta) != 4 {
+		t.Fatalf("stale base should yield full snapshot: %v", delta)
+	}
+}
+
+func TestVariablesSnapshotVersion(t *testing.T) {
+	snapshot := service.NewVariablesSnapshot()
+	variables := &testVariables{Terminals: []string{"a"}}
+	prepared := 0
+	prepare := func() (interface{}, error) {
+		prepared++
+		return variables, nil
+	}
+
+	// 同一埋点版本只准备一次
+	snapshot.Prepare(1, true, prepare)
+	snapshot.Prepare(1, true, prepare)
+	if prepared != 1 {
+		t.Fatalf("expect cached variables, prepared %d times", prepared)
+	}
+	snapshot.Prepare(1, false, prepare)
+	variables.LoopVariableI = 1
+	current, _ := snapshot.Prepare(2, false, prepare)
+	if prepared != 3 {
+		t.Fatalf("new version should be prepared again: %d", prepared)
+	}
+
+	// 版本不变时增量为空且序号不变
+	_, _, seq, _ := snapshot.Delta(current, 2, 0)
+	delta, base, next, _ := snapshot.Delta(current, 2, seq)
+	if len(delta) != 0 || base != seq || next != seq {
+		t.Fatalf("same version should be empty: %v %d %d", delta, base, next)
+	}
+}
+
+// 同一版本、同一负载编码的变量只编码一次
+func TestVariablesSnapshotEncodePrepared(t *testing.T) {
+	snapshot := service.NewVariablesSnapshot()
+	variables := &testVariables{LoopVariableI: 1}
+	prepare := func() (interface{}, error) {
+		return variables, nil
+	}
+	loop := func(encoded service.Encoded) int {
+		raw, _ := json.Marshal(encoded)
+		var decoded testVariables
+		json.Unmarshal(raw, &decoded)
+		return decoded.LoopVariableI
+	}
+	snapshot.Prepare(1, false, prepare)
+	first, _ := snapshot.EncodePrepared()
+	variables.LoopVariableI = 2
+	if encoded, _ := snapshot.EncodePrepared(); loop(encoded) != 1 {
+		t.Fatalf("same version should reuse encoded bytes")
+	}
+	service.SetEncoding(true)
+	encoded, _ := snapshot.EncodePrepared()
+	service.SetEncoding(false)
+	if !encoded.CBOR || first.CBOR {
+		t.Fatalf("encoding change should encode again")
+	}
+	snapshot.Prepare(2, false, prepare)
+	if encoded, _ := snapshot.EncodePrepared(); loop(encoded) != 2 {
+		t.Fatalf("new version should encode again")
+	}
+}
+
+// 变量原地修改后仍能发现变化，映射的遍历顺序不影响比较
+func TestVariablesSnapshotInPlace(t *testing.T) {
+	snapshot := service.NewVariablesSnapshot()
+	variables := &testVariables{ActionTable: make([]map[string]string, 4)}
+	for i := range variables.ActionTable {
+		variables.ActionTable[i] = map[string]string{"a": "s1", "b": "s2", "c": "r1", "d": "acc"}
+	}
+	_, _, seq, _ := snapshot.Delta(variables, 1, 0)
+	delta, _, seq, _ := snapshot.Delta(variables, 2, seq)
+	if len(delta) != 0 {
+		t.Fatalf("unchanged variables should be omitted: %v", delta)
+	}
+	variables.ActionTable[2]["b"] = "r2"
+	delta, _, _, _ = snapshot.Delta(variables, 3, seq)
+	patch, ok := delta["action_table"].(service.ListPatch)
+	if !ok || !reflect.DeepEqual(patch.Index, []int{2}) {
+		t.Fatalf("expect changed row 2: %v", delta)
+	}
+}
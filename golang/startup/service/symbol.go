@@ -0,0 +1,199 @@
+package service
+
+import (
+	"fmt"
+	"reflect"
+	"strconv"
+
+	"github.com/chushi0/graduation_project/golang/startup/production/process"
+)
+
+// 会话内的符号表
+// LR 断点变量中项目的向前看符号、转移边上的符号与分析表的列以编号发送，
+// 符号名只在首次出现后随响应发送一次
+type SymbolTable struct {
+	Names []string
+	ids   map[string]int
+}
+
+type internedItem struct {
+	Prod      int  `json:"prod"`
+	Progress  int  `json:"progress"`
+	Lookahead *int `json:"lookahead,omitempty"`
+}
+
+type internedEdge struct {
+	From   int `json:"from"`
+	To     int `json:"to"`
+	Symbol int `json:"symbol"`
+}
+
+func NewSymbolTable() *SymbolTable {
+	return &SymbolTable{
+		Names: make([]string, 0),
+		ids:   make(map[string]int),
+	}
+}
+
+func (table *SymbolTable) Intern(name string) int {
+	if id, ok := table.ids[name]; ok {
+		return id
+	}
+	id := len(table.Names)
+	table.Names = append(table.Names, name)
+	table.ids[name] = id
+	return id
+}
+
+// 客户端已持有前 known 个符号，返回其后新增的符号
+func (table *SymbolTable) Since(known int) []string {
+	if known < 0 {
+		known = 0
+	}
+	if known > len(table.Names) {
+		known = len(table.Names)
+	}
+	return table.Names[known:]
+}
+
+// 将 LR 断点变量中的符号替换为编号，其余字段原样引用
+func (table *SymbolTable) InternLRVariables(variables interface{}) (map[string]interface{}, error) {
+	fields := variableFields(reflect.ValueOf(variables))
+	if fields == nil {
+		return nil, fmt.Errorf("intern: unsupported variables %T", variables)
+	}
+	res := make(map[string]interface{}, len(fields))
+	for _, field := range fields {
+		res[field.name] = field.value.Interface()
+	}
+	// 先登记文法中的符号，使编号与文法顺序一致
+	var actionTable []map[string]string
+	var gotoTable []map[string]int
+	switch variables := variables.(type) {
+	case *process.LR1Variables:
+		table.internNames(variables.Terminals)
+		table.internNames(variables.NonterminalOrders)
+		if closureMap := variables.ClosureMap; closureMap != nil {
+			closures := make([][]internedItem, len(closureMap.Closures))
+			for i, closure := range closureMap.Closures {
+				closures[i] = table.internClosure(closure)
+			}
+			edges := make([]internedEdge, len(closureMap.Edges))
+			for i, edge := range closureMap.Edges {
+				edges[i] = internedEdge{edge.From, edge.To, table.Intern(edge.Symbol)}
+			}
+			res["closure_map"] = map[string]interface{}{
+				"closures": closures,
+				"edges":    edges,
+			}
+		}
+		if variables.CurrentClosure != nil {
+			res["current_closure"] = table.internClosure(variables.CurrentClosure)
+		}
+		actionTable, gotoTable = variables.ActionTable, variables.GotoTable
+	case *process.LR0Variables:
+		// LR(0) 项目没有向前看符号，只替换边上的符号
+		table.internNames(variables.Terminals)
+		table.internNames(variables.NonterminalOrders)
+		if closureMap := variables.ClosureMap; closureMap != nil {
+			edges := make([]internedEdge, len(closureMap.Edges))
+			for i, edge := range closureMap.Edges {
+				edges[i] = internedEdge{edge.From, edge.To, table.Intern(edge.Symbol)}
+			}
+			res["closure_map"] = map[string]interface{}{
+				"closures": closureMap.Closures,
+				"edges":    edges,
+			}
+		}
+		actionTable, gotoTable = variables.ActionTable, variables.GotoTable
+	default:
+		return nil, fmt.Errorf("intern: unsupported variables %T", variables)
+	}
+	if actionTable != nil {
+		res["action_table"] = table.internActionTable(actionTable)
+	}
+	if gotoTable != nil {
+		res["goto_table"] = table.internGotoTable(gotoTable)
+	}
+	return res, nil
+}
+
+// 退出结果中的 variables 同样以编号发送
+func (table *SymbolTable) InternLRExitResult(result interface{}) (map[string]interface{}, error) {
+	var code int
+	var variables interface{}
+	switch result := result.(type) {
+	case *process.LR1Result:
+		code = result.Code
+		if result.Variables != nil {
+			variables = result.Variables
+		}
+	case *process.LR0Result:
+		code = result.Code
+		if result.Variables != nil {
+			variables = result.Variables
+		}
+	default:
+		return nil, fmt.Errorf("intern: unsupported result %T", result)
+	}
+	res := map[string]interface{}{"code": code, "variables": nil}
+	if variables != nil {
+		interned, err := table.InternLRVariables(variables)
+		if err != nil {
+			return nil, err
+		}
+		res["variables"] = interned
+	}
+	return res, nil
+}
+
+func (table *SymbolTable) internNames(names []string) {
+	for _, name := range names {
+		table.Intern(name)
+	}
+}
+
+// 空闭包仍为 null
+func (table *SymbolTable) internClosure(closure *process.LR1ItemClosure) []internedItem {
+	if closure == nil || *closure == nil {
+		return nil
+	}
+	res := make([]internedItem, len(*closure))
+	for i, item := range *closure {
+		if item == nil {
+			continue
+		}
+		id := table.Intern(item.Lookahead)
+		res[i] = internedItem{Prod: item.Prod, Progress: item.Progress, Lookahead: &id}
+	}
+	return res
+}
+
+// 分析表的列名替换为符号编号；JSON 对象的键只能是字符串，编号以十进制表示
+func (table *SymbolTable) internActionTable(rows []map[string]string) []map[string]string {
+	res := make([]map[string]string, len(rows))
+	for i, row := range rows {
+		if row == nil {
+			continue
+		}
+		res[i] = make(map[string]string, len(row))
+		for symbol, action := range row {
+			res[i][strconv.Itoa(table.Intern(symbol))] = action
+		}
+	}
+	return res
+}
+
+func (table *SymbolTable) internGotoTable(rows []map[string]int) []map[string]int {
+	res := make([]map[string]int, len(rows))
+	for i, row := range rows {
+		if row == nil {
+			continue
+		}
+		res[i] = make(map[string]int, len(row))
+		for symbol, state := range row {
+			res[i][strconv.Itoa(table.Intern(symbol))] = state
+		}
+	}
+	return res
+}
@@ -0,0 +1,107 @@
+package service_test
+
+import (
+	"encoding/json"
+	"reflect"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/production/process"
+	"github.com/chushi0/graduation_project/golang/startup/service"
+)
+
+func TestSymbolTableInternLRVariables(t *testing.T) {
+	lookahead := "$"
+	variables := &process.LR1Variables{
+		Terminals:         []string{"a", "b"},
+		NonterminalOrders: []string{"S"},
+		ClosureMap: &process.LR1ItemClosureMap{
+			Closures: []*process.LR1ItemClosure{{&process.LR1Item{Prod: 0, Progress: 1, Lookahead: lookahead}}},
+			Edges:    []*process.LR1ItemClosureMapEdge{{From: 0, To: 1, Symbol: "b"}},
+		},
+		ActionTable: []map[string]string{{"a": "s1", "$": "acc"}},
+		GotoTable:   []map[string]int{{"S": 1}},
+	}
+	table := service.NewSymbolTable()
+	interned, err := table.InternLRVariables(variables)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if !reflect.DeepEqual(table.Names, []string{"a", "b", "S", "$"}) {
+		t.Fatalf("unexpected symbols %v", table.Names)
+	}
+
+	raw, _ := json.Marshal(interned)
+	var res struct {
+		Terminals  []string `json:"terminals"`
+		ClosureMap struct {
+			Closures [][]struct {
+				Lookahead int `json:"lookahead"`
+			} `json:"closures"`
+			Edges []struct {
+				Symbol int `json:"symbol"`
+			} `json:"edges"`
+		} `json:"closure_map"`
+		ActionTable []map[string]string `json:"action_table"`
+		GotoTable   []map[string]int    `json:"goto_table"`
+	}
+	if err = json.Unmarshal(raw, &res); err != nil {
+		t.Fatal(err)
+	}
+	if !reflect.DeepEqual(res.Terminals, []string{"a", "b"}) {
+		t.Fatalf("terminals should stay as names: %v", res.Terminals)
+	}
+	if res.ClosureMap.Closures[0][0].Lookahead != 3 || res.ClosureMap.Edges[0].Symbol != 1 {
+		t.Fatalf("unexpected closure map %s", raw)
+	}
+	if !reflect.DeepEqual(res.ActionTable[0], map[string]string{"0": "s1", "3": "acc"}) {
+		t.Fatalf("unexpected action table %v", res.ActionTable)
+	}
+	if !reflect.DeepEqual(res.GotoTable[0], map[string]int{"2": 1}) {
+		t.Fatalf("unexpected goto table %v", res.GotoTable)
+	}
+
+	if len(table.Since(2)) != 2 || len(table.Since(10)) != 0 {
+		t.Fatal("unexpected symbols since")
+	}
+}
+
+func TestSymbolTableInternLRExitResult(t *testing.T) {
+	variables := &process.LR0Variables{
+		Terminals: []string{"a"},
+		ClosureMap: &process.LR0ItemClosureMap{
+			Closures: []*process.LR0ItemClosure{{&process.LR0Item{Prod: 0, Progress: 1}}},
+			Edges:    []*process.LR0ItemClosureMapEdge{{From: 0, To: 1, Symbol: "S"}},
+		},
+	}
+	table := service.NewSymbolTable()
+	result, err := table.InternLRExitResult(&process.LR0Result{Code: 3, Variables: variables})
+	if err != nil {
+		t.Fatal(err)
+	}
+	raw, _ := json.Marshal(result)
+	var res struct {
+		Code      int `json:"code"`
+		Variables struct {
+			ClosureMap struct {
+				Closures [][]map[string]int `json:"closures"`
+				Edges    []map[string]int   `json:"edges"`
+			} `json:"closure_map"`
+			ActionTable []map[string]string `json:"action_table"`
+		} `json:"variables"`
+	}
+	if err = json.Unmarshal(raw, &res); err != nil {
+		t.Fatal(err)
+	}
+	closureMap := res.Variables.ClosureMap
+	if res.Code != 3 || closureMap.Edges[0]["symbol"] != 1 || closureMap.Closures[0][0]["progress"] != 1 {
+		t.Fatalf("unexpected exit result %s", raw)
+	}
+	if res.Variables.ActionTable != nil {
+		t.Fatalf("nil table should stay null: %s", raw)
+	}
+
+	result, _ = table.InternLRExitResult(&process.LR1Result{Code: 1})
+	if raw, _ = json.Marshal(result); string(raw) != `{"code":1,"variables":null}` {
+		t.Fatalf("unexpected empty result %s", raw)
+	}
+}
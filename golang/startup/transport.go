@@ -0,0 +1,308 @@
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"compress/zlib"
+	"encoding/binary"
+	"encoding/json"
+	"fmt"
+	"io"
+	"log"
+	"strconv"
+
+	"github.com/chushi0/graduation_project/golang/startup/service"
+	"github.com/chushi0/graduation_project/golang/startup/util/cbor"
+	"github.com/chushi0/graduation_project/golang/startup/util/shm"
+)
+
+// 传输方式
+// 默认使用按行分隔的 JSON，客户端协商后切换为长度前缀帧
+type rpcTransport struct {
+	Framed      bool      // 是否使用长度前缀帧
+	Encoding    string    // 负载编码：json 或 cbor
+	Ring        *shm.Ring // 共享内存文件，为空时不启用
+	Compression string    // 帧压缩算法，为空时不压缩
+
+	compressBuf    bytes.Buffer
+	compressWriter *zlib.Writer
+}
+
+const (
+	transportLine = "line"
+	transportJSON = "json"
+	transportCBOR = "cbor"
+	compressZlib  = "zlib"
+
+	// 帧头部：4 字节大端序的负载长度
+	frameHeaderSize = 4
+	// 单帧负载上限
+	frameMaxSize = 1 << 30
+	// 超过该大小的响应经共享内存传输 data 字段
+	sharedMemoryThreshold = 64 << 10
+	// 帧头部的最高位表示负载经过压缩
+	frameCompressedFlag = 1 << 31
+	// 超过该大小的帧压缩后发送
+	compressThreshold = 8 << 10
+)
+
+// 协商请求
+type negotiateRequest struct {
+	Action string `json:"action"`
+	Data   struct {
+		Encodings []string `json:"encodings"`
+		// 客户端创建并映射的共享内存文件，仅在帧传输时启用
+		SharedMemory *struct {
+			Path string `json:"path"`
+			Size int64  `json:"size"`
+		} `json:"shm"`
+		// 客户端能够解压的算法，仅在帧传输时启用
+		Compression []string `json:"compression"`
+	} `json:"data"`
+}
+
+// 读取一行（不含换行符），跳过空行
+func readLine(buf *bufio.Reader) ([]byte, error) {
+	for {
+		body := make([]byte, 0)
+		for {
+			line, isPrefix, err := buf.ReadLine()
+			if err != nil {
+				return nil, err
+			}
+			body = append(body, line...)
+			if !isPrefix {
+				break
+			}
+		}
+		if len(body) > 0 {
+			return body, nil
+		}
+	}
+}
+
+// 传输协商
+// 客户端第一行发送 ipc_negotiate 请求，列出支持的编码；服务端按 allow 选择一种回复后双方切换为帧传输
+// 若第一条消息不是协商请求，保持按行传输，并将该消息作为普通请求返回
+func negotiateTransport(in *bufio.Reader, out *bufio.Writer, allow string, allowSharedMemory bool, allowCompression bool) (*rpcTransport, []byte, error) {
+	line, err := readLine(in)
+	if err != nil {
+		return nil, nil, err
+	}
+	var req negotiateRequest
+	if json.Unmarshal(line, &req) != nil || req.Action != "ipc_negotiate" {
+		return &rpcTransport{}, line, nil
+	}
+	transport := &rpcTransport{Encoding: transportJSON}
+	if allow != transportLine {
+		transport.Framed = true
+		for _, encoding := range req.Data.Encodings {
+			if encoding == allow {
+				transport.Encoding = encoding
+				break
+			}
+		}
+		if allowSharedMemory && req.Data.SharedMemory != nil {
+			transport.Ring, err = shm.Open(req.Data.SharedMemory.Path, req.Data.SharedMemory.Size)
+			if err != nil {
+				log.Printf("rpc shared memory unavailable: %v", err)
+			}
+		}
+		if allowCompression {
+			for _, compression := range req.Data.Compression {
+				if compression == compressZlib {
+					transport.Compression = compression
+					break
+				}
+			}
+		}
+	}
+	var resp struct {
+		Code int `json:"code"`
+		Data struct {
+			Framed       bool   `json:"framed"`
+			Encoding     string `json:"encoding"`
+			SharedMemory bool   `json:"shm"`
+			Compression  string `json:"compression"`
+		} `json:"data"`
+	}
+	resp.Data.Framed = transport.Framed
+	resp.Data.Encoding = transport.Encoding
+	resp.Data.SharedMemory = transport.Ring != nil
+	resp.Data.Compression = transport.Compression
+	rawResp, _ := json.Marshal(resp)
+	if _, err := out.Write(append(rawResp, '\n')); err != nil {
+		return nil, nil, err
+	}
+	return transport, nil, out.Flush()
+}
+
+// 读取一条消息，返回 JSON 格式的内容
+func (t *rpcTransport) ReadMessage(in *bufio.Reader) ([]byte, error) {
+	if !t.Framed {
+		return readLine(in)
+	}
+	var header [frameHeaderSize]byte
+	if _, err := io.ReadFull(in, header[:]); err != nil {
+		return nil, err
+	}
+	length := binary.BigEndian.Uint32(header[:])
+	if length > frameMaxSize {
+		return nil, fmt.Errorf("frame too large: %d", length)
+	}
+	body := make([]byte, length)
+	if _, err := io.ReadFull(in, body); err != nil {
+		return nil, err
+	}
+	if t.Encoding == transportCBOR {
+		return cbor.ToJSON(body)
+	}
+	return body, nil
+}
+
+// 写入一条消息：JSON 格式的 []byte（事件等较小的消息），或服务的响应
+// 响应的 data 按负载编码直接编码一次，较大时写入共享内存
+func (t *rpcTransport) WriteMessage(out *bufio.Writer, msg interface{}) error {
+	var body []byte
+	var err error
+	switch msg := msg.(type) {
+	case *service.Response:
+		body, err = t.encodeResponse(msg)
+	case []byte:
+		body = msg
+		if t.Framed && t.Encoding == transportCBOR {
+			body, err = cbor.FromJSON(msg)
+		}
+	default:
+		err = fmt.Errorf("unknown message %T", msg)
+	}
+	if err != nil {
+		return err
+	}
+	if !t.Framed {
+		if _, err := out.Write(body); err != nil {
+			return err
+		}
+		if err := out.WriteByte('\n'); err != nil {
+			return err
+		}
+		return out.Flush()
+	}
+	length := uint32(len(body))
+	if compressed, ok := t.compress(body); ok {
+		body = compressed
+		length = uint32(len(body)) | frameCompressedFlag
+	}
+	var header [frameHeaderSize]byte
+	binary.BigEndian.PutUint32(header[:], length)
+	if _, err := out.Write(header[:]); err != nil {
+		return err
+	}
+	if _, err := out.Write(body); err != nil {
+		return err
+	}
+	return out.Flush()
+}
+
+// 已按 CBOR 编码的值
+type cborRaw []byte
+
+func (raw cborRaw) MarshalCBOR() ([]byte, error) {
+	return raw, nil
+}
+
+func (t *rpcTransport) encodeResponse(resp *service.Response) ([]byte, error) {
+	cborEncoding := t.Framed && t.Encoding == transportCBOR
+	var data []byte
+	var err error
+	if encoded, ok := resp.Data.(service.Encoded); ok && encoded.CBOR == cborEncoding {
+		// 服务已在持有会话锁时编码
+		data = encoded.Bytes
+	} else if cborEncoding {
+		data, err = cbor.Marshal(resp.Data)
+	} else {
+		data, err = json.Marshal(resp.Data)
+	}
+	if err != nil {
+		return nil, err
+	}
+	if ref, ok := t.offload(data); ok {
+		// data 在共享内存中，信封以 shm_ref 代替 data，与任何 data 的内容都不冲突
+		envelope := &sharedMemoryResponse{Code: resp.Code, Ref: ref, ID: resp.ID}
+		if cborEncoding {
+			return cbor.Marshal(envelope)
+		}
+		return json.Marshal(envelope)
+	}
+	if cborEncoding {
+		return cbor.Marshal(&service.Response{Code: resp.Code, Data: cborRaw(data), ID: resp.ID})
+	}
+	// 与 json.Marshal(resp) 相同，但不再扫描已编码的 data
+	body := make([]byte, 0, len(data)+len(resp.ID)+32)
+	body = append(body, `{"code":`...)
+	body = strconv.AppendInt(body, int64(resp.Code), 10)
+	body = append(body, `,"data":`...)
+	body = append(body, data...)
+	if len(resp.ID) > 0 {
+		body = append(body, `,"id":`...)
+		body = append(body, resp.ID...)
+	}
+	return append(body, '}'), nil
+}
+
+// 压缩较大的帧负载，格式与 qCompress 相同：4 字节大端序的原长度，随后为 zlib 数据
+// 未协商压缩、负载较小或压缩后没有变小时返回 false
+func (t *rpcTransport) compress(msg []byte) ([]byte, bool) {
+	if t.Compression != compressZlib || len(msg) < compressThreshold {
+		return nil, false
+	}
+	t.compressBuf.Reset()
+	var size [4]byte
+	binary.BigEndian.PutUint32(size[:], uint32(len(msg)))
+	t.compressBuf.Write(size[:])
+	if t.compressWriter == nil {
+		t.compressWriter, _ = zlib.NewWriterLevel(&t.compressBuf, zlib.BestSpeed)
+	} else {
+		t.compressWriter.Reset(&t.compressBuf)
+	}
+	if _, err := t.compressWriter.Write(msg); err != nil {
+		return nil, false
+	}
+	if err := t.compressWriter.Close(); err != nil {
+		return nil, false
+	}
+	if t.compressBuf.Len() >= len(msg) {
+		return nil, false
+	}
+	return t.compressBuf.Bytes(), true
+}
+
+// data 经共享内存传输的响应
+type sharedMemoryResponse struct {
+	Code int              `json:"code"`
+	Ref  *sharedMemoryRef `json:"shm_ref"`
+	ID   json.RawMessage  `json:"id,omitempty"`
+}
+
+type sharedMemoryRef struct {
+	Offset int64  `json:"offset"`
+	Length int    `json:"length"`
+	End    uint64 `json:"end"`
+}
+
+// 较大的 data 写入共享内存，消息中只保留其位置
+// 共享内存空间不足或写入失败时返回 false，data 直接传输
+func (t *rpcTransport) offload(data []byte) (*sharedMemoryRef, bool) {
+	if t.Ring == nil || len(data) < sharedMemoryThreshold {
+		return nil, false
+	}
+	offset, end, ok, err := t.Ring.Write(data)
+	if err != nil {
+		log.Printf("rpc shared memory write fail: %v", err)
+		return nil, false
+	}
+	if !ok {
+		return nil, false
+	}
+	return &sharedMemoryRef{Offset: offset, Length: len(data), End: end}, true
+}
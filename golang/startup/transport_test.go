@@ -0,0 +1,115 @@
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/binary"
+	"encoding/json"
+	"io/ioutil"
+	"os"
+	"strings"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/service"
+	"github.com/chushi0/graduation_project/golang/startup/util/cbor"
+	"github.com/chushi0/graduation_project/golang/startup/util/shm"
+)
+
+// 直接编码的响应与先编码为 JSON 再转码的结果一致
+func TestWriteResponse(t *testing.T) {
+	resp := &service.Response{
+		Code: 0,
+		Data: map[string]interface{}{"var": map[string][]int{"b": {1, 2}, "a": nil}, "point": "lr1.go:10"},
+		ID:   json.RawMessage(`12`),
+	}
+	raw, err := json.Marshal(resp)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, encoding := range []string{transportJSON, transportCBOR} {
+		transport := &rpcTransport{Framed: true, Encoding: encoding}
+		var buf bytes.Buffer
+		out := bufio.NewWriter(&buf)
+		if err := transport.WriteMessage(out, resp); err != nil {
+			t.Fatal(err)
+		}
+		frame := buf.Bytes()
+		if int(binary.BigEndian.Uint32(frame)) != len(frame)-frameHeaderSize {
+			t.Fatalf("%s: bad frame header", encoding)
+		}
+		expect := raw
+		if encoding == transportCBOR {
+			expect, _ = cbor.FromJSON(raw)
+		}
+		if !bytes.Equal(frame[frameHeaderSize:], expect) {
+			t.Fatalf("%s: %x, expect %x", encoding, frame[frameHeaderSize:], expect)
+		}
+	}
+}
+
+// 协商启用共享内存后，较大的 data 按编码后的字节写入共享内存，不再重新编码整个响应
+// 协商响应中的 shm 只表示是否启用；数据的位置以信封的 shm_ref 传输，不出现在 data 中
+func TestWriteResponseSharedMemory(t *testing.T) {
+	file, err := ioutil.TempFile("", "transport-test-*")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.Remove(file.Name())
+	size := int64(shm.HeaderSize + 4*sharedMemoryThreshold)
+	file.Truncate(size)
+	file.Close()
+
+	negotiate, _ := json.Marshal(map[string]interface{}{
+		"action": "ipc_negotiate",
+		"data": map[string]interface{}{
+			"encodings": []string{transportCBOR, transportJSON},
+			"shm":       map[string]interface{}{"path": file.Name(), "size": size},
+		},
+	})
+	var reply bytes.Buffer
+	in := bufio.NewReader(bytes.NewReader(append(negotiate, '\n')))
+	transport, _, err := negotiateTransport(in, bufio.NewWriter(&reply), transportCBOR, true, false)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if transport.Ring == nil {
+		t.Fatal("shared memory not enabled")
+	}
+	defer transport.Ring.Close()
+	var negotiated map[string]interface{}
+	json.Unmarshal(reply.Bytes(), &negotiated)
+	if data, _ := negotiated["data"].(map[string]interface{}); data["shm"] != true {
+		t.Fatalf("unexpected negotiate reply %s", reply.Bytes())
+	}
+	if _, ok := negotiated["shm_ref"]; ok {
+		t.Fatalf("negotiate reply carries a shared memory reference: %s", reply.Bytes())
+	}
+
+	service.SetEncoding(true)
+	defer service.SetEncoding(false)
+	encoded, err := service.Encode(strings.Repeat("x", sharedMemoryThreshold))
+	if err != nil {
+		t.Fatal(err)
+	}
+	var buf bytes.Buffer
+	out := bufio.NewWriter(&buf)
+	if err := transport.WriteMessage(out, &service.Response{Data: encoded, ID: json.RawMessage(`1`)}); err != nil {
+		t.Fatal(err)
+	}
+	raw, err := cbor.ToJSON(buf.Bytes()[frameHeaderSize:])
+	if err != nil {
+		t.Fatal(err)
+	}
+	var resp struct {
+		Data json.RawMessage  `json:"data"`
+		Ref  *sharedMemoryRef `json:"shm_ref"`
+	}
+	json.Unmarshal(raw, &resp)
+	if resp.Data != nil || resp.Ref == nil || resp.Ref.Length != len(encoded.Bytes) {
+		t.Fatalf("unexpected reference %s", raw)
+	}
+	content, _ := ioutil.ReadFile(file.Name())
+	if !bytes.Equal(content[resp.Ref.Offset:resp.Ref.Offset+int64(resp.Ref.Length)], encoded.Bytes) {
+		t.Fatal("shared memory content mismatch")
+	}
+}
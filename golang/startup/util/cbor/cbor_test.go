@@ -0,0 +1,183 @@
+package cbor_test
+
+import (
+	"bytes"
+	"encoding/json"
+	"reflect"
+	"strings"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/util/cbor"
+)
+
+func roundTrip(t *testing.T, input string) {
+	encoded, err := cbor.FromJSON([]byte(input))
+	if err != nil {
+		t.Fatalf("FromJSON(%s): %v", input, err)
+	}
+	decoded, err := cbor.ToJSON(encoded)
+	if err != nil {
+		t.Fatalf("ToJSON(%s): %v", input, err)
+	}
+	var expect, actual interface{}
+	if err := json.Unmarshal([]byte(input), &expect); err != nil {
+		t.Fatal(err)
+	}
+	if err := json.Unmarshal(decoded, &actual); err != nil {
+		t.Fatalf("invalid json %s: %v", decoded, err)
+	}
+	if !reflect.DeepEqual(expect, actual) {
+		t.Fatalf("round trip mismatch: %s != %s", input, decoded)
+	}
+}
+
+func TestRoundTrip(t *testing.T) {
+	roundTrip(t, `{"code":0,"data":{"id":"abc","list":[1,-2,3.5,true,false,null]}}`)
+	roundTrip(t, `"<&\"\\\n😀中文"`)
+	roundTrip(t, `[18446744073709551615,-9223372036854775808,1e300,-0.25]`)
+	roundTrip(t, ` { "a" : [ ] , "b" : { } } `)
+
+	long := make([]string, 0)
+	for i := 0; i < 70000; i++ {
+		long = append(long, `{"prod":1,"progress":2,"lookahead":"$"}`)
+	}
+	roundTrip(t, `{"closures":[`+strings.Join(long, ",")+`]}`)
+}
+
+func TestEncoding(t *testing.T) {
+	cases := map[string][]byte{
+		`0`:          {0x00},
+		`23`:         {0x17},
+		`24`:         {0x18, 0x18},
+		`-1`:         {0x20},
+		`-500`:       {0x39, 0x01, 0xf3},
+		`"a"`:        {0x61, 'a'},
+		`[1,[2,3]]`:  {0x82, 0x01, 0x82, 0x02, 0x03},
+		`{"a":true}`: {0xa1, 0x61, 'a', 0xf5},
+	}
+	for input, expect := range cases {
+		actual, err := cbor.FromJSON([]byte(input))
+		if err != nil {
+			t.Fatalf("FromJSON(%s): %v", input, err)
+		}
+		if !bytes.Equal(actual, expect) {
+			t.Fatalf("FromJSON(%s) = %x, expect %x", input, actual, expect)
+		}
+	}
+}
+
+func TestIndefiniteLength(t *testing.T) {
+	// [_ 1, {_ "a": (_ "b" "c")}]
+	input := []byte{0x9f, 0x01, 0xbf, 0x61, 'a', 0x7f, 0x61, 'b', 0x61, 'c', 0xff, 0xff, 0xff}
+	actual, err := cbor.ToJSON(input)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if string(actual) != `[1,{"a":"bc"}]` {
+		t.Fatalf("unexpected %s", actual)
+	}
+}
+
+func TestInvalidInput(t *testing.T) {
+	for _, input := range []string{``, `{`, `[1,]`, `{"a"}`, `"abc`, `tru`, `[1 2]`} {
+		if _, err := cbor.FromJSON([]byte(input)); err == nil {
+			t.Fatalf("FromJSON(%s) should fail", input)
+		}
+	}
+	if _, err := cbor.ToJSON([]byte{0x82, 0x01}); err == nil {
+		t.Fatal("truncated array should fail")
+	}
+}
+
+type marshalItem struct {
+	Prod      int    `json:"prod"`
+	Lookahead string `json:"lookahead"`
+}
+
+type marshalEmbedded struct {
+	Version int `json:"version"`
+}
+
+type marshalVariables struct {
+	*marshalEmbedded
+	Loop     int                    `json:"loop_variable_i"`
+	Flag     bool                   `json:"modified_flag"`
+	Skip     string                 `json:"-"`
+	Empty    []string               `json:"empty,omitempty"`
+	Terms    []string               `json:"terminals"`
+	Nil      []int                  `json:"nil"`
+	Items    []*marshalItem         `json:"items"`
+	Table    map[int]map[int]string `json:"action_table"`
+	Any      map[string]interface{} `json:"any"`
+	Raw      json.RawMessage        `json:"raw"`
+	Bytes    []byte                 `json:"bytes"`
+	Float    float64                `json:"float"`
+	Array    [2]float32             `json:"array"`
+	Pointer  *marshalItem           `json:"pointer"`
+	Unnamed  int
+	hidden   int
+	Interned map[string]json.RawMessage `json:"interned,omitempty"`
+}
+
+func TestMarshal(t *testing.T) {
+	values := []interface{}{
+		nil, true, 0, -1, -25, 1 << 40, uint64(1<<64 - 1), 1.5, 3.0, -0.0, 1e21, 1e300,
+		"", "中文 <tag> \"quote\"\n", "bad \xff\xfe utf8",
+		[]int{1, 2, 3}, map[string]int{"b": 2, "a": 1},
+		marshalVariables{},
+		marshalVariables{
+			marshalEmbedded: &marshalEmbedded{Version: 3},
+			Loop:            -1,
+			Flag:            true,
+			Skip:            "skip",
+			Terms:           []string{"a", "b", "$"},
+			Items:           []*marshalItem{{0, "$"}, nil, {2, "a"}},
+			Table:           map[int]map[int]string{10: {2: "s1"}, 2: {0: "r1", 11: "acc"}},
+			Any:             map[string]interface{}{"list": []interface{}{1.0, "x", nil}, "n": 2.5},
+			Raw:             json.RawMessage(`{ "z" : [1, 2.0] , "a":null }`),
+			Bytes:           []byte("bytes"),
+			Float:           0.1,
+			Array:           [2]float32{0.1, 2},
+			Pointer:         &marshalItem{1, "b"},
+			Unnamed:         7,
+			hidden:          8,
+			Interned:        map[string]json.RawMessage{"k": json.RawMessage(`"v"`)},
+		},
+	}
+	for _, value := range values {
+		raw, err := json.Marshal(value)
+		if err != nil {
+			t.Fatal(err)
+		}
+		expect, err := cbor.FromJSON(raw)
+		if err != nil {
+			t.Fatal(err)
+		}
+		actual, err := cbor.Marshal(value)
+		if err != nil {
+			t.Fatalf("Marshal(%s): %v", raw, err)
+		}
+		if !bytes.Equal(expect, actual) {
+			t.Fatalf("Marshal(%s) = %x, expect %x", raw, actual, expect)
+		}
+	}
+}
+
+type marshalEncoded []byte
+
+func (encoded marshalEncoded) MarshalCBOR() ([]byte, error) {
+	return encoded, nil
+}
+
+func TestMarshalEncoded(t *testing.T) {
+	actual, err := cbor.Marshal(map[string]interface{}{"data": marshalEncoded{0x01}})
+	if err != nil {
+		t.Fatal(err)
+	}
+	if !bytes.Equal(actual, []byte{0xa1, 0x64, 'd', 'a', 't', 'a', 0x01}) {
+		t.Fatalf("unexpected %x", actual)
+	}
+	if _, err := cbor.Marshal(func() {}); err == nil {
+		t.Fatal("func should fail")
+	}
+}
@@ -0,0 +1,244 @@
+package cbor
+
+import (
+	"encoding/base64"
+	"encoding/json"
+	"errors"
+	"math"
+	"strconv"
+)
+
+var ErrorMalformed = errors.New("cbor: malformed input")
+
+// 解码器状态
+type decoder struct {
+	in    []byte
+	pos   int
+	out   []byte
+	depth int
+}
+
+// 最大嵌套深度，防止恶意输入耗尽栈空间
+const maxDepth = 1000
+
+// 将 CBOR 转码为 JSON
+// 字节串按 base64url 输出为字符串，标签被忽略，与 QCborValue::toJsonValue 的行为一致
+func ToJSON(data []byte) ([]byte, error) {
+	dec := &decoder{
+		in:  data,
+		out: make([]byte, 0, len(data)*2),
+	}
+	if err := dec.value(); err != nil {
+		return nil, err
+	}
+	if dec.pos != len(dec.in) {
+		return nil, ErrorMalformed
+	}
+	return dec.out, nil
+}
+
+// 读取类型头部
+// 返回主类型、附加信息与参数值
+func (dec *decoder) head() (major byte, info byte, n uint64, err error) {
+	if dec.pos >= len(dec.in) {
+		return 0, 0, 0, ErrorMalformed
+	}
+	b := dec.in[dec.pos]
+	dec.pos++
+	major, info = b&0xe0, b&0x1f
+	var size int
+	switch {
+	case info < 24:
+		return major, info, uint64(info), nil
+	case info == 24:
+		size = 1
+	case info == 25:
+		size = 2
+	case info == 26:
+		size = 4
+	case info == 27:
+		size = 8
+	case info == infoIndefinite:
+		return major, info, 0, nil
+	default:
+		return 0, 0, 0, ErrorMalformed
+	}
+	if len(dec.in)-dec.pos < size {
+		return 0, 0, 0, ErrorMalformed
+	}
+	for i := 0; i < size; i++ {
+		n = n<<8 | uint64(dec.in[dec.pos+i])
+	}
+	dec.pos += size
+	return major, info, n, nil
+}
+
+func (dec *decoder) isBreak() bool {
+	if dec.pos < len(dec.in) && dec.in[dec.pos] == simpleBreak {
+		dec.pos++
+		return true
+	}
+	return false
+}
+
+func (dec *decoder) value() error {
+	dec.depth++
+	defer func() { dec.depth-- }()
+	if dec.depth > maxDepth {
+		return ErrorMalformed
+	}
+	major, info, n, err := dec.head()
+	if err != nil {
+		return err
+	}
+	switch major {
+	case majorUnsigned:
+		dec.out = strconv.AppendUint(dec.out, n, 10)
+	case majorNegative:
+		if n > math.MaxInt64 {
+			dec.out = strconv.AppendFloat(dec.out, -1-float64(n), 'g', -1, 64)
+		} else {
+			dec.out = strconv.AppendInt(dec.out, -1-int64(n), 10)
+		}
+	case majorBytes, majorText:
+		str, err := dec.chunks(major, info, n)
+		if err != nil {
+			return err
+		}
+		if major == majorBytes {
+			str = []byte(base64.RawURLEncoding.EncodeToString(str))
+		}
+		quoted, _ := json.Marshal(string(str))
+		dec.out = append(dec.out, quoted...)
+	case majorArray:
+		dec.out = append(dec.out, '[')
+		for i := uint64(0); info == infoIndefinite || i < n; i++ {
+			if info == infoIndefinite && dec.isBreak() {
+				break
+			}
+			if i > 0 {
+				dec.out = append(dec.out, ',')
+			}
+			if err := dec.value(); err != nil {
+				return err
+			}
+		}
+		dec.out = append(dec.out, ']')
+	case majorMap:
+		dec.out = append(dec.out, '{')
+		for i := uint64(0); info == infoIndefinite || i < n; i++ {
+			if info == infoIndefinite && dec.isBreak() {
+				break
+			}
+			if i > 0 {
+				dec.out = append(dec.out, ',')
+			}
+			if err := dec.key(); err != nil {
+				return err
+			}
+			dec.out = append(dec.out, ':')
+			if err := dec.value(); err != nil {
+				return err
+			}
+		}
+		dec.out = append(dec.out, '}')
+	case majorTag:
+		return dec.value()
+	case majorSimple:
+		return dec.simple(info, n)
+	}
+	return nil
+}
+
+// 对象的键：JSON 只允许字符串，非字符串的键转为其 JSON 文本
+func (dec *decoder) key() error {
+	if dec.pos < len(dec.in) && dec.in[dec.pos]&0xe0 == majorText {
+		return dec.value()
+	}
+	start := len(dec.out)
+	if err := dec.value(); err != nil {
+		return err
+	}
+	quoted, _ := json.Marshal(string(dec.out[start:]))
+	dec.out = append(dec.out[:start], quoted...)
+	return nil
+}
+
+// 读取（可能分段的）字符串内容
+func (dec *decoder) chunks(major byte, info byte, n uint64) ([]byte, error) {
+	if info != infoIndefinite {
+		if uint64(len(dec.in)-dec.pos) < n {
+			return nil, ErrorMalformed
+		}
+		str := dec.in[dec.pos : dec.pos+int(n)]
+		dec.pos += int(n)
+		return str, nil
+	}
+	res := make([]byte, 0)
+	for !dec.isBreak() {
+		chunkMajor, chunkInfo, chunkLen, err := dec.head()
+		if err != nil {
+			return nil, err
+		}
+		if chunkMajor != major || chunkInfo == infoIndefinite {
+			return nil, ErrorMalformed
+		}
+		chunk, err := dec.chunks(major, chunkInfo, chunkLen)
+		if err != nil {
+			return nil, err
+		}
+		res = append(res, chunk...)
+	}
+	return res, nil
+}
+
+func (dec *decoder) simple(info byte, n uint64) error {
+	var f float64
+	switch majorSimple | info {
+	case simpleFalse:
+		dec.out = append(dec.out, "false"...)
+		return nil
+	case simpleTrue:
+		dec.out = append(dec.out, "true"...)
+		return nil
+	case simpleFloat16:
+		f = float16(uint16(n))
+	case simpleFloat32:
+		f = float64(math.Float32frombits(uint32(n)))
+	case simpleFloat64:
+		f = math.Float64frombits(n)
+	default:
+		// null、undefined 以及其他简单值
+		dec.out = append(dec.out, "null"...)
+		return nil
+	}
+	if math.IsNaN(f) || math.IsInf(f, 0) {
+		dec.out = append(dec.out, "null"...)
+		return nil
+	}
+	dec.out = strconv.AppendFloat(dec.out, f, 'g', -1, 64)
+	return nil
+}
+
+// 半精度浮点数
+func float16(bits uint16) float64 {
+	exp := int(bits>>10) & 0x1f
+	mant := float64(bits & 0x3ff)
+	var val float64
+	switch exp {
+	case 0:
+		val = math.Ldexp(mant, -24)
+	case 0x1f:
+		if mant == 0 {
+			val = math.Inf(1)
+		} else {
+			val = math.NaN()
+		}
+	default:
+		val = math.Ldexp(mant+1024, exp-25)
+	}
+	if bits&0x8000 != 0 {
+		return -val
+	}
+	return val
+}
@@ -0,0 +1,366 @@
+package cbor
+
+import (
+	"encoding/binary"
+	"errors"
+	"math"
+	"strconv"
+	"unicode/utf16"
+	"unicode/utf8"
+)
+
+// CBOR (RFC 8949) 与 JSON 之间的转码
+// 只处理 JSON 可以表达的子集：整数、浮点数、字符串、数组、对象、布尔值与 null
+
+const (
+	majorUnsigned byte = 0 << 5
+	majorNegative byte = 1 << 5
+	majorBytes    byte = 2 << 5
+	majorText     byte = 3 << 5
+	majorArray    byte = 4 << 5
+	majorMap      byte = 5 << 5
+	majorTag      byte = 6 << 5
+	majorSimple   byte = 7 << 5
+
+	simpleFalse   byte = 0xf4
+	simpleTrue    byte = 0xf5
+	simpleNull    byte = 0xf6
+	simpleFloat16 byte = 0xf9
+	simpleFloat32 byte = 0xfa
+	simpleFloat64 byte = 0xfb
+	simpleBreak   byte = 0xff
+
+	infoIndefinite byte = 31
+)
+
+var ErrorSyntax = errors.New("cbor: invalid json input")
+
+// 编码器状态
+type encoder struct {
+	in  []byte
+	pos int
+	out []byte
+}
+
+// 将 JSON 转码为 CBOR
+// 数组与对象使用定长头部，整数使用最短编码
+func FromJSON(data []byte) ([]byte, error) {
+	enc := &encoder{
+		in:  data,
+		out: make([]byte, 0, len(data)),
+	}
+	enc.skipSpace()
+	if err := enc.value(); err != nil {
+		return nil, err
+	}
+	enc.skipSpace()
+	if enc.pos != len(enc.in) {
+		return nil, ErrorSyntax
+	}
+	return enc.out, nil
+}
+
+// 写入类型头部
+func appendHead(out []byte, major byte, n uint64) []byte {
+	switch {
+	case n < 24:
+		return append(out, major|byte(n))
+	case n <= math.MaxUint8:
+		return append(out, major|24, byte(n))
+	case n <= math.MaxUint16:
+		return append(out, major|25, byte(n>>8), byte(n))
+	case n <= math.MaxUint32:
+		return append(out, major|26, byte(n>>24), byte(n>>16), byte(n>>8), byte(n))
+	}
+	out = append(out, major|27)
+	return appendUint64(out, n)
+}
+
+func appendUint64(out []byte, n uint64) []byte {
+	var buf [8]byte
+	binary.BigEndian.PutUint64(buf[:], n)
+	return append(out, buf[:]...)
+}
+
+// 头部所需字节数
+func headSize(n uint64) int {
+	switch {
+	case n < 24:
+		return 1
+	case n <= math.MaxUint8:
+		return 2
+	case n <= math.MaxUint16:
+		return 3
+	case n <= math.MaxUint32:
+		return 5
+	}
+	return 9
+}
+
+func (enc *encoder) skipSpace() {
+	for enc.pos < len(enc.in) {
+		switch enc.in[enc.pos] {
+		case ' ', '\t', '\r', '\n':
+			enc.pos++
+		default:
+			return
+		}
+	}
+}
+
+func (enc *encoder) value() error {
+	if enc.pos >= len(enc.in) {
+		return ErrorSyntax
+	}
+	switch c := enc.in[enc.pos]; {
+	case c == '{':
+		return enc.container('}', majorMap)
+	case c == '[':
+		return enc.container(']', majorArray)
+	case c == '"':
+		return enc.text()
+	case c == 't':
+		return enc.literal("true", simpleTrue)
+	case c == 'f':
+		return enc.literal("false", simpleFalse)
+	case c == 'n':
+		return enc.literal("null", simpleNull)
+	case c == '-' || (c >= '0' && c <= '9'):
+		return enc.number()
+	}
+	return ErrorSyntax
+}
+
+func (enc *encoder) literal(word string, simple byte) error {
+	if len(enc.in)-enc.pos < len(word) || string(enc.in[enc.pos:enc.pos+len(word)]) != word {
+		return ErrorSyntax
+	}
+	enc.pos += len(word)
+	enc.out = append(enc.out, simple)
+	return nil
+}
+
+// 数组与对象
+// 先预留 1 字节头部，元素个数确定后如有需要再后移内容
+func (enc *encoder) container(end byte, major byte) error {
+	enc.pos++
+	head := len(enc.out)
+	enc.out = append(enc.out, 0)
+	count := uint64(0)
+	enc.skipSpace()
+	if enc.pos < len(enc.in) && enc.in[enc.pos] == end {
+		enc.pos++
+		enc.out[head] = major
+		return nil
+	}
+	for {
+		enc.skipSpace()
+		if major == majorMap {
+			if enc.pos >= len(enc.in) || enc.in[enc.pos] != '"' {
+				return ErrorSyntax
+			}
+			if err := enc.text(); err != nil {
+				return err
+			}
+			enc.skipSpace()
+			if enc.pos >= len(enc.in) || enc.in[enc.pos] != ':' {
+				return ErrorSyntax
+			}
+			enc.pos++
+			enc.skipSpace()
+		}
+		if err := enc.value(); err != nil {
+			return err
+		}
+		count++
+		enc.skipSpace()
+		if enc.pos >= len(enc.in) {
+			return ErrorSyntax
+		}
+		if enc.in[enc.pos] == ',' {
+			enc.pos++
+			continue
+		}
+		if enc.in[enc.pos] != end {
+			return ErrorSyntax
+		}
+		enc.pos++
+		break
+	}
+	if size := headSize(count); size > 1 {
+		body := len(enc.out) - head - 1
+		enc.out = append(enc.out, make([]byte, size-1)...)
+		copy(enc.out[head+size:], enc.out[head+1:head+1+body])
+	}
+	appendHead(enc.out[head:head], major, count)
+	return nil
+}
+
+// 字符串
+// 无转义字符时直接复制，否则逐个解码转义序列
+func (enc *encoder) text() error {
+	enc.pos++
+	start := enc.pos
+	escaped := false
+	for {
+		if enc.pos >= len(enc.in) {
+			return ErrorSyntax
+		}
+		c := enc.in[enc.pos]
+		if c == '"' {
+			break
+		}
+		if c == '\\' {
+			escaped = true
+			enc.pos++
+		}
+		enc.pos++
+	}
+	raw := enc.in[start:enc.pos]
+	enc.pos++
+	if !escaped {
+		enc.out = appendHead(enc.out, majorText, uint64(len(raw)))
+		enc.out = append(enc.out, raw...)
+		return nil
+	}
+	str, ok := unquote(raw)
+	if !ok {
+		return ErrorSyntax
+	}
+	enc.out = appendHead(enc.out, majorText, uint64(len(str)))
+	enc.out = append(enc.out, str...)
+	return nil
+}
+
+func unquote(raw []byte) ([]byte, bool) {
+	res := make([]byte, 0, len(raw))
+	for i := 0; i < len(raw); i++ {
+		c := raw[i]
+		if c != '\\' {
+			res = append(res, c)
+			continue
+		}
+		i++
+		if i >= len(raw) {
+			return nil, false
+		}
+		switch raw[i] {
+		case '"', '\\', '/':
+			res = append(res, raw[i])
+		case 'b':
+			res = append(res, '\b')
+		case 'f':
+			res = append(res, '\f')
+		case 'n':
+			res = append(res, '\n')
+		case 'r':
+			res = append(res, '\r')
+		case 't':
+			res = append(res, '\t')
+		case 'u':
+			r, ok := hex4(raw[i+1:])
+			if !ok {
+				return nil, false
+			}
+			i += 4
+			if utf16.IsSurrogate(r) {
+				r2, ok := rune(0), false
+				if i+2 < len(raw) && raw[i+1] == '\\' && raw[i+2] == 'u' {
+					r2, ok = hex4(raw[i+3:])
+				}
+				if ok {
+					r = utf16.DecodeRune(r, r2)
+					i += 6
+				} else {
+					r = utf8.RuneError
+				}
+			}
+			var buf [utf8.UTFMax]byte
+			res = append(res, buf[:utf8.EncodeRune(buf[:], r)]...)
+		default:
+			return nil, false
+		}
+	}
+	return res, true
+}
+
+func hex4(b []byte) (rune, bool) {
+	if len(b) < 4 {
+		return 0, false
+	}
+	v, err := strconv.ParseUint(string(b[:4]), 16, 16)
+	if err != nil {
+		return 0, false
+	}
+	return rune(v), true
+}
+
+// 数字
+// 能用 64 位整数表示的数字编码为整数，其余编码为双精度浮点数
+func (enc *encoder) number() error {
+	start := enc.pos
+	isFloat := false
+	for enc.pos < len(enc.in) {
+		c := enc.in[enc.pos]
+		if c >= '0' && c <= '9' || c == '-' || c == '+' {
+			enc.pos++
+			continue
+		}
+		if c == '.' || c == 'e' || c == 'E' {
+			isFloat = true
+			enc.pos++
+			continue
+		}
+		break
+	}
+	if !isFloat && enc.pos-start <= 18 {
+		// 短整数直接累加，避免构造字符串
+		if v, negative, ok := parseShortInt(enc.in[start:enc.pos]); ok {
+			if negative && v > 0 {
+				enc.out = appendHead(enc.out, majorNegative, v-1)
+			} else {
+				enc.out = appendHead(enc.out, majorUnsigned, v)
+			}
+			return nil
+		}
+	}
+	raw := string(enc.in[start:enc.pos])
+	if !isFloat {
+		if v, err := strconv.ParseInt(raw, 10, 64); err == nil {
+			if v >= 0 {
+				enc.out = appendHead(enc.out, majorUnsigned, uint64(v))
+			} else {
+				enc.out = appendHead(enc.out, majorNegative, uint64(-1-v))
+			}
+			return nil
+		}
+		if v, err := strconv.ParseUint(raw, 10, 64); err == nil {
+			enc.out = appendHead(enc.out, majorUnsigned, v)
+			return nil
+		}
+	}
+	f, err := strconv.ParseFloat(raw, 64)
+	if err != nil {
+		return ErrorSyntax
+	}
+	enc.out = append(enc.out, simpleFloat64)
+	enc.out = appendUint64(enc.out, math.Float64bits(f))
+	return nil
+}
+
+func parseShortInt(raw []byte) (v uint64, negative bool, ok bool) {
+	if len(raw) > 0 && raw[0] == '-' {
+		negative = true
+		raw = raw[1:]
+	}
+	if len(raw) == 0 {
+		return 0, false, false
+	}
+	for _, c := range raw {
+		if c < '0' || c > '9' {
+			return 0, false, false
+		}
+		v = v*10 + uint64(c-'0')
+	}
+	return v, negative, true
+}
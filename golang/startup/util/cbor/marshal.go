@@ -0,0 +1,352 @@
+package cbor
+
+import (
+	"encoding"
+	"encoding/base64"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"math"
+	"reflect"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"unicode/utf8"
+)
+
+// 不经 JSON 直接将 Go 值编码为 CBOR
+// 规则与 encoding/json 相同，结果与 FromJSON(json.Marshal(v)) 逐字节一致：
+// 结构体字段按 json 标签命名并支持 omitempty 与 "-"，映射的键排序，
+// 实现 json.Marshaler 的值经 FromJSON 转码
+
+// 已编码的值实现该接口时原样写入
+type Marshaler interface {
+	MarshalCBOR() ([]byte, error)
+}
+
+var ErrorUnsupported = errors.New("cbor: unsupported value")
+
+var (
+	marshalerType     = reflect.TypeOf((*Marshaler)(nil)).Elem()
+	jsonMarshalerType = reflect.TypeOf((*json.Marshaler)(nil)).Elem()
+	textMarshalerType = reflect.TypeOf((*encoding.TextMarshaler)(nil)).Elem()
+)
+
+func Marshal(v interface{}) ([]byte, error) {
+	out, err := appendValue(make([]byte, 0, 256), reflect.ValueOf(v))
+	if err != nil {
+		return nil, err
+	}
+	return out, nil
+}
+
+// 结构体字段，按 encoding/json 的顺序展开匿名结构体
+type structField struct {
+	name      string
+	index     []int
+	omitEmpty bool
+}
+
+var structFields sync.Map // reflect.Type -> []structField
+
+func fieldsOf(t reflect.Type) []structField {
+	if cached, ok := structFields.Load(t); ok {
+		return cached.([]structField)
+	}
+	fields := collectFields(t, nil)
+	structFields.Store(t, fields)
+	return fields
+}
+
+func collectFields(t reflect.Type, index []int) []structField {
+	fields := make([]structField, 0, t.NumField())
+	for i := 0; i < t.NumField(); i++ {
+		f := t.Field(i)
+		tag := f.Tag.Get("json")
+		if tag == "-" {
+			continue
+		}
+		name, options := tag, ""
+		if comma := strings.IndexByte(tag, ','); comma >= 0 {
+			name, options = tag[:comma], tag[comma+1:]
+		}
+		fieldIndex := append(append([]int{}, index...), i)
+		if f.Anonymous && name == "" {
+			ft := f.Type
+			if ft.Kind() == reflect.Ptr {
+				ft = ft.Elem()
+			}
+			if ft.Kind() == reflect.Struct {
+				fields = append(fields, collectFields(ft, fieldIndex)...)
+				continue
+			}
+		}
+		if f.PkgPath != "" {
+			continue
+		}
+		if name == "" {
+			name = f.Name
+		}
+		fields = append(fields, structField{
+			name:      name,
+			index:     fieldIndex,
+			omitEmpty: strings.Contains(","+options+",", ",omitempty,"),
+		})
+	}
+	return fields
+}
+
+// 展开匿名指针字段；指针为空时该字段不存在
+func fieldByIndex(v reflect.Value, index []int) (reflect.Value, bool) {
+	for i, x := range index {
+		if i > 0 && v.Kind() == reflect.Ptr {
+			if v.IsNil() {
+				return reflect.Value{}, false
+			}
+			v = v.Elem()
+		}
+		v = v.Field(x)
+	}
+	return v, true
+}
+
+func isEmptyValue(v reflect.Value) bool {
+	switch v.Kind() {
+	case reflect.Array, reflect.Map, reflect.Slice, reflect.String:
+		return v.Len() == 0
+	case reflect.Bool:
+		return !v.Bool()
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64:
+		return v.Int() == 0
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32, reflect.Uint64, reflect.Uintptr:
+		return v.Uint() == 0
+	case reflect.Float32, reflect.Float64:
+		return v.Float() == 0
+	case reflect.Interface, reflect.Ptr:
+		return v.IsNil()
+	}
+	return false
+}
+
+// 只有指针实现编码接口时，可寻址的值按指针编码，与 encoding/json 一致
+func addrMarshaler(t reflect.Type) bool {
+	pt := reflect.PtrTo(t)
+	return pt.Implements(marshalerType) && !t.Implements(marshalerType) ||
+		pt.Implements(jsonMarshalerType) && !t.Implements(jsonMarshalerType) ||
+		pt.Implements(textMarshalerType) && !t.Implements(textMarshalerType)
+}
+
+// 与 encoding/json 相同，每个非法字节替换为 U+FFFD
+func appendText(out []byte, s string) []byte {
+	if !utf8.ValidString(s) {
+		var valid strings.Builder
+		for i := 0; i < len(s); {
+			r, size := utf8.DecodeRuneInString(s[i:])
+			if r == utf8.RuneError && size == 1 {
+				valid.WriteString("\ufffd")
+			} else {
+				valid.WriteString(s[i : i+size])
+			}
+			i += size
+		}
+		s = valid.String()
+	}
+	out = appendHead(out, majorText, uint64(len(s)))
+	return append(out, s...)
+}
+
+func appendInt(out []byte, n int64) []byte {
+	if n >= 0 {
+		return appendHead(out, majorUnsigned, uint64(n))
+	}
+	return appendHead(out, majorNegative, uint64(-1-n))
+}
+
+// 与 encoding/json 相同地格式化后按 FromJSON 的规则编码：不含小数点与指数的数字编码为整数
+func appendFloat(out []byte, f float64, bits int) ([]byte, error) {
+	if math.IsNaN(f) || math.IsInf(f, 0) {
+		return nil, fmt.Errorf("cbor: unsupported float %v", f)
+	}
+	abs := math.Abs(f)
+	if abs < 1e21 && f == math.Trunc(f) {
+		if abs <= math.MaxInt64 {
+			return appendInt(out, int64(f)), nil
+		}
+		return appendHead(out, majorUnsigned, uint64(f)), nil
+	}
+	if bits == 32 {
+		f, _ = strconv.ParseFloat(strconv.FormatFloat(f, 'g', -1, 32), 64)
+	}
+	out = append(out, simpleFloat64)
+	return appendUint64(out, math.Float64bits(f)), nil
+}
+
+func appendValue(out []byte, v reflect.Value) ([]byte, error) {
+	if !v.IsValid() {
+		return append(out, simpleNull), nil
+	}
+	t := v.Type()
+	if t.Kind() != reflect.Ptr && v.CanAddr() && addrMarshaler(t) {
+		v = v.Addr()
+		t = v.Type()
+	}
+	if t.Implements(marshalerType) {
+		if v.Kind() == reflect.Ptr && v.IsNil() {
+			return append(out, simpleNull), nil
+		}
+		raw, err := v.Interface().(Marshaler).MarshalCBOR()
+		if err != nil {
+			return nil, err
+		}
+		return append(out, raw...), nil
+	}
+	if t.Implements(jsonMarshalerType) {
+		if (v.Kind() == reflect.Ptr || v.Kind() == reflect.Interface) && v.IsNil() {
+			return append(out, simpleNull), nil
+		}
+		raw, err := v.Interface().(json.Marshaler).MarshalJSON()
+		if err != nil {
+			return nil, err
+		}
+		encoded, err := FromJSON(raw)
+		if err != nil {
+			return nil, err
+		}
+		return append(out, encoded...), nil
+	}
+	if t.Implements(textMarshalerType) {
+		if v.Kind() == reflect.Ptr && v.IsNil() {
+			return append(out, simpleNull), nil
+		}
+		text, err := v.Interface().(encoding.TextMarshaler).MarshalText()
+		if err != nil {
+			return nil, err
+		}
+		return appendText(out, string(text)), nil
+	}
+
+	switch v.Kind() {
+	case reflect.Bool:
+		if v.Bool() {
+			return append(out, simpleTrue), nil
+		}
+		return append(out, simpleFalse), nil
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64:
+		return appendInt(out, v.Int()), nil
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32, reflect.Uint64, reflect.Uintptr:
+		return appendHead(out, majorUnsigned, v.Uint()), nil
+	case reflect.Float32:
+		return appendFloat(out, v.Float(), 32)
+	case reflect.Float64:
+		return appendFloat(out, v.Float(), 64)
+	case reflect.String:
+		return appendText(out, v.String()), nil
+	case reflect.Interface, reflect.Ptr:
+		if v.IsNil() {
+			return append(out, simpleNull), nil
+		}
+		return appendValue(out, v.Elem())
+	case reflect.Slice:
+		if v.IsNil() {
+			return append(out, simpleNull), nil
+		}
+		if t.Elem().Kind() == reflect.Uint8 && !reflect.PtrTo(t.Elem()).Implements(jsonMarshalerType) {
+			// 与 encoding/json 相同，字节切片编码为 base64 字符串
+			return appendText(out, base64.StdEncoding.EncodeToString(v.Bytes())), nil
+		}
+		fallthrough
+	case reflect.Array:
+		n := v.Len()
+		out = appendHead(out, majorArray, uint64(n))
+		var err error
+		for i := 0; i < n; i++ {
+			if out, err = appendValue(out, v.Index(i)); err != nil {
+				return nil, err
+			}
+		}
+		return out, nil
+	case reflect.Map:
+		if v.IsNil() {
+			return append(out, simpleNull), nil
+		}
+		return appendMap(out, v)
+	case reflect.Struct:
+		return appendStruct(out, v)
+	}
+	return nil, fmt.Errorf("%w: %v", ErrorUnsupported, t)
+}
+
+type mapEntry struct {
+	key   string
+	value reflect.Value
+}
+
+// 键按字符串排序，与 encoding/json 一致
+func appendMap(out []byte, v reflect.Value) ([]byte, error) {
+	entries := make([]mapEntry, 0, v.Len())
+	iter := v.MapRange()
+	for iter.Next() {
+		key, err := mapKey(iter.Key())
+		if err != nil {
+			return nil, err
+		}
+		entries = append(entries, mapEntry{key, iter.Value()})
+	}
+	sort.Slice(entries, func(i, j int) bool {
+		return entries[i].key < entries[j].key
+	})
+	out = appendHead(out, majorMap, uint64(len(entries)))
+	var err error
+	for _, entry := range entries {
+		out = appendText(out, entry.key)
+		if out, err = appendValue(out, entry.value); err != nil {
+			return nil, err
+		}
+	}
+	return out, nil
+}
+
+func mapKey(k reflect.Value) (string, error) {
+	if k.Kind() == reflect.String {
+		return k.String(), nil
+	}
+	if k.Type().Implements(textMarshalerType) {
+		if k.Kind() == reflect.Ptr && k.IsNil() {
+			return "", nil
+		}
+		text, err := k.Interface().(encoding.TextMarshaler).MarshalText()
+		return string(text), err
+	}
+	switch k.Kind() {
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64:
+		return strconv.FormatInt(k.Int(), 10), nil
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32, reflect.Uint64, reflect.Uintptr:
+		return strconv.FormatUint(k.Uint(), 10), nil
+	}
+	return "", fmt.Errorf("%w: map key %v", ErrorUnsupported, k.Type())
+}
+
+// 字段数在写出前确定：先跳过 omitempty 的空字段
+func appendStruct(out []byte, v reflect.Value) ([]byte, error) {
+	fields := fieldsOf(v.Type())
+	values := make([]reflect.Value, 0, len(fields))
+	names := make([]string, 0, len(fields))
+	for _, f := range fields {
+		fv, ok := fieldByIndex(v, f.index)
+		if !ok || f.omitEmpty && isEmptyValue(fv) {
+			continue
+		}
+		values = append(values, fv)
+		names = append(names, f.name)
+	}
+	out = appendHead(out, majorMap, uint64(len(values)))
+	var err error
+	for i, fv := range values {
+		out = appendText(out, names[i])
+		if out, err = appendValue(out, fv); err != nil {
+			return nil, err
+		}
+	}
+	return out, nil
+}
@@ -1,6 +1,7 @@
 package set_test
 
 import (
+	"encoding/json"
 	"testing"
 
 	"github.com/chushi0/graduation_project/golang/startup/util/set"
@@ -25,3 +26,18 @@ func TestSet(t *testing.T) {
 		t.Fail()
 	}
 }
+
+func TestStringSetJSON(t *testing.T) {
+	s := set.NewStringSet("b", "a", "")
+	raw, err := json.Marshal(s)
+	if err != nil || string(raw) != `["","a","b"]` {
+		t.Fatalf("marshal: %s %v", raw, err)
+	}
+	var sets map[string]set.StringSet
+	if err := json.Unmarshal([]byte(`{"S":`+string(raw)+`}`), &sets); err != nil {
+		t.Fatal(err)
+	}
+	if !sets["S"].Equals(s) {
+		t.Fatalf("unmarshal: %v", sets)
+	}
+}
@@ -90,3 +90,12 @@ func (s StringSet) MarshalJSON() ([]byte, error) {
 	sort.Strings(arr)
 	return json.Marshal(arr)
 }
+
+func (s *StringSet) UnmarshalJSON(data []byte) error {
+	var arr []string
+	if err := json.Unmarshal(data, &arr); err != nil {
+		return err
+	}
+	*s = NewStringSet(arr...)
+	return nil
+}
@@ -0,0 +1,90 @@
+package shm
+
+import (
+	"encoding/binary"
+	"errors"
+	"os"
+)
+
+// 基于文件映射的环形缓冲区
+// 客户端创建并映射文件，后端打开时映射同一文件，之后经映射写入数据块，双方共享同一组物理页
+// 文件头部：[0,8) 后端的写入位置，[8,16) 客户端已读取到的位置，均为小端序的累计字节数
+// 数据块的位置经管道随响应发送，客户端收到响应时数据块已写入
+type Ring struct {
+	data     []byte // 映射的整个文件
+	capacity uint64
+	writePos uint64
+}
+
+const (
+	HeaderSize     = 64
+	WritePosOffset = 0
+	ReadPosOffset  = 8
+)
+
+var ErrorTooSmall = errors.New("shm: file too small")
+
+// 打开并映射客户端创建的共享文件
+// 映射建立后即关闭文件句柄，映射保持有效直到 Close
+// Windows 上映射存在时文件不能删除，客户端退出时后端随之退出并解除映射
+func Open(path string, size int64) (*Ring, error) {
+	if size <= HeaderSize {
+		return nil, ErrorTooSmall
+	}
+	file, err := os.OpenFile(path, os.O_RDWR, 0)
+	if err != nil {
+		return nil, err
+	}
+	defer file.Close()
+	info, err := file.Stat()
+	if err != nil {
+		return nil, err
+	}
+	if info.Size() < size {
+		return nil, ErrorTooSmall
+	}
+	data, err := mapFile(file, int(size))
+	if err != nil {
+		return nil, err
+	}
+	return &Ring{
+		data:     data,
+		capacity: uint64(size - HeaderSize),
+	}, nil
+}
+
+// 解除映射，之后不能再写入
+func (r *Ring) Close() error {
+	data := r.data
+	r.data = nil
+	return unmapFile(data)
+}
+
+// 写入一个数据块，返回其在文件中的偏移，以及客户端读取完成后应标记的读取位置
+// 剩余空间不足时 ok 为 false，调用方应改为直接传输
+func (r *Ring) Write(blob []byte) (offset int64, end uint64, ok bool, err error) {
+	n := uint64(len(blob))
+	if n > r.capacity {
+		return 0, 0, false, nil
+	}
+	if r.data == nil {
+		return 0, 0, false, os.ErrClosed
+	}
+	readPos := binary.LittleEndian.Uint64(r.data[ReadPosOffset:])
+	if readPos > r.writePos {
+		readPos = r.writePos
+	}
+	// 数据块不跨越缓冲区末尾，放不下时从头部开始
+	pos := r.writePos
+	if pos%r.capacity+n > r.capacity {
+		pos += r.capacity - pos%r.capacity
+	}
+	if pos+n-readPos > r.capacity {
+		return 0, 0, false, nil
+	}
+	offset = int64(HeaderSize + pos%r.capacity)
+	copy(r.data[offset:], blob)
+	r.writePos = pos + n
+	binary.LittleEndian.PutUint64(r.data[WritePosOffset:], r.writePos)
+	return offset, r.writePos, true, nil
+}
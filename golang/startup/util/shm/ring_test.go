@@ -0,0 +1,87 @@
+package shm_test
+
+import (
+	"bytes"
+	"encoding/binary"
+	"io/ioutil"
+	"os"
+	"testing"
+
+	"github.com/chushi0/graduation_project/golang/startup/util/shm"
+)
+
+func createFile(t *testing.T, size int64) string {
+	file, err := ioutil.TempFile("", "shm-test-*")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer file.Close()
+	if err := file.Truncate(size); err != nil {
+		t.Fatal(err)
+	}
+	return file.Name()
+}
+
+// 模拟客户端读取数据块并标记读取位置
+func consume(t *testing.T, path string, offset int64, expect []byte, end uint64) {
+	content, err := ioutil.ReadFile(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if !bytes.Equal(content[offset:offset+int64(len(expect))], expect) {
+		t.Fatalf("unexpected content at %d", offset)
+	}
+	// 只写入读取位置，不截断文件：后端仍映射着该文件
+	file, err := os.OpenFile(path, os.O_RDWR, 0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer file.Close()
+	var header [8]byte
+	binary.LittleEndian.PutUint64(header[:], end)
+	if _, err := file.WriteAt(header[:], shm.ReadPosOffset); err != nil {
+		t.Fatal(err)
+	}
+}
+
+func TestRing(t *testing.T) {
+	path := createFile(t, shm.HeaderSize+100)
+	defer os.Remove(path)
+	ring, err := shm.Open(path, shm.HeaderSize+100)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer ring.Close()
+
+	a := bytes.Repeat([]byte{'a'}, 60)
+	offset, end, ok, err := ring.Write(a)
+	if err != nil || !ok || offset != shm.HeaderSize || end != 60 {
+		t.Fatalf("write a: %v %v %v %v", offset, end, ok, err)
+	}
+	// 未读取前空间不足
+	b := bytes.Repeat([]byte{'b'}, 50)
+	if _, _, ok, _ := ring.Write(b); ok {
+		t.Fatal("ring should be full")
+	}
+	consume(t, path, offset, a, end)
+
+	// 末尾放不下，从头部开始写入
+	offset, end, ok, err = ring.Write(b)
+	if err != nil || !ok || offset != shm.HeaderSize || end != 150 {
+		t.Fatalf("write b: %v %v %v %v", offset, end, ok, err)
+	}
+	consume(t, path, offset, b, end)
+
+	if _, _, ok, _ := ring.Write(make([]byte, 101)); ok {
+		t.Fatal("blob larger than ring should be rejected")
+	}
+
+	// 写入位置经映射写入文件头部
+	content, err := ioutil.ReadFile(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if binary.LittleEndian.Uint64(content[shm.WritePosOffset:]) != end {
+		t.Fatal("write position not visible in file")
+	}
+}